@@ -188,12 +188,26 @@ utils.h - various utility methods
 	//! \see xor_crypt.
 	std::string xor_crypt(std::string, uint32_t seed, uchar offset);
 
+	//! Returns the number of days from 1970-01-01 to the date \p year, \p month (1-12), \p day.
+	long long days_from_civil(int year, unsigned month, unsigned day);
+	//! Sets \p year, \p month (1-12) and \p day to the date \p days after 1970-01-01.
+	void civil_from_days(long long days, int& year, unsigned& month, unsigned& day);
+	//! Returns the UTC time of ADIF \p date (YYYYMMDD) and \p time (HHMM or HHMMSS): -1 if either is not valid.
+	std::time_t adif_to_time(const std::string& date, const std::string& time);
+	//! Returns the ADIF date (YYYYMMDD) of UTC time \p t.
+	std::string adif_date(std::time_t t);
+	//! Returns the ADIF time (HHMMSS) of UTC time \p t.
+	std::string adif_time(std::time_t t);
+
 	//! Convert ISO date-time format to time_t
 	std::time_t convert_iso_datetime(std::string value);
 
 	//! Convert ISO date-time format from time_t
 	std::string convert_iso_datetime(std::time_t t);
 
+	//! Flush the contents of \p filename to the storage device: returns false if this fails.
+	bool sync_file(const std::string& filename);
+
 	//! Returns the widget of class WIDGET that encloses \p w.
 	template <class WIDGET>
 	WIDGET* ancestor_view(Fl_Widget* w) {
@@ -10,6 +10,7 @@ utils.h - Utility methods
 
 #include <FL/fl_ask.H>
 #include <FL/fl_draw.H>
+#include <FL/fl_utf8.h>
 #include <FL/Fl_Multiline_Output.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/Fl_Window.H>
@@ -24,6 +25,12 @@ utils.h - Utility methods
 #include <chrono>
 #include <set>
 #include <random>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 
 // Split the line into its separate words with specified separator
@@ -266,11 +273,19 @@ std::string now(bool local, const char* format, bool add_ms) {
 
 	std::chrono::seconds s = std::chrono::duration_cast<std::chrono::seconds>(ms);
 	time_t t = s.count();
-	tm* now = local ? localtime(&t) : gmtime(&t);
+	// Use the re-entrant versions as this may be called from other threads
+	tm now;
+#ifdef _WIN32
+	if (local) localtime_s(&now, &t);
+	else gmtime_s(&now, &t);
+#else
+	if (local) localtime_r(&t, &now);
+	else gmtime_r(&t, &now);
+#endif
 	size_t fractional_seconds = ms.count() % 1000;
 
 	char result[128];
-	strftime(result, sizeof(result), format, now);
+	strftime(result, sizeof(result), format, &now);
 	if (add_ms) {
 		char ms[5];
 		snprintf(ms, sizeof(ms), ".%03d", (int)fractional_seconds);
@@ -1095,50 +1110,120 @@ std::string xor_crypt(std::string src, uint32_t seed, uchar offset) {
 	return result;
 }
 
+// Days from 1970-01-01 to the date - the proleptic Gregorian calendar counted in 400-year eras
+long long days_from_civil(int year, unsigned month, unsigned day) {
+	// Count the years from March so that the leap day is the last day of the year
+	long long y = (long long)year - (month <= 2 ? 1 : 0);
+	long long era = (y >= 0 ? y : y - 399) / 400;
+	unsigned year_of_era = (unsigned)(y - era * 400);
+	unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+	return era * 146097 + (long long)day_of_era - 719468;
+}
+
+// The date that is days after 1970-01-01 - the inverse of days_from_civil
+void civil_from_days(long long days, int& year, unsigned& month, unsigned& day) {
+	days += 719468;
+	long long era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned day_of_era = (unsigned)(days - era * 146097);
+	unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+	unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+	unsigned mp = (5 * day_of_year + 2) / 153;
+	day = day_of_year - (153 * mp + 2) / 5 + 1;
+	month = mp < 10 ? mp + 3 : mp - 9;
+	year = (int)((long long)year_of_era + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+// Returns the value of the count digits at text, or -1 if any is not a digit
+static int adif_digits(const char* text, int count) {
+	int value = 0;
+	for (int ix = 0; ix < count; ix++) {
+		if (text[ix] < '0' || text[ix] > '9') return -1;
+		value = value * 10 + (text[ix] - '0');
+	}
+	return value;
+}
+
+// Convert ADIF date and time to UTC time_t
+std::time_t adif_to_time(const std::string& date, const std::string& time) {
+	if (date.length() != 8 || (time.length() != 4 && time.length() != 6)) return -1;
+	int year = adif_digits(date.c_str(), 4);
+	int month = adif_digits(date.c_str() + 4, 2);
+	int day = adif_digits(date.c_str() + 6, 2);
+	int hour = adif_digits(time.c_str(), 2);
+	int minute = adif_digits(time.c_str() + 2, 2);
+	int second = time.length() == 6 ? adif_digits(time.c_str() + 4, 2) : 0;
+	if (year < 0 || month < 1 || month > 12 || day < 1 || day > 31 ||
+		hour < 0 || minute < 0 || second < 0) {
+		return -1;
+	}
+	long long days = days_from_civil(year, (unsigned)month, (unsigned)day);
+	return (std::time_t)(days * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+// Split UTC time_t into days since 1970-01-01 and seconds into the day
+static void split_time(std::time_t t, long long& days, int& seconds) {
+	days = (long long)t / 86400;
+	long long rem = (long long)t % 86400;
+	if (rem < 0) {
+		rem += 86400;
+		days--;
+	}
+	seconds = (int)rem;
+}
+
+// ADIF date YYYYMMDD of the UTC time
+std::string adif_date(std::time_t t) {
+	long long days;
+	int seconds;
+	split_time(t, days, seconds);
+	int year;
+	unsigned month;
+	unsigned day;
+	civil_from_days(days, year, month, day);
+	char result[16];
+	snprintf(result, sizeof(result), "%04d%02u%02u", year, month, day);
+	return std::string(result);
+}
+
+// ADIF time HHMMSS of the UTC time
+std::string adif_time(std::time_t t) {
+	long long days;
+	int seconds;
+	split_time(t, days, seconds);
+	char result[16];
+	snprintf(result, sizeof(result), "%02d%02d%02d", seconds / 3600, (seconds / 60) % 60, seconds % 60);
+	return std::string(result);
+}
+
 // Convert ISO date time format to time_t
 std::time_t convert_iso_datetime(std::string value) {
-	// Get resolution of time_t
-	time_t now;
-	time(&now);
-	time_t then = now + 1;
-	double resolution = difftime(then, now);
-
-	// YYY-MM-DDTHH:MM:SS+HH:MM
-	tm tv;
-	tv.tm_year = std::stoi(value.substr(0, 4)) - 1900;
-	tv.tm_mon = std::stoi(value.substr(5, 2)) - 1;
-	tv.tm_mday = std::stoi(value.substr(8, 2));
-	tv.tm_hour = std::stoi(value.substr(11, 2));
-	tv.tm_min = std::stoi(value.substr(14, 2));
-	tv.tm_sec = std::stoi(value.substr(17, 2));
-	tv.tm_isdst = false;
-#ifdef _WIN32
-	time_t result = _mkgmtime(&tv);
-#else
-	time_t result = timegm(&tv);
-#endif
-	if (value.length() > 19 && value[19] != 'Z') {
-		bool subtract = value[19] == '+';
-		long tz_hour = std::stoi(value.substr(20, 2));
-		long tz_min = std::stoi(value.substr(23, 2));
-		double seconds = (3600.0 * tz_hour) + (60.0 * tz_min);
-		long adjust = (long)(seconds / resolution);
-#ifdef _WIN32
-		// dates pre 1970 return -1
-		if (tv.tm_year < 70) {
-			tv.tm_year += 100;
-			double day_s = 24 * 60 * 60;
-			double cent_s = (100 * 365 + 24) * day_s;
-			result = _mkgmtime(&tv);
-			long long cent_t = cent_s / resolution;
-			result = result - cent_t;
-		}
-#endif
-		if (subtract) {
-			result -= adjust;
-		}
-		else {
-			result += adjust;
+	// YYYY-MM-DDTHH:MM:SS+HH:MM
+	if (value.length() < 19) return -1;
+	const char* text = value.c_str();
+	int year = adif_digits(text, 4);
+	int month = adif_digits(text + 5, 2);
+	int day = adif_digits(text + 8, 2);
+	int hour = adif_digits(text + 11, 2);
+	int minute = adif_digits(text + 14, 2);
+	int second = adif_digits(text + 17, 2);
+	if (year < 0 || month < 1 || month > 12 || day < 1 || hour < 0 || minute < 0 || second < 0) {
+		return -1;
+	}
+	std::time_t result = (std::time_t)(days_from_civil(year, (unsigned)month, (unsigned)day) * 86400 +
+		hour * 3600 + minute * 60 + second);
+	// Time zone offset - local time is UTC plus the offset
+	if (value.length() >= 25 && value[19] != 'Z') {
+		int tz_hour = adif_digits(text + 20, 2);
+		int tz_min = adif_digits(text + 23, 2);
+		if (tz_hour >= 0 && tz_min >= 0) {
+			std::time_t adjust = tz_hour * 3600 + tz_min * 60;
+			if (value[19] == '+') {
+				result -= adjust;
+			}
+			else {
+				result += adjust;
+			}
 		}
 	}
 	return result;
@@ -1154,4 +1239,20 @@ std::string convert_iso_datetime(std::time_t t) {
 	char temp[32];
 	strftime(temp, sizeof(temp), "%Y-%m-%dT%H:%M:%SZ", &tm_struct);
 	return std::string(temp);
-}
\ No newline at end of file
+}
+
+// Flush the file to the storage device - returns false if it cannot be done
+bool sync_file(const std::string& filename) {
+#ifdef _WIN32
+	int fd = fl_open(filename.c_str(), _O_RDWR);
+	if (fd == -1) return false;
+	bool ok = _commit(fd) == 0;
+	_close(fd);
+#else
+	int fd = fl_open(filename.c_str(), O_RDWR);
+	if (fd == -1) return false;
+	bool ok = fsync(fd) == 0;
+	close(fd);
+#endif
+	return ok;
+}
@@ -2,14 +2,19 @@
 #define __ADI_READER__
 
 #include<istream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <set>
+#include <vector>
+#include <atomic>
 
 
 
 // Forward declaration
 class book;
 class record;
+enum status_t : char;
 
 
 //! This class reads the logbook in ADIF .adi format. See https://adif.org.
@@ -17,7 +22,11 @@ class record;
 	//! It loads it into the specified book.
 	//! It is responsible for the interpretation of the ADIF format into an array of records./
 	//! These will be ordered by the chronological date of each QSO record.
-	//! The data can be sourced as any input stream form
+	//! The data can be sourced as any input stream form. The whole stream is read into
+	//! a single buffer and the records are then decoded from slices of that buffer.
+	//! Large files are split at record boundaries and the chunks decoded on worker threads.
+	//! Records in the main log only decode the fields used while loading: each keeps its ADIF
+	//! text, which is decoded when another field is first used.
 	class adi_reader
 	{
 
@@ -48,6 +57,19 @@ class record;
 		//! \param result result of the input read.
 		//! \return the state of the input stream after the read.
 		std::istream & load_record(record* record, std::istream& in, load_result_t& result);
+		//! Load data to an individual record from a buffer, failure is reported in result.
+		//! \param record QSO to be written from input.
+		//! \param pos current position in the buffer: receives the position after the record.
+		//! \param end end of the buffer.
+		//! \param result result of the input read.
+		void load_record(record* record, const char*& pos, const char* end, load_result_t& result);
+		//! Decode all the fields of a record from its ADIF text - see record::expand().
+		
+		//! \param record receives the fields.
+		//! \param text the ADIF text of the record.
+		//! \param length length of \p text.
+		//! \param report if false problems found in the fields are not reported.
+		void expand_record(record* record, const char* text, size_t length, bool report);
 
 		//! Used to report progress while reading
 		//! \return fraction of the input stream loaded into the book.
@@ -57,6 +79,53 @@ class record;
 
 		// protected methods
 	protected:
+		//! Decode the records between \p pos and \p end on worker threads and merge them into \p book.
+		
+		//! \param book logbook that will be loaded.
+		//! \param pos start of the records: receives the position after the last record decoded.
+		//! \param end end of the buffer.
+		void load_chunks(book* book, const char*& pos, const char* end);
+		//! Worker thread: decode the records between \p pos and \p end into \p records.
+		
+		//! \param that the worker instance of adi_reader - its status messages are deferred.
+		//! \param pos start of the chunk.
+		//! \param end end of the chunk.
+		//! \param records receives the records successfully decoded.
+		//! \param decoded incremented as each record is decoded.
+		//! \param finished incremented when the chunk is complete.
+		static void thread_run(adi_reader* that, const char* pos, const char* end,
+			std::vector<record*>* records, std::atomic<int>* decoded, std::atomic<int>* finished);
+		//! Returns the position after the \<EOR\> that ends the record starting at \p pos, or \p end.
+		static const char* skip_record(const char* pos, const char* end);
+		//! Returns the number of characters in \p raw used by a value of ADIF length \p count.
+		static size_t value_extent(std::string_view raw, unsigned int count);
+		//! Report a status message, or hold it to be reported from the main thread.
+		
+		//! \param status severity of the message.
+		//! \param message text of the message.
+		//! \param app_field application-defined field being ignored - it is reported only once.
+		void report(status_t status, const char* message, const std::string& app_field = "");
+		//! Read the remainder of the input stream \p in into \p buffer.
+		//! \return false if the stream could not be read.
+		static bool read_buffer(std::istream& in, std::string& buffer);
+		//! Read the input stream \p in up to the end of the next record into \p buffer.
+		
+		//! \param header the record is the header, which ends at \<EOH\> rather than \<EOR\>.
+		//! \return false if the stream could not be read.
+		static bool read_record_text(std::istream& in, std::string& buffer, bool header);
+		//! Copy the value slice \p raw into \p value, expanding lone LF into CR/LF.
+
+		//! The ADIF length \p count assumes CR/LF pairs, so a lone LF counts as two characters.
+		//! \return the number of characters consumed from \p raw.
+		static size_t copy_value(std::string_view raw, unsigned int count, std::string& value);
+		//! Validate the item \p field and add \p value to \p in_record.
+
+		//! \param in_record QSO record being read.
+		//! \param field field name (upper-case).
+		//! \param value field value.
+		//! \param type_indicator data type indicator read with the field.
+		void store_item(record* in_record, std::string& field, std::string& value, char type_indicator);
+
 		// protected attributes
 	protected:
 		//! Logbook being loaded.
@@ -71,7 +140,26 @@ class record;
 
 		//! Set of external application-defined fields that have been encountered altready
 		std::set<std::string> known_app_fields;
+
+		//! A status message held until it can be reported from the main thread.
+		struct deferred_message_t {
+			status_t status;            //!< Severity.
+			std::string text;           //!< Message text.
+			std::string app_field;      //!< Application-defined field ignored, if any.
+		};
+		//! Hold status messages rather than report them (worker instances).
+		bool defer_messages_;
+		//! Status messages held by a worker instance.
+		std::vector<deferred_message_t> deferred_;
+		//! Only decode the fields used while loading - the records keep their text in \ref buffer_.
+		bool lazy_;
+		//! Decoding the remaining fields of a record - the record is not marked dirty.
+		bool expanding_;
+		//! Decoding on a worker thread: the fields are stored as read and record::normalise() is called later.
+		bool worker_;
+		//! The text being decoded when \ref lazy_ is set.
+		std::shared_ptr<const std::string> buffer_;
 	};
 
 
-#endif
\ No newline at end of file
+#endif
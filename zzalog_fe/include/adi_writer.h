@@ -2,9 +2,11 @@
 #define __ADI_WRITER__
 
 #include "fields.h"
+#include "field_map.h"
 
 #include <string>
 #include <set>
+#include <vector>
 
 
 
@@ -32,19 +34,40 @@
 		//! \p nullptr.
 		//! \return true if successful, false if not.
 		bool store_book(book* book, std::ostream& out, bool clean, field_list* fields = nullptr);
+		//! Make the tags for every known field from the ADIF specification.
+		
+		//! This is called in the main thread before the background save, so that 
+		//! store_records() does not read the specification while it is being changed.
+		void add_tags();
+		//! Output the header and records on the specified stream without using the user interface.
+		
+		//! This is used by the background save. The records are not changed, and each is 
+		//! read while holding record::write_mutex_. Only the tags made by add_tags() are used.
+		//! \param header header record.
+		//! \param records the QSOs to output.
+		//! \param out the destination stream.
+		//! \return true if successful, false if not.
+		bool store_records(record* header, const std::vector<record*>& records, std::ostream& out);
 		//! Output the spcified QSO to the output stream.
 		
 		//! \param record QSO to output.
 		//! \param out output stream.
 		//! \param fields a std::list of fields to include in the output. Include all fields if this is 
 		//! \p nullptr.
-		static void to_adif(record* record, std::ostream& out, field_list* fields = nullptr);
+		//! \param convert_intl rename a ..._INTL field in the record if its non-_INTL field is absent.
+		static void to_adif(record* record, std::ostream& out, field_list* fields = nullptr, bool convert_intl = true);
 		//! Convert the specified firld of the specified record to a std::string for outputing.
 		
 		//! \param record specified QSO
 		//! \param field specified field
 		//! \return ADIF .adi representation of the field: eg "&ltlNAME:4&gt;Phil".
 		static std::string item_to_adif(record* record, std::string field);
+		//! Convert the specified field and value to a std::string for outputing.
+
+		//! \param field field name.
+		//! \param value field value.
+		//! \return ADIF .adi representation of the field.
+		static std::string item_to_adif(std::string field, const std::string& value);
 
 		//! Used when reporting progress while outputing a logbook.
 		
@@ -53,16 +76,46 @@
 
 		// protected methods
 	protected:
-		//! \brief Output the spcified QSO to the output stream. This call to_adif but also
-		//! performs some housekeeping.
+		//! \brief Output the spcified QSO to the output stream. This adds it to the
+		//! output buffer but also performs some housekeeping.
 		
+		//! The buffer is written to the stream when it is full. Only the fields in
+		//! \ref filter_ are included.
 		//! \param record QSO to output.
 		//! \param out output stream.
 		//! \param result success or fail stats of the write.
-		//! \param fields a std::list of fields to include in the output. Include all fields if this is 
-		//! \p nullptr.
-		//! \return true if successful false if not.
-		std::ostream & store_record(record* record, std::ostream& out, bool& result, field_list* fields = nullptr);
+		//! \return the output stream.
+		std::ostream & store_record(record* record, std::ostream& out, bool& result);
+
+		//! The text written for a field before and after its value.
+		struct field_tag_t {
+			std::string prefix;       //!< "<FIELD:" - followed by the length.
+			std::string suffix;       //!< ":T>" or ">" - the type indicator if required.
+			std::string tail;         //!< ",{list}" - the values of a USERDEF field.
+		};
+		//! Field tags in use by a write.
+		struct tag_map {
+			std::vector<field_tag_t> tags;   //!< Tags indexed by field identifier - an empty prefix is one not yet made.
+			bool complete = false;           //!< Made by add_tags(): any other field is tagged without the ADIF specification.
+		};
+		//! Fields to include in a write, indexed by field identifier.
+		typedef std::vector<bool> field_set;
+		//! Returns the tag for \p field, creating it in \p tags if it is not already there.
+		static const field_tag_t& field_tag(field_id_t field, tag_map& tags);
+		//! Set \p tag for \p field from the ADIF specification.
+		static void make_tag(const std::string& field, field_tag_t& tag);
+		//! Append the ADIF text for \p value with \p tag to \p out.
+		static void append_item(std::string& out, const field_tag_t& tag, const std::string& value);
+		//! Append the ADIF text for \p record to \p out.
+		
+		//! \param out buffer to append to.
+		//! \param qso QSO or header record: any fields not yet decoded are written from a decoded copy.
+		//! \param filter fields to include: all fields if this is \p nullptr.
+		//! \param convert_intl rename a ..._INTL field in the record if its non-_INTL field is absent.
+		//! \param tags field tags used by this write.
+		static void append_record(std::string& out, record* qso, const field_set* filter, bool convert_intl, tag_map& tags);
+		//! Returns the fields in \p fields as a field_set, or \p nullptr if \p fields is.
+		static field_set* make_filter(field_list* fields);
 
 		//! Data is ASCII compliant.
 		const unsigned char ASCII = 0;
@@ -95,6 +148,12 @@
 		item_num_t current_;
 		//! Pointer to the std::set of records being written.
 		book* out_book_;
+		//! Text waiting to be written to the output stream.
+		std::string buffer_;
+		//! Field tags used while writing the book.
+		tag_map tags_;
+		//! Fields included while writing the book - nullptr for all.
+		field_set* filter_;
 
 	};
 
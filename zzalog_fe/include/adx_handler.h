@@ -3,6 +3,7 @@
 #include "pugixml.hpp"
 
 #include <istream>
+#include <string>
 
 class book;
 class record;
@@ -12,6 +13,13 @@ using xml_node = pugi::xml_node;
 using xml_attribute = pugi::xml_attribute;
 
 //! This class provides loading and storing ADX version data usin pugixml
+
+//! The file is streamed in both directions so that memory use does not grow with the
+//! size of the log. When loading, the input is read in blocks and each HEADER or RECORD
+//! element is parsed by pugixml as a separate fragment as soon as it is complete. 
+//! The encoding is worked out once from the start of the input: UTF-16 and UTF-32
+//! input is converted to UTF-8 as it is read so that the elements can be found.
+//! When storing, the XML for each record is generated directly onto the output stream.
 class adx_handler
 {
 public:
@@ -48,8 +56,42 @@ protected:
 	//! Load the \p qso from the XML \p node
 	bool load_record(record* qso, xml_node& node);
 
-	//! Store the \p qso in the XML \p node
-	bool store_record(record* qso, xml_node& node);
+	//! Append the XML for \p qso as element \p element to \p out, indented by \p indent.
+	bool store_record(record* qso, std::string& out, const char* element, const char* indent);
+
+	//! Append \p text to \p out replacing the characters that XML reserves and dropping the control characters it does not allow.
+	static void escape(const std::string& text, std::string& out);
+
+	//! Read the next block of the input stream \p in into \ref buffer_: returns false at the end.
+	bool read_block(std::istream& in);
+
+	//! Set \ref encoding_ from the byte order mark or declaration at the start of \p in.
+	void detect_encoding(std::istream& in);
+
+	//! Convert the UTF-16 or UTF-32 text in \ref raw_ to UTF-8 in \ref buffer_.
+	
+	//! Any incomplete character is left in \ref raw_ until the next block is read.
+	void convert();
+
+	//! Returns the position of \p text in \ref buffer_ at or after \p from.
+	
+	//! More of the input stream \p in is read until it is found.
+	//! \return std::string::npos if the end of the input is reached first.
+	size_t find_text(std::istream& in, const char* text, size_t from);
+
+	//! Returns the position after the comment or CDATA section at \p lt in \ref buffer_.
+	
+	//! \return \p lt if there is neither at \p lt, std::string::npos if it does not end.
+	size_t skip_section(std::istream& in, size_t lt);
+
+	//! Returns the position of the '>' that closes element \p name, searching from \p from.
+	
+	//! Any comment or CDATA section within the element is skipped.
+	//! \return std::string::npos if the end of the input is reached first.
+	size_t find_close(std::istream& in, const std::string& name, size_t from);
+
+	//! Parse the XML element \p length characters at \p data and load it into \p qso.
+	bool load_element(record* qso, const char* data, size_t length);
 
 	//! ADX handler is laoding and converting data
 	bool loading_;
@@ -63,6 +105,16 @@ protected:
 	//! Number processed
 	int num_records_;
 
+	//! Input not yet processed.
+	std::string buffer_;
 
-};
+	//! Encoding of the input.
+	pugi::xml_encoding encoding_;
 
+	//! UTF-16 or UTF-32 input not yet converted to UTF-8.
+	std::string raw_;
+
+	//! Document that holds one element at a time while loading.
+	xml_document fragment_;
+
+};
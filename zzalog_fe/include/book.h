@@ -3,12 +3,20 @@
 
 #include "band.h"
 #include "drawing.h"
+#include "record_list.h"
 
+#include <cstdint>
+#include <ctime>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
+#include <regex>
+#include <unordered_map>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <atomic>
 
 
 
@@ -16,7 +24,10 @@
 	class adi_reader;
 	class adx_handler;
 	class adi_writer;
+	class journal;
+	class log_bench;
 	class record;
+	class zzb_handler;
 	class band_set;
 	struct search_criteria_t;
 	typedef std::vector<std::string> field_list;
@@ -51,7 +62,6 @@
 		HT_IMPORT_QUERY,          //!< Import record cannot be processed without user intervention.
 		HT_IMPORT_QUERYNEW,       //!< Query whether mismatch is a new record.
 		HT_IMPORT_QUERYSWL,       //!< Query whether SWL report is valid.
-		HT_DUPE_QUERY,            //!< Query whether records are duplicates.
 		HT_FORMAT,                //!< Formats or Columns have changed (LOGVIEW and EXTRACTVIEW).
 		HT_STARTING,              //!< Record is being created as HT_INSERTED but don't include it.
 		HT_NEW_DATA,              //!< New data has been loaded - action as HT_ALL but clears modified.
@@ -78,13 +88,33 @@
 	// The records are kept in a container with size_t as index
 	typedef size_t item_num_t;    //!< Position of item within this book.
 	typedef size_t qso_num_t;     //!< Position of item within book_ instance.
+	typedef uint64_t qso_id_t;    //!< Identifier of a QSO record: it does not change with its position.
+
+	//! What to do with a group of possible duplicate QSOs found by book::check_dupes().
+	enum dupe_action_t : uchar {
+		DA_KEEP,                  //!< Keep all the QSOs - they are not duplicates.
+		DA_MERGE,                 //!< Merge the other QSOs into the first and delete them.
+		DA_DELETE,                //!< Keep the first QSO and delete the others.
+	};
+
+	//! A group of QSOs that may be duplicates of each other.
+	struct dupe_group_t {
+		std::vector<qso_id_t> qsos;   //!< The QSOs by record::id(), in the order they are in the book.
+		std::string description;      //!< Date, time, call, band and mode of the first QSO - tab separated.
+		std::string match;            //!< The weakest match between the QSOs.
+		dupe_action_t action;         //!< What to do with the group.
+	};
 
 	//! This class is the container for the ADIF records. 
 
-	//! These are held in chronological order.
+	//! These are held in chronological order, in a record_list so that inserting or
+	//! deleting a QSO in the middle of a large log does not move all the records after it.
 	//! As well as standing alone it is used as a base class for extract_data and import_data
-	class book : public std::vector<record*>
+	class book : public record_list
 	{
+		friend class zzb_handler;
+		friend class log_bench;
+
 	// Constructors and destructors
 	public:
 		//! default constructor.
@@ -107,6 +137,14 @@
 		//! \param force store data even if it is unchanged. Defaults to false.
 		//! \param fields store only the specified fields. Defalts to all fields.
 		bool store_data(std::string filename = "", bool force = false, field_list* fields = nullptr);
+		//! Append the changed records to the journal: the whole log is stored if it has no journal.
+		
+		//! \return true if successful.
+		bool journal_data();
+		//! Wait for any background save to finish and report its result.
+		void wait_for_save();
+		//! Returns true while a background save is being written.
+		bool save_running();
 		//! Get the current selected record
 		record* get_record();
 		//! Get the numbered record and optionally select it.
@@ -147,6 +185,11 @@
 		//! \param record the record to be appended.
 		//! \return the index of the record after being added.
 		item_num_t append_record(record* record);
+		//! Insert a batch of records in their chronological positions.
+		
+		//! The batch is sorted and merged with the existing records in a single pass.
+		//! \param records the records to be inserted: these are sorted in place.
+		void insert_records(std::vector<record*>& records);
 		//! Add a header record.
 		
 		//! \param header the header record.
@@ -178,6 +221,14 @@
 		//! \param record the QSO record to insert
 		//! \return the index where the record would be inserted.
 		item_num_t get_insert_point(record* record);
+		//! Get the QSOs that start between two times.
+		
+		//! The log is kept in order of start time, with the times cached in the records,
+		//! so the QSOs are found by binary search rather than reading the log.
+		//! \param from the earliest start time.
+		//! \param to the latest start time.
+		//! \return the index of the first QSO and the index after the last.
+		std::pair<item_num_t, item_num_t> time_range(time_t from, time_t to);
 		//! Insert the record at specific position.
 		
 		//! \param pos_record the index at which to insert the record.
@@ -298,18 +349,12 @@
 		
 		//! \param value std::set whether the current record is a new record or not.
 		void new_record(bool value);
-		//! Mark that the record is not a dupe. Used after a duplicate check.
-		void accept_dupe();
-		//! Record is an exact duplicate.
-		
-		//! \param use_dupe keep the record in the logbook, otherwise delete it.
-		void reject_dupe(bool use_dupe);
-		//! Record is a duplicate. Merge data between the two records.
-		void merge_dupe();
 		//! Check duplicates.
 		
-		//! \param restart resume the current duplicate check otherwise start a new one.
-		void check_dupes(bool restart);
+		//! The QSOs that overlap with the same call, band and mode are found in a separate
+		//! std::thread. The pairs that match are grouped and the groups shown in a dupe_dialog
+		//! for the user to keep, merge or delete each group.
+		void check_dupes();
 		//! Get the match query question.
 		
 		//! \return the question text to display to the user in a match or duplicate check.
@@ -362,6 +407,33 @@
 		inline virtual item_num_t item_number(qso_num_t record_num, bool nearest = false) {
 			return record_num;
 		}
+		//! Returns the index in this std::set of records of the QSO with identifier \p id.
+		
+		//! The record is found from the chunk that holds it - see record_list::find_id().
+		//! \param id identifier of the QSO (record::id()).
+		//! \return index of record in this std::set of records. returns -1 if it is not in it.
+		item_num_t position(qso_id_t id);
+		//! Returns the indices of the QSOs with callsign \p call, in order.
+		
+		//! Only the main log keeps the callsign index: other books search all their records.
+		std::vector<item_num_t> qsos_with_call(std::string call);
+		//! Returns the indices of the QSOs that may be with the same station as \p call, in order.
+		
+		//! These include QSOs with the same base call and a different portable prefix
+		//! or suffix, and for UK calls a different regional letter. The caller must check
+		//! the CALL of each QSO, as the list may include others.
+		std::vector<item_num_t> qsos_like_call(std::string call);
+		//! Returns the callsigns in the main log that match the regular expression \p pattern.
+		
+		//! The callsigns are indexed by their three-character substrings, so that only
+		//! those that contain the longest text which every match must include are tested.
+		std::vector<std::string> calls_matching(const std::string& pattern);
+		//! Get the QSOs in the main log that may match \p criteria, using the callsign index.
+		
+		//! \param criteria the search criteria.
+		//! \param found receives the indices of the QSOs, in order.
+		//! \return false if the criteria cannot use the index, and every QSO must be tested.
+		bool call_candidates(search_criteria_t* criteria, std::vector<item_num_t>& found);
 		//! Inhibit QSO upload.
 		
 		//! \param enable if true allows QSOs to be uploaded to the QSL server sites supported by ZZALOG.
@@ -476,14 +548,125 @@
 		//! \return true if the "dirty" std::list is not empty, false if it is.
 		bool is_dirty();
 
+		// Protected methods
+	protected:
+		//! Apply the changes in the journal that are not included in the log file.
+		void replay_journal();
+		//! The record \p qso is being removed from the log: add its deletion to the journal.
+		
+		//! Call it before \p qso is removed so that its journal key can be worked out.
+		void journal_remove(record* qso);
+		//! Returns the position of the QSO with journal key \p key: size() if there is none.
+		
+		//! Only the QSOs at the time in the key are looked at. A key written before QSOs had
+		//! an APP_ZZA_JNL_ID matches the first QSO with its date, time and call.
+		item_num_t journal_position(const std::string& key);
+		//! Give each QSO without an APP_ZZA_JNL_ID one.
+		
+		//! The journal cannot refer to these until the whole log has been written, so
+		//! \ref journal_ids_unsaved_ is set until then.
+		void add_journal_ids();
+		//! Append the changed and deleted records to the journal.
+		
+		//! \return false if the journal could not be written.
+		bool flush_journal();
+		//! Append any changes and a mark to the journal before the whole log is written.
+		
+		//! \return the size of the journal that the log will include.
+		std::streamoff mark_journal();
+		//! Start writing a snapshot of the log in the background: returns false if it cannot be started.
+		
+		//! \param changed_file the file has been changed (Save As) so update the window label when done.
+		bool store_background(bool changed_file);
+		//! Background save std::thread: write the snapshot and tell the main std::thread when done.
+		static void thread_save(book* that);
+		//! Write the snapshot to a temporary file, then replace the log file with it.
+		
+		//! Called in the background save std::thread. The backup files are rotated
+		//! after the new file has been safely written: the log is compressed as it is
+		//! written if its filename ends .gz, otherwise the newest backup is then compressed.
+		//! \return true if successful.
+		bool write_snapshot();
+		//! Callback from the background save std::thread to the main std::thread.
+		static void cb_save_done(void* v);
+		//! Report the result of the background save and mark the saved records clean.
+		void save_done();
+		//! Returns the keys for \p call in the callsign index.
+		
+		//! These are the call itself and each part of it that looks like a callsign body:
+		//! that part both as it is and without any characters between its prefix and its
+		//! numeral, so that qso_details finds the UK calls that differ by the regional letter.
+		//! \param call the callsign.
+		//! \param every_part also the other parts of the call - a QSO is indexed by every part.
+		static std::vector<std::string> call_keys(const std::string& call, bool every_part);
+		//! Add \p qso to the callsign index.
+		void add_call(record* qso);
+		//! Returns the indices of the QSOs under \p key in the callsign index, in order.
+		std::vector<item_num_t> qsos_with_key(const std::string& key);
+		//! Remove \p key from the callsign index.
+		void drop_call_key(const std::string& key);
+		//! Build the callsign index when it is first used.
+		void index_calls();
+		//! Move the QSOs whose CALL has been changed to their new keys in the callsign index.
+		void index_call_changes();
+		//! Find the pairs of QSOs that may be duplicates - as check_dupes() but in this std::thread.
+		void find_dupes();
+		//! Take the copies of the QSOs that find_overlaps() reads into \ref dupe_qsos_.
+		void snapshot_dupes();
+		//! Returns the pairs of QSOs in \p qsos that overlap with the same call, band and mode.
+		
+		//! The QSOs are read once in time order. Each is hashed on its call, band and mode
+		//! and the 30 minute period it starts in: a blank band or mode is hashed as a wildcard.
+		//! Each QSO is compared with those hashed with its call, band and mode in its period
+		//! and the periods before it that may hold a QSO still in progress.
+		//! \return pairs of record::id(), earlier QSO first.
+		static std::vector<std::pair<qso_id_t, qso_id_t> > find_overlaps(const std::vector<std::unique_ptr<record> >& qsos);
+		//! Duplicate check std::thread.
+		static void thread_dupes(book* that);
+		//! Callback from the duplicate check std::thread.
+		static void cb_dupes_found(void* v);
+		//! The duplicate check std::thread has finished - group the pairs and ask the user.
+		void dupes_found();
+		//! Apply the actions in \p groups - the views are updated once at the end.
+		void resolve_dupes(const std::vector<dupe_group_t>& groups);
+		//! Remove the QSO at \p item_num - and from the main book if this is an extract.
+		void remove_dupe(item_num_t item_num);
+		//! Returns the longest text that every match of the regular expression \p pattern contains.
+		static std::string regex_literal(const std::string& pattern);
+		//! The bands, modes and submodes used in one cell of the worked-before tables.
+		struct use_cell_t {
+			band_set bands;                       //!< Bands used.
+			std::set<std::string> modes;          //!< Modes used.
+			std::set<std::string> submodes;       //!< Submodes used.
+			std::vector<bool> band_bits;          //!< Bands used by their identifier in \ref use_values_.
+			std::vector<bool> mode_bits;          //!< Modes used by their identifier in \ref use_values_.
+			std::vector<bool> submode_bits;       //!< Submodes used by their identifier in \ref use_values_.
+		};
+		//! Returns the identifier of \p name in \p ids, adding it to \p ids and \p names if new.
+		static uint32_t use_id(std::unordered_map<std::string, uint32_t>& ids, std::vector<std::string>& names, const std::string& name);
+		//! Returns the key in \ref use_cells_ of the cell for \p call, \p category and \p entity identifiers.
+		static uint64_t use_key(uint32_t call, worked_t category, uint32_t entity);
+		//! Returns the cell for \p category, \p entity and station callsign \p call, adding it if new.
+		use_cell_t& use_cell(worked_t category, const std::string& entity, const std::string& call);
+		//! Returns the cell for \p category, \p entity and station callsign \p call: nullptr if none.
+		use_cell_t* find_use_cell(worked_t category, const std::string& entity, const std::string& call);
+		//! Add the values with identifiers \p band, \p mode and \p submode to \p cell - "" is not added.
+		void add_use(use_cell_t& cell, uint32_t band, uint32_t mode, uint32_t submode);
+		//! Set bit \p id in \p bits: returns false if it was already set or \p id is for "".
+		bool mark_use(std::vector<bool>& bits, uint32_t id);
+		//! Remove all the worked-before tables.
+		void clear_use();
+
 		// Protected attributes
 	protected:
 		//! Index of the current selected QSO in this std::set of QSO records.
 		item_num_t current_item_;
-		//! Index of a QSO record to be tested whether any duplicates exist.
-		item_num_t test_item_;
-		//! Index of a QSO record that mey be a duplicate of test_item_.
-		item_num_t dupe_item_;
+		//! Pairs of QSOs with the same call, band and mode whose times overlap, by record::id().
+		std::vector<std::pair<qso_id_t, qso_id_t> > dupe_pairs_;
+		//! Copies of the QSOs read by the duplicate check std::thread.
+		std::vector<std::unique_ptr<record> > dupe_qsos_;
+		//! The duplicate check std::thread.
+		std::thread* th_dupes_;
 		//! Book usage type: one of OT_MAIN, OT_EXTRACT or OT_IMPORT.
 		object_t book_type_;
 		//! Save in progress: used to inhibit further saves.
@@ -519,24 +702,18 @@
 		std::set<std::string> used_antennas_;
 		//! The std::set of station callsigns logged in records within this std::set of QSO records.
 		std::set<std::string> used_callsigns_;
-		//! Multi-dimensional std::map indicating bands used:
-		
-		//! - Outer std::map: Mapped to DXCC entity.
-		//! - Middle std::map: Mapped to worked_t type.
-		//! - Inner std::map: Mapped to station callsign used.
-		std::map < std::string, std::map < worked_t, std::map < std::string, band_set > > > bands_;
-		//! Multi-dimensional std::map indicating modes used:
-
-		//! - Outer std::map: Mapped to DXCC entity.
-		//! - Middle std::map: Mapped to worked_t type.
-		//! - Inner std::map: Mapped to station callsign used.
-		std::map < std::string, std::map < worked_t, std::map < std::string, std::set<std::string> > > > modes_;
-		//! Multi-dimensional std::map indicating submodes used:
-
-		//! - Outer std::map: Mapped to DXCC entity.
-		//! - Middle std::map: Mapped to worked_t type.
-		//! - Inner std::map: Mapped to station callsign used.
-		std::map < std::string, std::map < worked_t, std::map < std::string, std::set<std::string> > > > submodes_;
+		//! Worked-before tables: a cell for each station callsign, worked_t category and entity.
+		
+		//! Keyed by use_key(): the callsign "" holds the usage for all station callsigns.
+		std::unordered_map<uint64_t, use_cell_t> use_cells_;
+		//! Identifiers of the station callsigns and entities in \ref use_cells_.
+		std::unordered_map<std::string, uint32_t> use_key_ids_;
+		//! The station callsigns and entities by their identifier.
+		std::vector<std::string> use_keys_;
+		//! Identifiers of the bands, modes and submodes in \ref use_cells_.
+		std::unordered_map<std::string, uint32_t> use_value_ids_;
+		//! The bands, modes and submodes by their identifier.
+		std::vector<std::string> use_values_;
 		//! match query question.
 		std::string match_question_;
 		//! Global inhibit to auto-save feature.
@@ -545,10 +722,6 @@
 		bool delete_in_progress_;
 		//! A copy of the record currently being edited in a query or duplicate check.
 		record* old_record_;
-		//! Number of records removed during a duplicate check.
-		int number_dupes_removed_;
-		//! Number of possible duplicate records not deleted.
-		int number_dupes_kept_;
 		//! File loading: used to validate updates to dynamic enumerations.
 		bool main_loading_;
 		//! Save enabled level.
@@ -571,6 +744,63 @@
 		bool deleted_record_;
 		//! Flag to indicate that the book has been modified and so needs backing up.
 		bool been_modified_;
+		//! Background save std::thread.
+		std::thread* th_save_;
+		//! A background save is in progress.
+		std::atomic<bool> save_running_;
+		//! Another save was requested while the background save was in progress.
+		bool save_pending_;
+		//! Result of the background save.
+		bool save_ok_;
+		//! Description of why the background save failed.
+		std::string save_error_;
+		//! File being written by the background save.
+		std::string save_filename_;
+		//! The background save has changed the file (Save As).
+		bool save_changed_file_;
+		//! Copy of the header record being written by the background save.
+		record* save_header_;
+		//! Binary snapshot written after the log by the background save.
+		zzb_handler* save_zzb_;
+		//! Writer of the log by the background save, with the field tags made before it started.
+		adi_writer* save_adi_;
+		//! Snapshot of the QSO records being written by the background save.
+		std::vector<record*> save_records_;
+		//! Snapshot of the dirty records when the background save started.
+		std::set<record*> save_dirty_;
+		//! Records marked dirty after the snapshot was taken - these remain dirty.
+		std::set<record*> dirty_during_save_;
+		//! A record was deleted after the snapshot was taken.
+		bool deleted_during_save_;
+		//! Size of the journal included in the log being written - -1 if no journal.
+		std::streamoff save_journal_size_;
+		//! Journal of changes made since the log file was written (main log only).
+		journal* journal_;
+		//! Records changed since they were last saved mapped to their journal key at that time.
+		
+		//! The key is an empty std::string for records inserted since then.
+		std::map<record*, std::string> journal_keys_;
+		//! Journal keys of records deleted since they were last saved.
+		std::vector<std::string> journal_deletes_;
+		//! QSOs have been given an APP_ZZA_JNL_ID that is not yet in the log file.
+		bool journal_ids_unsaved_;
+		//! Index of the QSOs by callsign: see call_keys() for the keys of each QSO.
+		
+		//! Built when it is first used and then kept up to date as QSOs are added.
+		//! QSOs whose CALL has changed are moved, and deleted QSOs removed, when the
+		//! index is next used.
+		std::unordered_map<std::string, std::vector<qso_id_t> > calls_;
+		//! The CALL of each QSO in the main log when it was first changed on the main thread
+		//! since the callsign index was last used.
+		std::map<record*, std::string> call_changes_;
+		//! The callsign index has been built.
+		bool calls_indexed_;
+		//! The keys in the callsign index by each three-character substring of them.
+		std::unordered_map<std::string, std::set<std::string> > call_grams_;
+		//! The pattern last compiled by match_string().
+		std::string regex_text_;
+		//! The compiled regular expression for \ref regex_text_.
+		std::basic_regex<char> regex_;
 
 	};
 
@@ -8,6 +8,7 @@
 #include <queue>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 class record;
@@ -121,8 +122,8 @@ typedef size_t qso_num_t;
 		
 		//! Written by main std::thread and read by upload std::thread.
 		std::atomic<bool> run_threads_;
-		//! Queue of requests for uploading QSOs.
-		std::queue<record*> upload_queue_;
+		//! Queue of requests for uploading QSOs: snapshots of the records read by the upload std::thread.
+		std::queue<std::unique_ptr<record> > upload_queue_;
 		//! Queue of responses from uploading QSOs.
 		std::queue<record*> upload_done_queue_;
 		//! Semaphore to control access to the upload_queue_.
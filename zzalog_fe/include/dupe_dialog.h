@@ -0,0 +1,60 @@
+#ifndef __DUPE_DIALOG__
+#define __DUPE_DIALOG__
+
+#include "win_dialog.h"
+#include "book.h"
+
+#include <string>
+#include <vector>
+
+
+
+class Fl_Hold_Browser;
+class Fl_Widget;
+
+
+	//! This class implements a dialog to review the groups of possible duplicate QSOs.
+
+	//! Each line shows the first QSO in a group, how closely the QSOs match and what will
+	//! be done with them. The user can keep, merge or delete each group: nothing is changed
+	//! in the book until the dialog is closed with "Apply".
+	class dupe_dialog : public win_dialog
+	{
+	public:
+		//! Constructor.
+
+		//! \param groups the groups found by book::check_dupes(): the actions chosen are set in these.
+		dupe_dialog(std::vector<dupe_group_t>& groups);
+		//! Destructor.
+		virtual ~dupe_dialog();
+
+	protected:
+		//! Callback on clicking the "Apply" button.
+
+		//! Copy the actions chosen into the groups.
+		static void cb_bn_ok(Fl_Widget* w, void* v);
+		//! Callback on clicking the "Cancel" button.
+		static void cb_bn_cancel(Fl_Widget* w, void* v);
+		//! Callback on clicking "Keep", "Merge" or "Delete".
+
+		//! \param v the dupe_action_t to set for the selected group - or every group.
+		static void cb_bn_action(Fl_Widget* w, void* v);
+
+		//! Fill the browser with a line for each group.
+		void populate();
+		//! Returns the text of the line for group \p ix.
+		std::string line(size_t ix);
+
+		// attributes
+
+		//! The groups being reviewed.
+		std::vector<dupe_group_t>& groups_;
+		//! The action chosen for each group.
+		std::vector<dupe_action_t> actions_;
+		//! Set the action for every group rather than the selected one.
+		bool all_groups_;
+		//! Browser listing the groups.
+		Fl_Hold_Browser* br_groups_;
+
+	};
+#endif
@@ -4,14 +4,17 @@
 #include "url_handler.h"
 #include "fields.h"
 
+#include <cstdint>
 #include <deque>
 #include <queue>
+#include <utility>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <set>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 
@@ -22,6 +25,7 @@ class Fl_Help_View;
 class Fl_Window;
 typedef size_t item_num_t;
 typedef size_t qso_num_t;
+typedef uint64_t qso_id_t;
 
 
 	// eQSL throttling - 10s
@@ -55,19 +59,19 @@ typedef size_t qso_num_t;
 		};
 		//! Data required to std::queue requests into upload std::thread.
 		struct request_t {
-			//! Index of QSO record in full logbook.
-			qso_num_t record_num;
+			//! Identifier of the QSO record - its position in the logbook changes as QSOs are added.
+			qso_id_t qso_id;
 			//! Force upload.
 			bool force;
 			//! Default constructor.
 			request_t()
-				: record_num(0)
+				: qso_id(0)
 				, force(false)
 			{
 			}
 			//! Constructor when posting request.
-			request_t(item_num_t n, bool f)
-				: record_num(n)
+			request_t(qso_id_t id, bool f)
+				: qso_id(id)
 				, force(f)
 			{}
 		};
@@ -123,9 +127,9 @@ typedef size_t qso_num_t;
 
 		//! enqueue a request to fetch a qsl card.
 		
-		//! \param record_num index of QSO record.
+		//! \param qso_id identifier of the QSO record: see record::id().
 		//! \param force make the request even if already have some data.
-		void enqueue_request(qso_num_t record_num, bool force = false);
+		void enqueue_request(qso_id_t qso_id, bool force = false);
 		//! Download the data from eqsl into the data stream \p adif.
 		bool download_eqsl_log(std::stringstream* adif);
 		//! Control the scheduling from the request std::queue.
@@ -203,8 +207,8 @@ typedef size_t qso_num_t;
 		std::map<std::string, std::string> parse_warning(std::string text);
 		//! Callback from request std::thread.
 		static void cb_upload_done(void* v);
-		//! Upload QSO record \p qso on eQSL request std::thread.
-		bool th_upload_qso(record* qso);
+		//! Upload QSO record \p qso on eQSL request std::thread - reading its \p snapshot.
+		bool th_upload_qso(record* qso, record* snapshot);
 		//! Start eQSL request std::thread.
 		static void thread_run(eqsl_handler* that);
 
@@ -228,8 +232,8 @@ typedef size_t qso_num_t;
 		std::thread* th_upload_;
 		//! Enable for threads - normally true and std::set false when closing ZZALOG.
 		std::atomic<bool> run_threads_;
-		//! Queue for uplaoding QSO records.
-		std::queue<record*> upload_queue_;
+		//! Queue for uplaoding QSO records: each with the snapshot of it read by the request std::thread.
+		std::queue<std::pair<record*, std::unique_ptr<record> > > upload_queue_;
 		//! Semaphore to lock upload std::queue while enqueuing and dequeueing uploads. 
 		std::mutex upload_lock_;
 		//! Upload response.
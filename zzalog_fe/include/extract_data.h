@@ -86,10 +86,10 @@
 		//! Check and add record: \p record_num is index in full log. 
 		void check_add_record(qso_num_t record_num);
 
-		//! Map index \p record_num in full std::map to the last index in extracted data.
-		void map_record(qso_num_t record_num);
-
 		//! Return the index in the full log representing the index in this log
+		
+		//! The records are matched by record::id(), so inserting or deleting records
+		//! in either log needs no remapping.
 		virtual qso_num_t record_number(item_num_t item);
 		//! Return the index in this log representing the index in the full log.
 		
@@ -140,10 +140,6 @@
 
 		//! The std::list of extract criteria
 		std::list<search_criteria_t> extract_criteria_;
-		//! The mapping of indices in this log to those in full log.
-		std::vector<qso_num_t> mapping_;
-		//! The mapping of indices in the full log to those in this log.
-		std::map<item_num_t, qso_num_t> rev_mapping_;
 		//! Current use mode
 		extract_mode_t use_mode_;
 
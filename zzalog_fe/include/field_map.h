@@ -0,0 +1,306 @@
+#ifndef __FIELD_MAP__
+#define __FIELD_MAP__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+	//! Field identifiers - the fields listed here always have these values.
+
+	//! Any other field is given the next free value when it is first seen: the ADIF
+	//! fields when the specification is loaded, USERDEF and APP_ fields as they are found.
+	//! The fields from \ref FI_CALL to \ref FI_MY_IOTA are those decoded while the main log is loaded.
+	enum field_id_t : uint16_t {
+		FI_CALL,
+		FI_QSO_DATE,
+		FI_TIME_ON,
+		FI_BAND,
+		FI_FREQ,
+		FI_MODE,
+		FI_SUBMODE,
+		FI_DXCC,
+		FI_STATION_CALLSIGN,
+		FI_OPERATOR,
+		FI_SWL,
+		FI_QSO_COMPLETE,
+		FI_GRIDSQUARE,
+		FI_CQZ,
+		FI_ITUZ,
+		FI_CONT,
+		FI_MY_RIG,
+		FI_MY_ANTENNA,
+		FI_MY_NAME,
+		FI_MY_STREET,
+		FI_MY_CITY,
+		FI_MY_POSTAL_CODE,
+		FI_MY_GRIDSQUARE,
+		FI_MY_COUNTRY,
+		FI_MY_DXCC,
+		FI_MY_STATE,
+		FI_MY_CNTY,
+		FI_MY_CQ_ZONE,
+		FI_MY_ITU_ZONE,
+		FI_MY_IOTA,
+		FI_QSO_DATE_OFF,
+		FI_TIME_OFF,
+		FI_NAME,
+		FI_QTH,
+		FI_RST_SENT,
+		FI_RST_RCVD,
+		FI_QSL_RCVD,
+		FI_QSL_SENT,
+		FI_EQSL_QSL_RCVD,
+		FI_EQSL_QSL_SENT,
+		FI_LOTW_QSL_RCVD,
+		FI_LOTW_QSL_SENT,
+		FI_NUM_FIXED,            //!< Number of fields with fixed identifiers.
+		FI_NONE = 0xFFFF         //!< Not a known field.
+	};
+
+	//! This class gives each field name a small integer identifier, field_id_t.
+
+	//! The identifiers are shared by all records, which hold the identifier rather than the name.
+	//! Looking up a name does not take a lock: the names are held in a table that is replaced,
+	//! not changed, when a new field is added. Adding a field takes a lock.
+	class field_registry
+	{
+	public:
+		//! Returns the identifier of \p name, adding it if it is a new field.
+		static field_id_t id(const std::string& name);
+		//! Returns the identifier of \p name, or \ref FI_NONE if it is not a known field.
+		static field_id_t find(const std::string& name);
+		//! Returns the name of the field \p id.
+		static const std::string& name(field_id_t id);
+		//! Returns the number of fields known - their identifiers are 0 to one less than this.
+		static size_t count();
+		//! Add all the fields in \p names - e.g. the ADIF fields when the specification is loaded.
+		static void add(const std::set<std::string>& names);
+		//! Returns true if the values of field \p id are held in the value_pool.
+		static bool pooled(field_id_t id);
+		//! Hold the values of the fields in \p names in the value_pool - e.g. the enumerated fields.
+		static void pool(const std::set<std::string>& names);
+
+	protected:
+		//! A version of the lookup tables.
+		struct table_t {
+			std::unordered_map<std::string, field_id_t> ids;  //!< Identifier by name.
+			std::vector<const std::string*> names;            //!< Name by identifier.
+			std::vector<bool> pooled;                         //!< Values are pooled, by identifier.
+		};
+		//! Returns the current tables.
+		static const table_t* tables();
+		//! Add \p names to a new copy of the tables if any are new: called holding \ref mutex_.
+
+		//! If \p pool is true, the fields in \p names also have their values pooled.
+		static const table_t* add_names(const std::vector<std::string>& names, bool pool = false);
+
+		//! The current tables.
+		static std::atomic<const table_t*> current_;
+		//! Held while adding fields.
+		static std::mutex mutex_;
+		//! The field names - in a std::deque so that they do not move as names are added.
+		static std::deque<std::string> names_;
+		//! Every version of the tables - kept as a reader may still be using an old one.
+		static std::vector<std::unique_ptr<table_t> > versions_;
+	};
+
+	//! This class holds a single copy of each value of the fields with few different values.
+
+	//! BAND, MODE, STATION_CALLSIGN, the QSL status fields and the like repeat the same few
+	//! values in every record. Each record points at the copy held here, and two values of
+	//! such a field are equal if and only if they are the same copy.
+	//! The values are never removed, so the pointers remain valid.
+	class value_pool
+	{
+	public:
+		//! Returns the copy of \p value, adding it if it is a new value.
+		static const std::string* intern(const std::string& value);
+		//! Returns the copy of \p value, or nullptr if it is not held.
+		static const std::string* find(const std::string& value);
+
+	protected:
+		//! Held shared while looking up values, exclusively while adding them.
+		static std::shared_mutex mutex_;
+		//! The values - the elements of a std::unordered_set do not move as it grows.
+		static std::unordered_set<std::string> values_;
+	};
+
+	//! A field identifier and its value as held in a field_map.
+
+	//! The value of a field whose values are pooled points into the value_pool;
+	//! any other value is owned by the item.
+	class field_item
+	{
+	public:
+		field_item(field_id_t id, const std::string& value);
+		field_item(const field_item& rhs);
+		field_item(field_item&& rhs) noexcept;
+		field_item& operator=(const field_item& rhs);
+		field_item& operator=(field_item&& rhs) noexcept;
+		~field_item();
+
+		//! Returns the value.
+		const std::string& value() const { return *value_; }
+		//! Set the value.
+		void value(const std::string& value);
+		//! Returns true if the value is held in the value_pool.
+		bool pooled() const { return pooled_; }
+		//! Returns the address of the value - for a pooled value the same for all equal values.
+		const std::string* value_ptr() const { return value_; }
+
+		//! Field identifier.
+		field_id_t first;
+
+	protected:
+		//! Set \p value_ from \p value - from the value_pool if the field is pooled.
+		void assign(const std::string& value);
+		//! Delete the value if it is owned.
+		void release();
+
+		//! The value is in the value_pool rather than owned - next to \ref first to keep the item small.
+		bool pooled_;
+		//! The value.
+		const std::string* value_;
+	};
+
+	//! An item in a field_map as seen through its iterators: the field name, value and identifier.
+	struct field_ref_t {
+		const std::string& first;    //!< Field name.
+		const std::string& second;   //!< Field value.
+		field_id_t id;               //!< Field identifier.
+	};
+
+	//! Iterator over the items in a field_map.
+
+	//! Dereferencing it gives a field_ref_t, so that "it->first" and "it->second" are
+	//! used as with the std::map that field_map replaces. The values are read-only:
+	//! they are changed through field_map::set.
+	template <class I>
+	class field_iterator
+	{
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef field_ref_t value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef field_ref_t reference;
+		//! Holds the item referred to for operator->.
+		struct pointer {
+			reference ref;
+			const reference* operator->() const { return &ref; }
+		};
+
+		field_iterator() {}
+		field_iterator(I it) : it_(it) {}
+		//! An iterator converts to a const_iterator.
+		template <class I2>
+		field_iterator(const field_iterator<I2>& rhs) : it_(rhs.base()) {}
+
+		reference operator*() const { return reference{ field_registry::name(it_->first), it_->value(), it_->first }; }
+		pointer operator->() const { return pointer{ **this }; }
+		field_iterator& operator++() { ++it_; return *this; }
+		field_iterator operator++(int) { field_iterator was = *this; ++it_; return was; }
+		field_iterator& operator--() { --it_; return *this; }
+		field_iterator operator--(int) { field_iterator was = *this; --it_; return was; }
+		template <class I2>
+		bool operator==(const field_iterator<I2>& rhs) const { return it_ == rhs.base(); }
+		template <class I2>
+		bool operator!=(const field_iterator<I2>& rhs) const { return it_ != rhs.base(); }
+		//! Returns the underlying iterator.
+		I base() const { return it_; }
+
+	protected:
+		//! Position in the items.
+		I it_;
+	};
+
+	//! This class holds the fields of a record as field_item (field_id_t, value) in one vector.
+
+	//! It provides the parts of the std::map<std::string, std::string> interface used with records,
+	//! including iteration in field name order, as well as access by field identifier.
+	//! A lookup by identifier is a scan of a few small integers; a lookup by name first finds
+	//! its identifier.
+	//! 
+	//! Copying a field_map shares the vector: it is copied by the first change made to either
+	//! while it is shared. A copy taken in the thread that changes the map can so be read by
+	//! another thread without holding a lock. The iterators are all read-only.
+	class field_map
+	{
+	public:
+		//! A field identifier and value.
+		typedef field_item item_t;
+		//! The items - sorted by field name.
+		typedef std::vector<item_t> items_t;
+		typedef field_iterator<items_t::const_iterator> const_iterator;
+		typedef const_iterator iterator;
+
+		const_iterator begin() const { return const_iterator(items().begin()); }
+		const_iterator end() const { return const_iterator(items().end()); }
+		//! Returns the number of fields.
+		size_t size() const { return items().size(); }
+		//! Returns true if there are no fields.
+		bool empty() const { return items().empty(); }
+		//! Remove all the fields.
+		void clear() { items_.reset(); }
+		//! Reserve space for \p count fields.
+		void reserve(size_t count) { if (count) writable().reserve(count); }
+
+		//! Returns the item for \p field, or end() if it is not present.
+		const_iterator find(field_id_t field) const;
+		const_iterator find(const std::string& field) const { return find(field_registry::find(field)); }
+		//! Returns 1 if \p field is present, otherwise 0.
+		size_t count(const std::string& field) const { return find(field) == end() ? 0 : 1; }
+		//! Returns the value of \p field: throws std::out_of_range if it is not present.
+		const std::string& at(const std::string& field) const;
+		//! Set the value of \p field, adding it if it is not present.
+		void set(field_id_t field, const std::string& value);
+		void set(const std::string& field, const std::string& value) { set(field_registry::id(field), value); }
+		//! Returns true if \p field has the same value in this and \p other - absent counts as empty.
+
+		//! For a pooled field this compares the addresses of the values.
+		bool same_value(field_id_t field, const field_map& other) const;
+		//! Returns true if the value of \p field is \p value - an address from value_pool::find.
+
+		//! Use it for a pooled field: nullptr matches no value.
+		bool value_is(field_id_t field, const std::string* value) const;
+		//! Add \p value for \p field if it is not already present.
+		std::pair<iterator, bool> emplace(field_id_t field, const std::string& value);
+		std::pair<iterator, bool> emplace(const std::string& field, const std::string& value) {
+			return emplace(field_registry::id(field), value);
+		}
+		//! As emplace - the item is appended if it goes at \p hint and that is end().
+		iterator emplace_hint(const_iterator hint, field_id_t field, const std::string& value);
+		iterator emplace_hint(const_iterator hint, const std::string& field, const std::string& value) {
+			return emplace_hint(hint, field_registry::id(field), value);
+		}
+		//! Remove \p field: returns the number of fields removed.
+		size_t erase(field_id_t field);
+		size_t erase(const std::string& field) { return erase(field_registry::find(field)); }
+		//! Remove the item at \p pos: returns the position of the next item.
+		iterator erase(const_iterator pos);
+
+	protected:
+		//! Returns the items - an empty vector if there are none.
+		const items_t& items() const { return items_ ? *items_ : no_items(); }
+		//! Returns the items to change - copying them first if they are shared.
+		items_t& writable();
+		//! Returns where an item for \p field goes to keep the items in field name order - after writable().
+		items_t::iterator insert_point(field_id_t field);
+		//! The empty vector used while there are no items.
+		static const items_t& no_items();
+
+		//! The fields and their values - shared by copies of the map until either is changed.
+		std::shared_ptr<items_t> items_;
+	};
+
+#endif
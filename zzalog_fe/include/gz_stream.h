@@ -0,0 +1,99 @@
+#ifndef __GZ_STREAM__
+#define __GZ_STREAM__
+
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+struct gzFile_s;
+
+	//! This class is a stream buffer that reads or writes a gzip compressed file.
+
+	//! The data is compressed or decompressed as it passes through the buffer, so the
+	//! existing readers and writers work on compressed files through gz_ifstream and gz_ofstream.
+	//! Logs are compressed if their filename ends with ".gz", e.g. "log.adi.gz".
+	class gz_streambuf : public std::streambuf
+	{
+	public:
+		//! Constructor.
+		gz_streambuf();
+		//! Destructor - closes the file.
+		virtual ~gz_streambuf();
+
+		//! Open \p filename for reading (\p mode includes std::ios::in) or writing.
+		//! \return false if the file could not be opened.
+		bool open(const std::string& filename, std::ios::openmode mode);
+		//! Close the file.
+		//! \return false if the data could not all be written.
+		bool close();
+		//! Returns true if the file is open.
+		bool is_open();
+
+		//! Returns true if \p filename is of a compressed file.
+		static bool is_compressed(const std::string& filename);
+		//! Returns the lower-case file type suffix of \p filename, ignoring any ".gz", e.g. ".adi".
+		static std::string file_type(const std::string& filename);
+		//! Write a compressed copy of the file \p from to \p to.
+		//! \return false if the copy could not be written: \p to is then removed.
+		static bool compress_file(const std::string& from, const std::string& to);
+
+	protected:
+		//! Refill the read buffer.
+		virtual int_type underflow();
+		//! Read \p count characters into \p s, directly from the file when the buffer is empty.
+		virtual std::streamsize xsgetn(char* s, std::streamsize count);
+		//! Compress the write buffer and \p c.
+		virtual int_type overflow(int_type c);
+		//! Compress the contents of the write buffer.
+		virtual int sync();
+
+		//! Compress the contents of the write buffer: returns false if they could not be written.
+		bool flush_buffer();
+
+		//! The zlib file handle.
+		gzFile_s* file_;
+		//! Opened for writing.
+		bool writing_;
+		//! Read or write buffer.
+		std::vector<char> buffer_;
+	};
+
+	//! Input stream from a gzip compressed file - see gz_streambuf.
+	class gz_ifstream : public std::istream
+	{
+	public:
+		//! Constructor.
+		gz_ifstream();
+		//! Constructor that opens \p filename.
+		gz_ifstream(const std::string& filename);
+		//! Open \p filename - sets failbit if it cannot be opened.
+		void open(const std::string& filename);
+		//! Close the file.
+		void close();
+
+	protected:
+		//! The decompressing buffer.
+		gz_streambuf buf_;
+	};
+
+	//! Output stream to a gzip compressed file - see gz_streambuf.
+	class gz_ofstream : public std::ostream
+	{
+	public:
+		//! Constructor.
+		gz_ofstream();
+		//! Constructor that opens \p filename.
+		gz_ofstream(const std::string& filename);
+		//! Open \p filename - sets failbit if it cannot be opened.
+		void open(const std::string& filename);
+		//! Close the file - sets failbit if the data could not all be written.
+		void close();
+
+	protected:
+		//! The compressing buffer.
+		gz_streambuf buf_;
+	};
+
+#endif
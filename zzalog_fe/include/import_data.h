@@ -90,6 +90,12 @@ class book;
 		//! some ADIF fields are renamed to the viewpoiint of this
 		//! log not the server.
 		void convert_update(record* record);
+		//! Match the records downloaded from a QSL server against the log in one pass.
+		
+		//! The records are sorted into time order and merged with the log, which is
+		//! also in time order. Exact and probable matches are merged into the log;
+		//! the other records are left for update_book() to query with the user.
+		void bulk_update();
 
 	protected:
 		//! a record update query is in progress
@@ -121,6 +127,8 @@ class book;
 		qso_num_t last_added_number_;
 		//! Last record loaded
 		record* last_record_loaded_;
+		//! The records have already been converted and checked by bulk_update().
+		bool bulk_checked_;
 
 	};
 #endif
@@ -0,0 +1,83 @@
+#ifndef __JOURNAL__
+#define __JOURNAL__
+
+#include <string>
+#include <sstream>
+#include <vector>
+
+class record;
+
+	//! This class maintains an append-only journal of the changes made to the log.
+
+	//! The journal is held next to the log file with the suffix ".jnl" added. Each inserted,
+	//! changed or deleted QSO record is appended as an ADIF .adi fragment, with
+	//! APP_ZZA_JNL_OP giving the operation and APP_ZZA_JNL_KEY identifying the record
+	//! as it was last saved. Each QSO in the log holds an identifier, APP_ZZA_JNL_ID, that
+	//! is unique to it and does not change, so the key does not depend on the order of the
+	//! entries or of the QSOs. When the whole log is written a mark is added to the journal
+	//! and to the log header: the journal is then compacted to the entries after the mark.
+	class journal
+	{
+	public:
+		//! Constructor.
+		journal();
+		//! Destructor.
+		~journal();
+
+		//! Set the journal for the log file \p log_filename. Only .adi logs have a journal.
+		void log_filename(const std::string& log_filename);
+		//! Returns true if the log has a journal.
+		bool active();
+		//! Add the current contents of \p qso.
+
+		//! \param qso the QSO record.
+		//! \param key identifies the record as last saved: an empty std::string if it is a new record.
+		void put(record* qso, const std::string& key);
+		//! Add the deletion of the record last saved as \p key.
+		void remove(const std::string& key);
+		//! Add a mark - the log header holds \p token if the log includes all entries before it.
+		void mark(const std::string& token);
+		//! Append the added entries to the journal file and flush it to disk.
+
+		//! \return false if the journal could not be written.
+		bool flush();
+		//! Read the entries that are not in the log.
+
+		//! \param base_mark the mark held in the log header: entries before it are ignored.
+		//! \param entries receives the entries as records, still including the APP_ZZA_JNL_ fields.
+		void read(const std::string& base_mark, std::vector<record*>& entries);
+		//! The log has been written including all entries before \p offset.
+
+		//! Only the entries after \p offset are kept: these are moved to the journal
+		//! for \p log_file as the log may have been saved as a new file.
+		//! \return false if the journal could not be rewritten.
+		bool compact(std::streamoff offset, const std::string& log_file);
+		//! Returns the size of the journal file.
+		std::streamoff size();
+		//! Returns the number of entries in the journal that are not in the log.
+		int entries();
+		//! Returns the key used to identify \p qso in the journal: "QSO_DATE TIME_ON #APP_ZZA_JNL_ID".
+		
+		//! The date and time find the QSO in the log without an index: the identifier picks
+		//! it out from any others at the same time.
+		static std::string key(record* qso);
+		//! Returns a new value for APP_ZZA_JNL_ID for \p qso.
+		static std::string new_id(record* qso);
+
+	protected:
+		//! Replace the journal file with \p data, or remove it if \p data is empty.
+		bool rewrite(const std::string& filename, const std::string& data);
+
+		//! The journal filename: empty if the log has no journal.
+		std::string filename_;
+		//! Entries waiting to be appended.
+		std::ostringstream pending_;
+		//! Number of entries waiting to be appended.
+		int num_pending_;
+		//! Number of entries in the journal file that are not in the log.
+		int entries_;
+		//! Size of the journal file.
+		std::streamoff size_;
+	};
+
+#endif
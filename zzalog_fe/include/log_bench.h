@@ -0,0 +1,78 @@
+#ifndef __LOG_BENCH__
+#define __LOG_BENCH__
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class book;
+class record;
+
+	//! This class times the log handling on synthetic logs - run by "zzalog --bench".
+
+	//! For each log size a log with realistic callsign, band, mode and date distributions
+	//! is generated from a fixed seed, so every run uses exactly the same data.
+	//! The following are then timed several times each against the main log book:
+	//! inserting the QSOs, saving and loading the log in .adi and .adx format, and
+	//! finding the possible duplicates. The minimum, median, mean, maximum and standard deviation of
+	//! each are written to a JSON file so that the results of releases can be compared.
+	class log_bench
+	{
+	public:
+		//! Constructor.
+
+		//! \param sizes the numbers of QSOs in the generated logs.
+		//! \param runs the number of times each operation is timed.
+		log_bench(const std::vector<size_t>& sizes, int runs);
+		//! Destructor.
+		~log_bench();
+
+		//! Run the benchmark on the book \p b and write the results to \p filename.
+
+		//! \p b is emptied before each operation and left empty.
+		//! \return true if all the operations succeeded and the results were written.
+		bool run(book* b, const std::string& filename);
+
+	protected:
+		//! Generate the log of \p count QSOs into \p qsos.
+		void generate(size_t count, std::vector<record*>& qsos);
+		//! Generate a callsign.
+		std::string callsign();
+		//! Returns a random number less than \p limit.
+		uint32_t random(uint32_t limit);
+		//! Returns the index of an entry in \p weights chosen in proportion to its weight.
+		size_t weighted(const std::vector<uint32_t>& weights);
+		//! Empty the book and give it the header of a generated log of \p count QSOs.
+		void empty_book(size_t count);
+		//! Time one run of each operation on the generated log \p qsos.
+
+		//! \return false if an operation failed.
+		bool time_operations(const std::vector<record*>& qsos);
+		//! Record the time since \p start against \p operation.
+		void add_time(const std::string& operation, std::chrono::steady_clock::time_point start);
+
+		//! The sizes of log to generate.
+		std::vector<size_t> sizes_;
+		//! The number of times each operation is timed.
+		int runs_;
+		//! The book being used.
+		book* book_;
+		//! Random number generator - the same sequence for every benchmark.
+		std::mt19937 rng_;
+		//! Callsigns generated so far - later QSOs reuse some of them.
+		std::vector<std::string> calls_;
+		//! The log as written in .adi format.
+		std::string adi_text_;
+		//! The log as written in .adx format.
+		std::string adx_text_;
+		//! Number of pairs of possible duplicates found.
+		int dupes_;
+		//! Operation names in the order they are performed.
+		std::vector<std::string> operations_;
+		//! The times in milliseconds of each operation.
+		std::vector<std::vector<double> > times_;
+	};
+
+#endif
@@ -103,6 +103,8 @@ extern bool AUTO_SAVE_S;
 extern bool DARK;
 //! Version of \p DARK read from settings.
 extern bool DARK_S;
+//! Time the log handling on synthetic logs instead of running ZZALOG - by "-b"
+extern bool BENCHMARK;
 //! Print version details instead of running ZZALOG -  by "-v"
 extern bool DISPLAY_VERSION;
 //! Print command-line interface instead of running ZZALOG -  by "-h"
@@ -212,6 +214,12 @@ void add_data();
 //! \param arg filename supplied as command-line argument.
 void add_book(char* arg);
 
+//! Run the benchmark - see log_bench.
+
+//! It is run before any window is created and loads only the reference data it needs.
+//! \return true if all the operations succeeded.
+bool run_bench();
+
 //! Instantiate the following external protocol handlers:
 
 //! - Generic HTTP and UDP handler.
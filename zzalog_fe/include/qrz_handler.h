@@ -8,8 +8,10 @@
 #include <map>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
 
 
 
@@ -106,8 +108,8 @@ protected:
 		std::string& fail_reason, unsigned long long& logid);
 	//! Callback when insert upload complete, sent from upload std::thread  to main std::thread.
 	static void cb_upload_done(void* v);
-	//! Call to upload std::thread to upload \p qso.
-	void th_upload_qso(record* qso);
+	//! Call to upload std::thread to upload \p qso - reading its \p snapshot.
+	void th_upload_qso(record* qso, record* snapshot);
 	//! Run the std::thread to upload QSOs in the background
 	static void thread_run(qrz_handler* that);
 	//! Upload done (run in main std::thread with response \p resp).
@@ -141,8 +143,8 @@ protected:
 	std::mutex upload_lock_;
 	//! Upload response
 	std::atomic<upload_resp_t*> upload_resp_;
-	//! Upload request std::queue
-	std::queue<record*> upload_queue_;
+	//! Upload request std::queue: each QSO with the snapshot of it read by the upload std::thread.
+	std::queue<std::pair<record*, std::unique_ptr<record> > > upload_queue_;
 
 };
 
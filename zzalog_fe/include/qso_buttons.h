@@ -65,10 +65,6 @@ public:
 		MERGE_QUERY,        //!< Merge details from the QSO being queried to the displayed QSO.
 		FIND_QSO,           //!< Find a possible match to this QSO and display it.
 		BROWSE,             //!< Display the current QSO in qso_browse mode.
-		KEEP_DUPE_1,        //!< When checking duplicates, keep the first and delete the second.
-		KEEP_DUPE_2,        //!< When checking duplicates, keep the second and delete the first.
-		MERGE_DUPE,         //!< When checking duplicates, merge datafrom the two QSOs.
-		KEEP_BOTH_DUPES,    //!< When checking duplicates, keep both QSOs.
 		MERGE_DONE,         //!< Merge complete, continue importing.
 		LOOK_ALL_TXT,       //!< Search for possible match in WSJT-X ALL.TXT file.
 		START_NET,          //!< Start net input mode.
@@ -122,8 +118,6 @@ public:
 	static void cb_bn_merge_query(Fl_Widget* w, void* v);
 	//! Callback to find QSO
 	static void cb_bn_find_match(Fl_Widget* w, void* v);
-	//! Callback for dupe functions.
-	static void cb_bn_dupe(Fl_Widget* w, void* v);
 	//! Callback to save or reject merge.
 	static void cb_bn_save_merge(Fl_Widget* w, void* v);
 	//! Callback to fetch data from QRZ.com
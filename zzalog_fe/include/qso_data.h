@@ -60,7 +60,6 @@ public:
 		QUERY_MATCH,     //!< Query: Compare new QSO with nearest match in log - add, reject or selectively merge
 		QUERY_NEW,       //!< Query: Not able to find QSO - allow manual matching
 		QUERY_WSJTX,     //!< Query found in WSJT-X ALL.TXT file
-		QUERY_DUPE,      //!< Query: Two records in log found to be possible duplicates - select either, both or a merge
 		QUERY_SWL,       //!< Query: SWL report
 		QRZ_MERGE,       //!< Merge details downloaded from QRZ.com (existing record)
 		QRZ_COPY,        //!< Copy details downloaded from QRZ.com (new record)
@@ -75,14 +74,6 @@ public:
 		TEST_ACTIVE,     //!< A contest QSO is being logged
 	};
 
-	//! Used in dupe checking to control how dupe QSOs are handled
-	enum dupe_flags : int {
-		DF_1,			//!< Select the first QSO
-		DF_2,           //!< Select the second QSO
-		DF_MERGE,		//!< Merge the two QSOs
-		DF_BOTH			//!< Use both (ie they are not dupes)
-	};
-
 	//! Source of editing
 	enum qso_init_t : uchar {
 		QSO_ON_AIR,         //!< Start a QSO using current time and CAT if connected
@@ -212,8 +203,6 @@ public:
 	//! \param match_num Index in full log of possible matching SO record
 	//! \param query_num Index of QSO being queried.
 	void action_query(logging_state_t query, qso_num_t match_num, qso_num_t query_num);
-	//! Action handle dupe function \p action.
-	void action_handle_dupe(dupe_flags action);
 	//! Action merge from QRZ.com
 	void action_save_merge();
 	//! Look in all.txt
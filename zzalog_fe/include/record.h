@@ -8,6 +8,7 @@ record.h - Individual record data item: header file
 #ifndef __RECORD__
 #define __RECORD__
 
+#include "field_map.h"
 #include "utils.h"
 
 #include <map>
@@ -15,6 +16,10 @@ record.h - Individual record data item: header file
 #include<istream>
 #include<ostream>
 #include <chrono>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 
 
@@ -53,11 +58,47 @@ record.h - Individual record data item: header file
 
 	// forward declaration
 	enum hint_t : uchar;
+	class record;
+
+	//! Flags in field_desc_t.
+	enum field_flags_t : uchar {
+		FD_NONE = 0,              //!< No special treatment.
+		FD_CONFIRM_DELETE = 1,    //!< Deleting the field needs item_policy::allow_delete.
+		FD_GRIDSQUARE = 2,        //!< GRIDSQUARE or MY_GRIDSQUARE - displayed with its _EXT field.
+		FD_LONGITUDE = 4,         //!< LON or MY_LON - displayed as E or W rather than N or S.
+		FD_MODE = 8,              //!< MODE - a displayed submode sets SUBMODE.
+	};
+
+	//! How record::item(field, value) treats a field: worked out once per field from spec_data.
+	struct field_desc_t {
+		//! Converts \p value to the form held in the record, e.g. to upper case.
+		std::string(*normalise)(const std::string& value);
+		//! ADIF data type indicator - '\0' if the field is not known.
+		char type_indicator;
+		//! field_flags_t values.
+		uchar flags;
+	};
+
+	//! This class decides on changes to a record that need the user's agreement.
+
+	//! Each thread has its own policy: with none (the default) all such changes are made,
+	//! so that reading and importing files never stop to ask.
+	class item_policy {
+	public:
+		virtual ~item_policy() {}
+		//! Returns true if \p field, which identifies the QSO, may be deleted from \p qso.
+		virtual bool allow_delete(record* qso, const std::string& field) = 0;
+	};
 
 	typedef size_t qso_num_t;    // QSO number
+	typedef uint64_t qso_id_t;   // QSO identifier
 
 	//! This class represents a single QSO record as a container of field items NAME=>VALUE
-	class record : public std::map<std::string, std::string> {
+
+	//! The fields are held as field identifiers and values - see field_map.
+	class record : public field_map {
+		friend class zzb_handler;
+
 	public:
 
 		// Constructors and Destructors
@@ -70,6 +111,10 @@ record.h - Individual record data item: header file
 		record& operator= (const record& rhs);
 		//! Destructor
 		virtual ~record();
+		//! Allocate a record from the pool of record slots kept for reuse.
+		static void* operator new(size_t size);
+		//! Return the record's slot to the pool.
+		static void operator delete(void* p, size_t size);
 
 		// Public methods
 	public:
@@ -86,6 +131,13 @@ record.h - Individual record data item: header file
 		//! \param formatted if true converts data to the displayed format.
 		//! \return Field value.
 		std::string item(std::string field, bool formatted = false);
+		//! Returns the item - identified by field_id_t.
+
+		//! This avoids looking up the field name, e.g. item(FI_CALL) rather than item("CALL").
+		//! \param field Field identifier.
+		//! \param formatted if true converts data to the displayed format.
+		//! \return Field value.
+		std::string item(field_id_t field, bool formatted = false);
 		//! Gets an integer item
 		
 		//! \param field Field name
@@ -105,6 +157,8 @@ record.h - Individual record data item: header file
 		bool is_valid();
 		//! Returns true if the item named \p field exists and is not an empty std::string.
 		bool item_exists(std::string field);
+		//! Returns true if the item \p field exists and is not an empty std::string.
+		bool item_exists(field_id_t field);
 		//! Set the header information
 		void header(std::string comment);
 		//! Returns the header information
@@ -151,17 +205,79 @@ record.h - Individual record data item: header file
 		
 		//! \param time_off if true use QSO_DATE_OFF + TIME_OFF rather than QS_DATE + TIME_ON for the QSO time.
 		std::chrono::system_clock::time_point ctimestamp(bool time_off = false);
+		//! Returns FREQ (or FREQ_RX if \p rx is true) in MHz, NAN if it is absent or invalid.
+		double freq(bool rx = false);
+		//! Returns DXCC, 0 if it is absent or invalid.
+		int dxcc();
+		//! Returns the identifier of the QSO: it does not change when records are inserted or deleted.
+
+		//! Each record is given a new identifier when created: assigning one record to another
+		//! keeps the identifier of the target. Copies made by lazy_copy() and snapshot() share it.
+		qso_id_t id() const { return id_; }
 		//! Itema \p field_name match between \p record and this record.
 		bool items_match(record* record, std::string field_name);
 		//! Delete all contents
 		void delete_contents();
 		//! Delete QSL statuses.
 		void invalidate_qsl_status();
+		//! Keep the ADIF text of the record for the fields not decoded when it was read.
+
+		//! \param buffer the text of the whole file: it is kept while any record refers to it.
+		//! \param text start of the record in \p buffer.
+		//! \param length length of the record text.
+		void raw_text(std::shared_ptr<const std::string> buffer, const char* text, size_t length);
+		//! Returns true if some fields have not yet been decoded from the ADIF text.
+		bool is_lazy() const;
+		//! Decode the fields not yet decoded - called before the fields are accessed directly.
+
+		//! \param report if false problems found in the fields are not reported.
+		void expand(bool report = true);
+		//! Convert the values set directly with field_map::set() to the form item() holds them in.
+
+		//! The adi_reader worker threads store the fields as they read them: this is then
+		//! called in the main thread.
+		void normalise();
+		//! Copy this record into \p copy, leaving any fields not yet decoded as ADIF text.
+
+		//! The copy shares the fields with this record until either is changed.
+		//! This neither changes this record nor takes \ref write_mutex_, so another std::thread
+		//! can use it while holding the mutex. \p copy must be an empty record.
+		void lazy_copy(record& copy) const;
+		//! Returns this record, or \p copy holding all its fields if some are not yet decoded.
+
+		//! This record is not changed. \p copy must be an empty record.
+		record* decoded(record& copy);
+		//! Returns a copy of this record for another thread to read while this one is changed.
+
+		//! The copy shares the fields with this record until either is changed, so it is cheap
+		//! to take. Any fields not yet decoded are decoded into the copy without reporting
+		//! problems. Take it in the thread that changes this record.
+		std::unique_ptr<record> snapshot() const;
+		//! Returns true if \p field is decoded when the record is read from the main log.
+
+		//! These are the fields used while the log is loaded: the others are decoded when first used.
+		static bool decoded_on_load(const std::string& field);
+		//! Returns true if \p field is decoded when the record is read from the main log.
+		static bool decoded_on_load(field_id_t field);
+		//! Work out the field_desc_t of every field in the specification - called when it changes.
+		static void describe_fields();
+		//! Set the item_policy of this thread - nullptr to make all changes without asking.
+		static void policy(item_policy* policy);
+		//! Returns the item_policy of this thread.
+		static item_policy* policy();
+		//! Returns the item_policy that asks the user - used by the main thread.
+		static item_policy* ask_user();
 
 		// protected attributes
 	protected:
 		//! Set timestamp
 		void set_timestamp();
+		//! Forget any cached values derived from \p field - called when it is changed.
+		void invalidate(field_id_t field);
+		//! Returns the field_desc_t of \p field (identified by \p id).
+		static field_desc_t descriptor(field_id_t id, const std::string& field);
+		//! Work out the field_desc_t of \p field.
+		static field_desc_t describe(const std::string& field);
 
 		//! record is a header
 		bool is_header_;
@@ -175,10 +291,58 @@ record.h - Individual record data item: header file
 
 		//! Timestamp - updated whenever QSO_DATE/TIME_ON are changed
 		time_t timestamp_{ -1 };
+		//! The last identifier given to a record.
+		static std::atomic<qso_id_t> last_id_;
+		//! Identifier of the QSO.
+		qso_id_t id_{ ++last_id_ };
+
+		//! Values derived from the fields, held in the record when first asked for.
+		enum cached_t : uchar {
+			CV_TIME_OFF = 1,      //!< \ref timestamp_off_
+			CV_FREQ = 2,          //!< \ref freq_
+			CV_FREQ_RX = 4,       //!< \ref freq_rx_
+			CV_LOCATION = 8,      //!< \ref location_ [0] - of the contacted station
+			CV_MY_LOCATION = 16,  //!< \ref location_ [1] - of the user's station
+			CV_DXCC = 32          //!< \ref dxcc_
+		};
+		//! The cached_t values that are valid - reset by invalidate() when their fields change.
+		uchar cached_{ 0 };
+		//! End timestamp.
+		time_t timestamp_off_{ -1 };
+		//! FREQ as a number.
+		double freq_{ 0.0 };
+		//! FREQ_RX as a number.
+		double freq_rx_{ 0.0 };
+		//! Locations of the contacted and user's stations: one derived from the prefix is not cached.
+		lat_long_t location_[2];
+		//! Sources of \ref location_.
+		location_t location_source_[2]{ LOC_NONE, LOC_NONE };
+		//! DXCC as a number.
+		int dxcc_{ 0 };
+
+		//! The text of the file the record was read from, while it has fields not yet decoded.
+		std::shared_ptr<const std::string> raw_buffer_;
+		//! The ADIF text of the record, or nullptr if all its fields have been decoded.
+		const char* raw_text_{ nullptr };
+		//! Length of the ADIF text.
+		size_t raw_length_{ 0 };
 
 	public:
 		//! Avoid reporting errors too many times
 		static bool inhibit_error_reporting_;
+		//! Held while the fields of any record are being changed if \ref lock_writes_ is set.
+		
+		//! Records in the log are only changed in the main thread: another thread reading them
+		//! (e.g. the background save) holds this to see each record in a consistent state.
+		static std::mutex write_mutex_;
+		//! Set while another thread may be reading records in the log.
+		static std::atomic<bool> lock_writes_;
+
+	protected:
+		//! field_desc_t by field_id_t - replaced, not changed, by describe_fields().
+		static std::shared_ptr<const std::vector<field_desc_t> > descriptors_;
+		//! The item_policy of this thread.
+		static thread_local item_policy* policy_;
 
 	};
 
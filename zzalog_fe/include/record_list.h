@@ -0,0 +1,185 @@
+#ifndef __RECORD_LIST__
+#define __RECORD_LIST__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+	class record;
+	typedef uint64_t qso_id_t;   // QSO identifier
+
+	//! This class holds a sequence of QSO records with the parts of the std::vector interface used by book.
+
+	//! The records are held in chunks of up to \ref CHUNK_MAX, with the index of the first record
+	//! in each chunk. Inserting or deleting a record moves only the records after it in its chunk
+	//! and adjusts the chunk indices, rather than moving every record after it in the book.
+	//! A record is found by its index with a binary search of the chunk indices.
+	//! A record is found by its identifier, record::id(), from the chunk holding it: each
+	//! chunk has a label that does not change as chunks are added or removed before it.
+	//! As with std::vector, inserting or deleting a record invalidates the iterators.
+	//! The records must not be replaced through the iterators, as that bypasses the index.
+	class record_list
+	{
+	public:
+		typedef record* value_type;
+		typedef size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef record*& reference;
+		typedef record* const& const_reference;
+
+		//! Random-access iterator over a record_list: \p CONST is true for a const_iterator.
+		template <bool CONST>
+		class iterator_t
+		{
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef record* value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef typename std::conditional<CONST, record* const&, record*&>::type reference;
+			typedef typename std::conditional<CONST, record* const*, record**>::type pointer;
+
+			iterator_t() {}
+			iterator_t(const record_list* list, size_t chunk, size_t offset) :
+				list_(list), chunk_(chunk), offset_(offset) {}
+			//! An iterator converts to a const_iterator.
+			template <bool C2, typename = typename std::enable_if<CONST || !C2>::type>
+			iterator_t(const iterator_t<C2>& rhs) : list_(rhs.list_), chunk_(rhs.chunk_), offset_(rhs.offset_) {}
+
+			reference operator*() const { return const_cast<record*&>(list_->chunks_[chunk_][offset_]); }
+			pointer operator->() const { return &**this; }
+			reference operator[](difference_type n) const { return *(*this + n); }
+			iterator_t& operator++() {
+				if (++offset_ == list_->chunks_[chunk_].size()) {
+					chunk_++;
+					offset_ = 0;
+				}
+				return *this;
+			}
+			iterator_t operator++(int) { iterator_t was = *this; ++*this; return was; }
+			iterator_t& operator--() {
+				if (offset_ == 0) {
+					chunk_--;
+					offset_ = list_->chunks_[chunk_].size();
+				}
+				offset_--;
+				return *this;
+			}
+			iterator_t operator--(int) { iterator_t was = *this; --*this; return was; }
+			iterator_t& operator+=(difference_type n) { return *this = list_->locate<CONST>(index() + n); }
+			iterator_t& operator-=(difference_type n) { return *this = list_->locate<CONST>(index() - n); }
+			iterator_t operator+(difference_type n) const { return list_->locate<CONST>(index() + n); }
+			iterator_t operator-(difference_type n) const { return list_->locate<CONST>(index() - n); }
+			friend iterator_t operator+(difference_type n, const iterator_t& it) { return it + n; }
+			template <bool C2>
+			difference_type operator-(const iterator_t<C2>& rhs) const { return (difference_type)index() - (difference_type)rhs.index(); }
+			template <bool C2>
+			bool operator==(const iterator_t<C2>& rhs) const { return chunk_ == rhs.chunk_ && offset_ == rhs.offset_; }
+			template <bool C2>
+			bool operator!=(const iterator_t<C2>& rhs) const { return !(*this == rhs); }
+			template <bool C2>
+			bool operator<(const iterator_t<C2>& rhs) const { return index() < rhs.index(); }
+			template <bool C2>
+			bool operator>(const iterator_t<C2>& rhs) const { return index() > rhs.index(); }
+			template <bool C2>
+			bool operator<=(const iterator_t<C2>& rhs) const { return index() <= rhs.index(); }
+			template <bool C2>
+			bool operator>=(const iterator_t<C2>& rhs) const { return index() >= rhs.index(); }
+			//! Returns the index of the record in the list.
+			size_t index() const { return list_->starts_[chunk_] + offset_; }
+
+		protected:
+			friend class record_list;
+			template <bool C2> friend class iterator_t;
+			//! The list.
+			const record_list* list_{ nullptr };
+			//! The chunk holding the record - the number of chunks at end().
+			size_t chunk_{ 0 };
+			//! The position of the record in its chunk.
+			size_t offset_{ 0 };
+		};
+		typedef iterator_t<false> iterator;
+		typedef iterator_t<true> const_iterator;
+
+		record_list();
+
+		iterator begin() { return iterator(this, 0, 0); }
+		iterator end() { return iterator(this, chunks_.size(), 0); }
+		const_iterator begin() const { return const_iterator(this, 0, 0); }
+		const_iterator end() const { return const_iterator(this, chunks_.size(), 0); }
+		//! Returns the number of records.
+		size_t size() const { return starts_.back(); }
+		//! Returns true if there are no records.
+		bool empty() const { return chunks_.empty(); }
+		//! Returns the record at index \p pos: throws std::out_of_range if there is none.
+		reference at(size_t pos);
+		const_reference at(size_t pos) const;
+		reference operator[](size_t pos) { return *locate<false>(pos); }
+		const_reference operator[](size_t pos) const { return *locate<true>(pos); }
+		reference front() { return chunks_.front().front(); }
+		const_reference front() const { return chunks_.front().front(); }
+		reference back() { return chunks_.back().back(); }
+		const_reference back() const { return chunks_.back().back(); }
+
+		//! Insert \p qso before \p pos: returns the position of the inserted record.
+		iterator insert(const_iterator pos, record* qso);
+		//! Insert the records from \p first to \p last before \p pos.
+		template <class InputIt>
+		iterator insert(const_iterator pos, InputIt first, InputIt last) {
+			size_t index = pos.index();
+			for (size_t ix = index; first != last; first++, ix++) {
+				insert(locate<true>(ix), *first);
+			}
+			return locate<false>(index);
+		}
+		//! Remove the record at \p pos: returns the position of the next record.
+		iterator erase(const_iterator pos);
+		//! Append \p qso.
+		void push_back(record* qso);
+		//! Remove all the records.
+		void clear();
+		//! Exchange the records with those in \p records.
+		void swap(std::vector<record*>& records);
+		//! Returns the index of the record with identifier \p id: (size_t)-1 if it is not in the list.
+		size_t find_id(qso_id_t id) const;
+
+	protected:
+		//! Returns the iterator for the record at index \p pos - end() if \p pos is the size.
+		template <bool CONST>
+		iterator_t<CONST> locate(size_t pos) const {
+			if (pos >= size()) return iterator_t<CONST>(this, chunks_.size(), 0);
+			// The last chunk that starts at or before the position
+			size_t chunk = std::upper_bound(starts_.begin(), starts_.end() - 1, pos) - starts_.begin() - 1;
+			return iterator_t<CONST>(this, chunk, pos - starts_[chunk]);
+		}
+		//! Add \p count to the starts of the chunks after \p chunk.
+		void move_starts(size_t chunk, std::ptrdiff_t count);
+		//! Add a chunk at \p chunk holding \p records, giving it a new label - \ref starts_ is not changed.
+		void add_chunk(size_t chunk, std::vector<record*>&& records);
+		//! Remove the (empty) chunk at \p chunk.
+		void remove_chunk(size_t chunk);
+		//! Set the index of the chunks from \p chunk onwards by their label.
+		void renumber(size_t chunk);
+
+		//! Maximum number of records in a chunk: a larger one is split.
+		static const size_t CHUNK_MAX = 512;
+		//! Number of records in each chunk when the list is filled from a std::vector.
+		static const size_t CHUNK_FILL = CHUNK_MAX / 2;
+
+		//! The records - no chunk is empty.
+		std::vector<std::vector<record*> > chunks_;
+		//! The index of the first record in each chunk, followed by the number of records.
+		std::vector<size_t> starts_;
+		//! The label of each chunk.
+		std::vector<uint32_t> labels_;
+		//! The index of each chunk by its label - labels are not reused until the list is cleared.
+		std::vector<size_t> chunk_of_label_;
+		//! The label of the chunk holding each record, by record::id().
+		std::unordered_map<qso_id_t, uint32_t> id_labels_;
+	};
+
+#endif
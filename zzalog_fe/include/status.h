@@ -67,6 +67,9 @@ class banner;
 	enum object_t : char;
 
 	//! This class provides the means of managing status and progress for ZZALOG.
+
+	//! Without a banner (the headless benchmark) the messages are written to the console
+	//! and progress is not shown.
 	class status 
 	{
 	public:
@@ -5,6 +5,7 @@
 #include "fields.h"
 #include "drawing.h"
 
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <FL/Fl_Tabs.H>
@@ -12,6 +13,7 @@
 class book;
 enum hint_t : uchar;
 typedef size_t qso_num_t;
+typedef uint64_t qso_id_t;
 
 
 
@@ -65,6 +67,13 @@ typedef size_t qso_num_t;
 		void add_view(const char* label, field_app_t column_data, object_t object, const char* tooltip);
 		//! Configure the tabs: change the label font used for the selected tab and unselected tabs.
 		void enable_widgets();
+		//! Returns the identifier of the QSO record with index \p record_num in the full log, 0 if none.
+		qso_id_t qso_id(qso_num_t record_num);
+		//! Returns the index now of the QSO remembered as \p id and \p record_num.
+		
+		//! Records may have been inserted or deleted before the view is shown:
+		//! \p record_num is used if the QSO is no longer in the full log.
+		qso_num_t last_record(qso_id_t id, qso_num_t record_num);
 		//! An entry that describes a tab as a view object and as a Fl_Widget object.
 		struct view_ptrs {
 			view* v;
@@ -76,6 +85,10 @@ typedef size_t qso_num_t;
 		qso_num_t last_record_1_;
 		//! Last QSO record index sent as record_2.
 		qso_num_t last_record_2_;
+		//! Identifier of the QSO record sent as record_1 - 0 if it is not in the full log.
+		qso_id_t last_qso_1_;
+		//! Identifier of the QSO record sent as record_2 - 0 if it is not in the full log.
+		qso_id_t last_qso_2_;
 		//! Last hint type (when switching between view) for query
 		hint_t last_hint_;
 		//! Last book (switching in/out of different books) for query
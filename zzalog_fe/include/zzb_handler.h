@@ -0,0 +1,84 @@
+#ifndef __ZZB_HANDLER__
+#define __ZZB_HANDLER__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class book;
+class record;
+
+	//! This class reads and writes the binary snapshot (.zzb) of the main log.
+
+	//! The snapshot is written next to the .adi log file after each successful save.
+	//! It holds the field names and the values in pools indexed by number, each record
+	//! as pairs of these indices with its precomputed timestamp, and the worked-before
+	//! summary tables of the book. It is used when loading the log if it was written from
+	//! the current version of the .adi file, which remains the source of the data.
+	//! All items are fixed-size integers or counted strings at offsets within the file,
+	//! so it is decoded from a single buffer without parsing.
+	class zzb_handler
+	{
+	public:
+		//! Constructor.
+		zzb_handler();
+		//! Destructor.
+		~zzb_handler();
+
+		//! Returns the snapshot filename for the log file \p log_filename.
+		static std::string filename(const std::string& log_filename);
+		//! Remove the snapshot for \p log_filename - e.g. if it no longer matches the log.
+		static void remove(const std::string& log_filename);
+		//! Encode the worked-before tables of \p b - called in the main thread before the save starts.
+		void add_tables(book* b);
+		//! Write the snapshot of the log after it has been written to \p log_filename.
+
+		//! This is called from the background save std::thread: each record is read
+		//! while holding record::write_mutex_.
+		//! \param log_filename the .adi file just written.
+		//! \param header header record.
+		//! \param records the records in the order they are in the book.
+		//! \return true if the snapshot was written.
+		bool store_book(const std::string& log_filename, record* header, const std::vector<record*>& records);
+		//! Load the book \p b from the snapshot of \p log_filename.
+
+		//! \return false if there is no snapshot or it does not match the log file -
+		//! nothing has then been added to \p b.
+		bool load_book(book* b, const std::string& log_filename);
+
+	protected:
+		//! Returns the index of \p field in the field name pool, adding it if necessary.
+		uint32_t field_id(const std::string& field);
+		//! Returns the index of \p value in the value pool, adding it if necessary.
+		uint32_t string_id(const std::string& value);
+		//! Append \p value to \p out.
+		static void put_int(std::string& out, uint32_t value);
+		//! Append \p value to \p out.
+		static void put_int64(std::string& out, int64_t value);
+		//! Append \p value to \p out preceded by its length.
+		static void put_string(std::string& out, const std::string& value);
+		//! Read an integer from \p pos and advance it: returns false if \p end is reached.
+		static bool get_int(const char*& pos, const char* end, uint32_t& value);
+		//! Read an integer from \p pos and advance it: returns false if \p end is reached.
+		static bool get_int64(const char*& pos, const char* end, int64_t& value);
+		//! Read a counted string from \p pos and advance it: returns false if \p end is reached.
+		static bool get_string(const char*& pos, const char* end, std::string& value);
+		//! Read the size and modification time of \p log_filename.
+		static bool file_stamp(const std::string& log_filename, int64_t& size, int64_t& time);
+		//! Returns the timestamp of a reference time - it changes if the way timestamps are calculated does.
+		static int64_t zone_stamp();
+
+		//! Field names by index.
+		std::vector<std::string> fields_;
+		//! Index of each field name.
+		std::unordered_map<std::string, uint32_t> field_ids_;
+		//! Values by index.
+		std::vector<std::string> strings_;
+		//! Index of each value.
+		std::unordered_map<std::string, uint32_t> string_ids_;
+		//! The encoded worked-before tables.
+		std::string tables_;
+	};
+
+#endif
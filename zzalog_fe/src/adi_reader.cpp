@@ -12,17 +12,30 @@
 #include <fstream>
 #include <string>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 
 #include <FL/Fl.H>
 #include <FL/fl_ask.H>
 #include <FL/fl_draw.H>
 
+// Files smaller than this are decoded in the main thread
+const size_t MIN_PARALLEL_BYTES = 1 << 20;
+// Minimum number of records worth giving to a worker thread
+const size_t MIN_CHUNK_RECORDS = 1000;
+
 // Helper class that reads and decodes an ADIF .adi format file and stores it a book container
 adi_reader::adi_reader()
 	: expecting_header_(false)
 	, my_book_(nullptr)
 	, number_records_(0)
 	, record_count_(0)
+	, defer_messages_(false)
+	, lazy_(false)
+	, expanding_(false)
+	, worker_(false)
 {
 }
 
@@ -31,230 +44,422 @@ adi_reader::~adi_reader()
 {
 }
 
+// Read the remainder of the stream into a single buffer
+bool adi_reader::read_buffer(std::istream& in, std::string& buffer) {
+	if (!in.good()) return false;
+	buffer.clear();
+	// Size the buffer from the stream length if the stream supports it
+	std::istream::pos_type start = in.tellg();
+	if (start != std::istream::pos_type(-1)) {
+		in.seekg(0, std::ios::end);
+		std::istream::pos_type finish = in.tellg();
+		in.seekg(start);
+		if (finish != std::istream::pos_type(-1) && finish > start) {
+			buffer.reserve((size_t)(finish - start));
+		}
+	}
+	// Read it in large blocks directly from the stream buffer
+	char chunk[65536];
+	std::streamsize count;
+	while ((count = in.rdbuf()->sgetn(chunk, sizeof(chunk))) > 0) {
+		buffer.append(chunk, (size_t)count);
+	}
+	in.setstate(std::ios::eofbit);
+	return true;
+}
+
+// Get the number of characters used by the value - a lone LF counts as two characters
+size_t adi_reader::value_extent(std::string_view raw, unsigned int count) {
+	size_t len = std::min<size_t>(count, raw.length());
+	if (memchr(raw.data(), '\n', len) == nullptr) {
+		return len;
+	}
+	size_t ix = 0;
+	char prev = '\0';
+	for (unsigned int u = 0; u < count && ix < raw.length(); u++) {
+		char c = raw[ix++];
+		if (c == '\n' && prev != '\r') u += 1;
+		prev = c;
+	}
+	return ix;
+}
+
+// Copy value - the ADIF count assumes CR/LF pairs, so a lone LF counts as two characters
+size_t adi_reader::copy_value(std::string_view raw, unsigned int count, std::string& value) {
+	size_t len = std::min<size_t>(count, raw.length());
+	// Fast path - no LF in the value so it can be copied as is
+	if (memchr(raw.data(), '\n', len) == nullptr) {
+		value.assign(raw.data(), len);
+		return len;
+	}
+	len = value_extent(raw, count);
+	value.clear();
+	value.reserve(count);
+	char prev = '\0';
+	for (size_t ix = 0; ix < len; ix++) {
+		char c = raw[ix];
+		// Expand LF to CR/LF
+		if (c == '\n' && prev != '\r') value += '\r';
+		value += c;
+		prev = c;
+	}
+	return len;
+}
+
+// Find the end of the record - uses the lengths in the tags so that <EOR> in a value is ignored
+const char* adi_reader::skip_record(const char* pos, const char* end) {
+	const char* p = pos;
+	while (p < end) {
+		const char* lt = (const char*)memchr(p, '<', end - p);
+		if (lt == nullptr) return end;
+		// Read the name until : or > restarting at any <
+		const char* name = lt + 1;
+		p = name;
+		while (p < end && *p != ':' && *p != '>') {
+			if (*p == '<') name = p + 1;
+			p++;
+		}
+		if (p == end) return end;
+		if (*p == '>') {
+			p++;
+			if (p - name == 4 && toupper(name[0]) == 'E' && toupper(name[1]) == 'O' && toupper(name[2]) == 'R') {
+				return p;
+			}
+		}
+		else {
+			// Read the length and skip the value
+			p++;
+			unsigned int count = 0;
+			while (p < end && *p >= '0' && *p <= '9') {
+				count = (count * 10) + *p - '0';
+				p++;
+			}
+			while (p < end && *p != '>') p++;
+			if (p == end) return end;
+			p++;
+			p += value_extent(std::string_view(p, end - p), count);
+		}
+	}
+	return end;
+}
+
+// Report the message now or hold it for the main thread
+void adi_reader::report(status_t status, const char* message, const std::string& app_field) {
+	if (defer_messages_) {
+		deferred_.push_back({ status, message, app_field });
+	}
+	else {
+		status_->misc_status(status, message);
+	}
+}
+
 // Load Record.
 // Data is read off the input stream (in) and stored as an array of ADIF items in the record.
+// Only the text of this record is read so the stream is left after it.
 std::istream& adi_reader::load_record(record* in_record, std::istream& in, load_result_t& result) {
+	std::string buffer;
+	if (!read_record_text(in, buffer, in_record->is_header())) {
+		result = LR_BAD;
+		return in;
+	}
+	const char* pos = buffer.data();
+	load_record(in_record, pos, pos + buffer.length(), result);
+	return in;
+}
 
-	// Read the first character
-	char c;
-	in.get(c);
+// Read the stream up to the <EOR> (or <EOH> for the header) that ends the record
+bool adi_reader::read_record_text(std::istream& in, std::string& buffer, bool header) {
+	if (!in.good()) return false;
+	buffer.clear();
+	std::streambuf* sb = in.rdbuf();
+	// Start of the tag being read - restarted at any <
+	size_t tag = std::string::npos;
+	int c;
+	while ((c = sb->sbumpc()) != EOF) {
+		buffer += (char)c;
+		if (c == '<') {
+			tag = buffer.length() - 1;
+		}
+		else if (c == '>' && tag != std::string::npos) {
+			std::string_view name(buffer.data() + tag + 1, buffer.length() - tag - 2);
+			tag = std::string::npos;
+			size_t colon = name.find(':');
+			if (colon == std::string_view::npos) {
+				if (name.length() == 3 && (toupper(name[0]) == 'E' && toupper(name[1]) == 'O' &&
+					(toupper(name[2]) == 'R' || (header && toupper(name[2]) == 'H')))) {
+					return true;
+				}
+				continue;
+			}
+			// Read the value so that any < or > in it is not taken as a tag
+			unsigned int count = 0;
+			for (size_t ix = colon + 1; ix < name.length() && name[ix] >= '0' && name[ix] <= '9'; ix++) {
+				count = (count * 10) + name[ix] - '0';
+			}
+			// A lone LF counts as two characters
+			char prev = '\0';
+			for (unsigned int u = 0; u < count && (c = sb->sbumpc()) != EOF; u++) {
+				buffer += (char)c;
+				if (c == '\n' && prev != '\r') u += 1;
+				prev = (char)c;
+			}
+		}
+	}
+	in.setstate(std::ios::eofbit);
+	return true;
+}
 
-	// Initialise header 
-	std::string header = "";
-	bool eor = false;
+// Load Record.
+// Data is decoded from the buffer between pos and end and stored as an array of ADIF items in the record.
+// pos is left after the <EOR> or <EOH> that terminates the record.
+void adi_reader::load_record(record* in_record, const char*& pos, const char* end, load_result_t& result) {
 	result = LR_GOOD;
-	std::string bad_field = "";
+	bool eor = false;
 
 	// Only the header won't not start with a < character
 	// Read upto the next < character or EOF
-	while (c != '<' && in.good()) {
-		// Capture all upto first < as header comment
-		header += c;
-		in.get(c);
+	const char* lt = (const char*)memchr(pos, '<', end - pos);
+	if (lt == nullptr) {
+		// EOF => just read any characters after last record
+		lt = end;
+		result = LR_EOF;
 	}
-
-	// EOF => just read any characters after last record
-	if (in.eof()) result = LR_EOF;
-	else if (!in.good()) result = LR_BAD;
-
 	// If this contains any character and we are looking for a header - treat this as a header 
-	if (expecting_header_ == true && header.length() > 0) {
-		in_record->header(header);
+	if (expecting_header_ == true && lt > pos) {
+		in_record->header(std::string(pos, lt - pos));
 	}
+	pos = lt;
 
 	// now turn off header checking
 	expecting_header_ = false;
+	// Start of the record text and whether any fields have been left undecoded
+	const char* start = pos;
+	bool skipped = false;
 	std::string field;
 	field.reserve(20);
 	std::string value;
 	value.reserve(50);
-	std::string old_value;
-	old_value.reserve(50);
 
-	// Until the end of record indicated by <EOR> or <EOH> - note in.good() is continually 
-	// checked to prevent running off the end
-	while (in.good() && !eor) {
+	// Until the end of record indicated by <EOR> or <EOH>
+	while (pos < end && !eor) {
 		// Each ADIF item is "<NAME:l[:T]>VALUE    " until <EOR> or <EOH>
-		field = "";
-		value = "";
-		old_value = "";
-		// Until : or > is read
-		in.get(c);
-		while (c != ':' && c != '>' && in.good()) {
-			if (c == '<') field = "";
-			else {
-				field += (char)toupper(c);
-			}
-			in.get(c);
+		// pos is at a < - read the name until : or > is read, restarting the name at any <
+		const char* name = pos + 1;
+		const char* p = name;
+		while (p < end && *p != ':' && *p != '>') {
+			if (*p == '<') name = p + 1;
+			p++;
+		}
+		if (p == end) {
+			result = LR_BAD;
+			pos = end;
+			break;
 		}
-		if (!in.good()) result = LR_BAD;
 		// convert field name to upper-case
+		field.assign(name, p - name);
+		for (auto& c : field) c = (char)toupper(c);
+		bool has_length = (*p == ':');
+		p++;
 		// If field is <EOH> or <EOR> we have reached the end of the record
 		if (field == "EOH" && in_record->is_header() || field == "EOR") {
 			eor = true;
+			pos = p;
+			continue;
 		}
 		// Set read fail if we see EOH for a non-header record
-		if (field == "EOH" && !in_record->is_header()) {
-			status_->misc_status(ST_ERROR, "LOG: <EOH> found when not expecting it!");
+		if (field == "EOH") {
+			report(ST_ERROR, "LOG: <EOH> found when not expecting it!");
 			result = LR_BAD;
 		}
-		else {
+		else if (has_length) {
 			// Neither EOR nor EOH - therefore an ADIF item entry-  <NAME:l[:T]>VALUE 
-			if (field != "EOH" && field != "EOR") {
-				unsigned int count = 0;
-				// Default datatype is String
-				char type_indicator = ' ';
-				// Get count the number of characters - first read the colon
-				in.get(c);
-				// now read all numeric characters
-				while (c >= '0' && c <= '9' && in.good()) {
-					count = (count * 10) + c - '0';
-					in.get(c);
-				}
-				// Read any colon
-				while (c == ':' && in.good()) {
-					in.get(c);
-				}
-				// save data type - if '>' read then there wasn't one. This doesn't check that there is only one character
-				while (c != '>' && in.good()) {
-					type_indicator = c;
-					in.get(c);
+			unsigned int count = 0;
+			// Default datatype is String
+			char type_indicator = ' ';
+			// now read all numeric characters
+			while (p < end && *p >= '0' && *p <= '9') {
+				count = (count * 10) + *p - '0';
+				p++;
+			}
+			// Read any colon
+			while (p < end && *p == ':') p++;
+			// save data type - if '>' read then there wasn't one. This doesn't check that there is only one character
+			while (p < end && *p != '>') {
+				type_indicator = *p;
+				p++;
+			}
+			// Read the >
+			if (p < end) p++;
+			if (p == end) {
+				result = LR_EOF;
+				pos = end;
+				break;
+			}
+			if (lazy_ && !in_record->is_header() && !record::decoded_on_load(field)) {
+				// Leave the value to be decoded when it is used
+				p += value_extent(std::string_view(p, end - p), count);
+				if (p == end) {
+					result = LR_EOF;
 				}
-				// Read the >
-				in.get(c);
-				if (!in.good()) if (in.eof()) result = LR_EOF; else result = LR_BAD;
+				if (count > 0) skipped = true;
+			}
+			else {
 				// Read data item value
-				for (unsigned int u = 0; u < count && in.good(); u++) {
-					// adjust number of bytes read as count assumes CR/LF pairs.
-					if (c == '\n' && (value.length() == 0 || value.back() != '\r')) {
-						value += '\r';
-						u += 1;
-					}
-					value += c;
-					in.get(c);
+				p += copy_value(std::string_view(p, end - p), count, value);
+				if (p == end) {
+					result = LR_EOF;
 				}
-				if (!in.good()) if (in.eof()) result = LR_EOF; else result = LR_BAD;
-				else {
-					// Ignore all data until next < (or EOF) - ADIF says ignore, LotW uses it as annotation
-					while (c != '<' && in.good()) {
-						in.get(c);
-					}
-					// now create the hash-pair if length non-zero
-					if (count > 0 && in.good()) {
-						// Start assuming it's a valid field
-						enum valid_code {
-							VC_NO_ERROR,
-							VC_IGNORED_APP,
-							VC_INVALID_USERDEF,
-							VC_INVALID_TYPE,
-							VC_DUPLICATE
-						} validity = VC_NO_ERROR;
-						// Add User defined fields to the reference data base if found in a header
-						// <USERDEFn:sz:ty>name[,{std::list or range}]
-						if (in_record->is_header() && field.length() > 7 && field.substr(0, 7) == "USERDEF") {
-							std::string list_range = "";
-							int pos_comma = value.find(',');
-							if (pos_comma != -1) {
-								list_range = value.substr(pos_comma + 2, value.length() - pos_comma - 3);
-								value = value.substr(0, pos_comma);
-							}
-							int id_userdef = std::stoi(field.substr(7));
-							if (!spec_data_->add_userdef(id_userdef, value, type_indicator, list_range)) {
-								validity = VC_INVALID_USERDEF;
-							}
-						}
-						// Add application defined field to the reference data base 
-						// <APP_[PROG_ID]:sz[:ty]>value
-						if (field.length() > 3 && field.substr(0, 3) == "APP") {
-							// Convert any legacy APP_ZZALOG_... to APP_ZZA_.... Set modified to save the book at the end of load
-							if (field.length() > 11 && field.substr(0, 11) == "APP_ZZALOG_") {
-								std::string part2 = field.substr(11);
-								field = "APP_ZZA_" + part2;
-							}
-							// Ignore all non-ZZALOG app specific fields (except APP_EQSL_SWL and any in the header.
-							if (field.substr(0, 8) != "APP_ZZA_" && !in_record->is_header()) {
-								if (field == "APP_EQSL_SWL") {
-									field = "SWL";
-									// Also don't ignore APP_QRZLOG_LOGID as we need these to progress
-									// QRZ.com downloads - ignore them in import_data::convert_update
-								} else if (field.substr(0,11) != "APP_QRZLOG_") {
-									validity = VC_IGNORED_APP;
-								}
-							}
-						}
-						// If the data type is not valid then the field isn't
-						if (validity == VC_NO_ERROR && spec_data_->datatype(field).length() == 0) {
-							validity = VC_INVALID_TYPE;
-						}
-						// Multiple instances of field
-						if (validity == VC_NO_ERROR && in_record->item(field) != "" &&
-							in_record->item(field) != value) {
-							validity = VC_DUPLICATE;
-							old_value = in_record->item(field);
-						}
-						// If the user or app. defined field is valid or it's an ADIF defined field
-						if (validity == VC_NO_ERROR || validity == VC_DUPLICATE) {
-							// Get the expected datatype
-							char data_type_indicator = spec_data_->datatype_indicator(field);
-							// All enumerated values are treated as upper-case (except band)
-							if (field == "BAND" || field == "BAND_RX") {
-								value = to_lower(value);
-							}
-							else if (data_type_indicator == 'E') {
-								value = to_upper(value);
-							}
-							// Add the item to the record
-							in_record->item(field, value, false);
-						}
-						else {
-							bad_field = field;
-						}
-						// Report if an error case has been seen
-						char message[200];
-						switch (validity) {
-						case VC_IGNORED_APP:
-							if (known_app_fields.find(bad_field) == known_app_fields.end()) {
-								sprintf(message, "LOG: %s %s %s - field ignored %s",
-									in_record->item("QSO_DATE").c_str(),
-									in_record->item("TIME_ON").c_str(),
-									in_record->item("CALL").c_str(),
-									bad_field.c_str());
-								status_->misc_status(ST_WARNING, message);
-								known_app_fields.insert(bad_field);
-							}
-							break;
-						case VC_INVALID_TYPE:
-						case VC_INVALID_USERDEF:
-							sprintf(message, "LOG: %s %s %s - invalid field %s",
-								in_record->item("QSO_DATE").c_str(),
-								in_record->item("TIME_ON").c_str(),
-								in_record->item("CALL").c_str(),
-								bad_field.c_str());
-							status_->misc_status(ST_ERROR, message);
-							break;
-						case VC_DUPLICATE:
-							sprintf(message, "LOG: %s %s %s - VC_DUPLICATE field %s: was %s is %s",
-								in_record->item("QSO_DATE").c_str(),
-								in_record->item("TIME_ON").c_str(),
-								in_record->item("CALL").c_str(),
-								bad_field.c_str(),
-								old_value.c_str(),
-								value.c_str());
-							status_->misc_status(ST_WARNING, message);
-							break;
-						default:
-							break;
-						}
-					}
+				// now create the hash-pair if length non-zero
+				if (count > 0) {
+					store_item(in_record, field, value, type_indicator);
 				}
 			}
 		}
+		// Ignore all data until next < (or EOF) - ADIF says ignore, LotW uses it as annotation
+		lt = (const char*)memchr(p, '<', end - p);
+		pos = lt ? lt : end;
+	}
+	if (!eor && result == LR_GOOD) {
+		// Ran out of data before the end of the record
+		result = LR_EOF;
+	}
+	if (skipped) {
+		in_record->raw_text(buffer_, start, pos - start);
+	}
+}
+
+// Decode all the fields of a record left undecoded when the log was loaded
+void adi_reader::expand_record(record* in_record, const char* text, size_t length, bool report) {
+	expanding_ = true;
+	defer_messages_ = true;
+	load_result_t result;
+	const char* pos = text;
+	load_record(in_record, pos, text + length, result);
+	// Ignored application-defined fields were reported when the log was loaded
+	if (report) {
+		for (auto& msg : deferred_) {
+			if (msg.app_field.empty()) status_->misc_status(msg.status, msg.text.c_str());
+		}
+	}
+	deferred_.clear();
+}
+
+// Validate the field and add it to the record
+void adi_reader::store_item(record* in_record, std::string& field, std::string& value, char type_indicator) {
+	// Start assuming it's a valid field
+	enum valid_code {
+		VC_NO_ERROR,
+		VC_IGNORED_APP,
+		VC_INVALID_USERDEF,
+		VC_INVALID_TYPE,
+		VC_DUPLICATE
+	} validity = VC_NO_ERROR;
+	std::string bad_field = "";
+	std::string old_value = "";
+	// Add User defined fields to the reference data base if found in a header
+	// <USERDEFn:sz:ty>name[,{std::list or range}]
+	if (in_record->is_header() && field.length() > 7 && field.compare(0, 7, "USERDEF") == 0) {
+		std::string list_range = "";
+		int pos_comma = value.find(',');
+		if (pos_comma != -1) {
+			list_range = value.substr(pos_comma + 2, value.length() - pos_comma - 3);
+			value = value.substr(0, pos_comma);
+		}
+		int id_userdef = std::stoi(field.substr(7));
+		if (!spec_data_->add_userdef(id_userdef, value, type_indicator, list_range)) {
+			validity = VC_INVALID_USERDEF;
+		}
+	}
+	// Add application defined field to the reference data base 
+	// <APP_[PROG_ID]:sz[:ty]>value
+	if (field.length() > 3 && field.compare(0, 3, "APP") == 0) {
+		// Convert any legacy APP_ZZALOG_... to APP_ZZA_.... Set modified to save the book at the end of load
+		if (field.length() > 11 && field.compare(0, 11, "APP_ZZALOG_") == 0) {
+			std::string part2 = field.substr(11);
+			field = "APP_ZZA_" + part2;
+		}
+		// Ignore all non-ZZALOG app specific fields (except APP_EQSL_SWL and any in the header.
+		if (field.compare(0, 8, "APP_ZZA_") != 0 && !in_record->is_header()) {
+			if (field == "APP_EQSL_SWL") {
+				field = "SWL";
+				// Also don't ignore APP_QRZLOG_LOGID as we need these to progress
+				// QRZ.com downloads - ignore them in import_data::convert_update
+			} else if (field.compare(0, 11, "APP_QRZLOG_") != 0) {
+				validity = VC_IGNORED_APP;
+			}
+		}
+	}
+	// If the data type is not valid then the field isn't
+	if (validity == VC_NO_ERROR && spec_data_->datatype(field).length() == 0) {
+		validity = VC_INVALID_TYPE;
+	}
+	// Multiple instances of field
+	if (validity == VC_NO_ERROR) {
+		auto it_old = in_record->find(field);
+		if (it_old != in_record->end() && it_old->second.length() && it_old->second != value) {
+			validity = VC_DUPLICATE;
+			old_value = it_old->second;
+			bad_field = field;
+		}
+	}
+	// If the user or app. defined field is valid or it's an ADIF defined field
+	if (validity == VC_NO_ERROR || validity == VC_DUPLICATE) {
+		// Get the expected datatype
+		char data_type_indicator = spec_data_->datatype_indicator(field);
+		// All enumerated values are treated as upper-case (except band)
+		if (field == "BAND" || field == "BAND_RX") {
+			value = to_lower(value);
+		}
+		else if (data_type_indicator == 'E') {
+			value = to_upper(value);
+		}
+		// Add the item to the record - a worker only stores it, as record::item() changes the book
+		if (worker_) in_record->set(field, value);
+		else in_record->item(field, value, false, !expanding_);
+	}
+	else {
+		bad_field = field;
+	}
+	// Report if an error case has been seen
+	char message[200];
+	switch (validity) {
+	case VC_IGNORED_APP:
+		if (known_app_fields.find(bad_field) == known_app_fields.end()) {
+			snprintf(message, sizeof(message), "LOG: %s %s %s - field ignored %s",
+				in_record->item("QSO_DATE").c_str(),
+				in_record->item("TIME_ON").c_str(),
+				in_record->item("CALL").c_str(),
+				bad_field.c_str());
+			report(ST_WARNING, message, bad_field);
+			known_app_fields.insert(bad_field);
+		}
+		break;
+	case VC_INVALID_TYPE:
+	case VC_INVALID_USERDEF:
+		snprintf(message, sizeof(message), "LOG: %s %s %s - invalid field %s",
+			in_record->item("QSO_DATE").c_str(),
+			in_record->item("TIME_ON").c_str(),
+			in_record->item("CALL").c_str(),
+			bad_field.c_str());
+		report(ST_ERROR, message);
+		break;
+	case VC_DUPLICATE:
+		snprintf(message, sizeof(message), "LOG: %s %s %s - VC_DUPLICATE field %s: was %s is %s",
+			in_record->item("QSO_DATE").c_str(),
+			in_record->item("TIME_ON").c_str(),
+			in_record->item("CALL").c_str(),
+			bad_field.c_str(),
+			old_value.c_str(),
+			value.c_str());
+		report(ST_WARNING, message);
+		break;
+	default:
+		break;
 	}
-	return in;
 }
 
 // load data to book
-// Data is read off the input stream (in) and records generated and added to book
+// Data is read off the input stream (in) into a buffer and records generated and added to book
 bool adi_reader::load_book(book* book, std::istream& in) {
 	// Start off eith good status
 	load_result_t result = LR_GOOD;
@@ -271,14 +476,33 @@ bool adi_reader::load_book(book* book, std::istream& in) {
 		return true;
 	}
 	status_->misc_status(ST_NOTE, "LOG: Started loading ADI");
+	// Read the whole file in one go
+	std::shared_ptr<std::string> buffer = std::make_shared<std::string>();
+	if (!read_buffer(in, *buffer)) {
+		fl_cursor(FL_CURSOR_DEFAULT);
+		status_->progress("Load failed", book->book_type());
+		return false;
+	}
+	// Records in the main log keep the text and decode most fields when they are first used
+	lazy_ = book->book_type() == OT_MAIN;
+	if (lazy_) buffer_ = buffer;
+	const char* pos = buffer->data();
+	const char* end = pos + buffer->length();
 	number_records_ = 10000;
 	bool first = true;
+	// Large files are decoded on worker threads once the header has been read - only when loading the main log
+	bool parallel = lazy_ && book->size() == 0 &&
+		buffer->length() >= MIN_PARALLEL_BYTES && std::thread::hardware_concurrency() > 1;
 	// While we have data to read
-	while (in.good() && !closing_) {
+	while (pos < end && !closing_) {
+		if (parallel && !expecting_header_) {
+			load_chunks(book, pos, end);
+			continue;
+		}
 		// Create a new record
 		record* in_record = new record;
-		// Read it from the input stream
-		load_record(in_record, in, result);
+		// Decode it from the buffer
+		load_record(in_record, pos, end, result);
 		if (result == LR_GOOD) {
 			if (in_record->is_header()) {
 				// Store any header as the header record
@@ -291,7 +515,7 @@ bool adi_reader::load_book(book* book, std::istream& in) {
 				// Otherwise add the record in its time-order position in the book
 				book->insert_record(in_record);
 			}
-			if (first) {
+			if (first && !parallel) {
 				status_->progress(number_records_, book->book_type(), "Reading ADIF", "records");
 				first = false;
 			}
@@ -307,10 +531,13 @@ bool adi_reader::load_book(book* book, std::istream& in) {
 			delete in_record;
 		}
 	}
+	// The records now hold the text if they need it
+	buffer_.reset();
+	lazy_ = false;
 	// Restore normal cursor
 	fl_cursor(FL_CURSOR_DEFAULT);
 	// Update progress bar with complete or failed.
-	if (!in.eof()) {
+	if (pos < end) {
 		status_->progress("Load failed", book->book_type());
 		return false;
 	}
@@ -319,6 +546,92 @@ bool adi_reader::load_book(book* book, std::istream& in) {
 	}
 }
 
+// Decode the remaining records on worker threads and merge them into the book
+void adi_reader::load_chunks(book* book, const char*& pos, const char* end) {
+	// Find the start of each record so that the chunks split exactly at <EOR>
+	std::vector<const char*> starts;
+	for (const char* p = pos; p < end && memchr(p, '<', end - p); p = skip_record(p, end)) {
+		starts.push_back(p);
+	}
+	size_t num_records = starts.size();
+	starts.push_back(end);
+	number_records_ = record_count_ + (int)num_records;
+	status_->progress(number_records_, book->book_type(), "Reading ADIF", "records");
+	// One chunk per worker thread
+	size_t num_threads = std::min<size_t>(std::thread::hardware_concurrency(), num_records / MIN_CHUNK_RECORDS + 1);
+	std::vector<adi_reader*> workers;
+	std::vector<std::thread*> threads;
+	std::vector<std::vector<record*> > batches(num_threads);
+	std::atomic<int> decoded(0);
+	std::atomic<int> finished(0);
+	for (size_t ix = 0; ix < num_threads; ix++) {
+		adi_reader* worker = new adi_reader;
+		worker->defer_messages_ = true;
+		worker->worker_ = true;
+		worker->lazy_ = lazy_;
+		worker->buffer_ = buffer_;
+		workers.push_back(worker);
+		const char* chunk_start = starts[num_records * ix / num_threads];
+		// The last chunk includes any text after the last record
+		const char* chunk_end = (ix == num_threads - 1) ? end : starts[num_records * (ix + 1) / num_threads];
+		threads.push_back(new std::thread(thread_run, worker, chunk_start, chunk_end, &batches[ix], &decoded, &finished));
+	}
+	// Report progress from the main thread while the workers decode
+	int reported = record_count_;
+	while (finished < (int)num_threads) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		int value = record_count_ + decoded;
+		if (value != reported) {
+			status_->progress(value, book->book_type());
+			reported = value;
+		}
+	}
+	// Gather the results in file order
+	std::vector<record*> records;
+	for (size_t ix = 0; ix < num_threads; ix++) {
+		threads[ix]->join();
+		delete threads[ix];
+		// Now report the messages held by the worker
+		for (auto& msg : workers[ix]->deferred_) {
+			if (msg.app_field.length()) {
+				if (known_app_fields.find(msg.app_field) != known_app_fields.end()) continue;
+				known_app_fields.insert(msg.app_field);
+			}
+			status_->misc_status(msg.status, msg.text.c_str());
+		}
+		delete workers[ix];
+		records.insert(records.end(), batches[ix].begin(), batches[ix].end());
+	}
+	// The workers stored the fields as read - convert them here, in the main thread
+	for (auto qso : records) qso->normalise();
+	// One ordered merge into the book
+	book->insert_records(records);
+	record_count_ = number_records_;
+	if (reported != number_records_) {
+		status_->progress(number_records_, book->book_type());
+	}
+	if (!closing_) pos = end;
+}
+
+// Decode records in a worker thread
+void adi_reader::thread_run(adi_reader* that, const char* pos, const char* end,
+	std::vector<record*>* records, std::atomic<int>* decoded, std::atomic<int>* finished) {
+	load_result_t result;
+	while (pos < end && !closing_) {
+		record* qso = new record;
+		that->load_record(qso, pos, end, result);
+		if (result == LR_GOOD) {
+			records->push_back(qso);
+		}
+		else {
+			delete qso;
+		}
+		// Trailing text after the last record is not counted
+		if (result != LR_EOF) (*decoded)++;
+	}
+	(*finished)++;
+}
+
 // Calculate the percentage file read
 double adi_reader::progress() {
 	return (double)record_count_ / (double)number_records_;
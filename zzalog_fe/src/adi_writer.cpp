@@ -11,11 +11,14 @@
 
 #include <fstream>
 #include<ostream>
-#include <cmath>
+#include <mutex>
+#include <charconv>
 
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
 
+// Text is written to the output stream in blocks of this size
+const size_t BLOCK_SIZE = 1 << 16;
 
 // Default constructor
 adi_writer::adi_writer()
@@ -23,6 +26,7 @@ adi_writer::adi_writer()
 	clean_records_ = false;
 	out_book_ = nullptr;
 	current_ = 0;
+	filter_ = nullptr;
 }
 
 // Default constructor
@@ -53,16 +57,34 @@ bool adi_writer::store_book(book* out_book, std::ostream& out, bool clean, field
 		}
 	}
 
+	// The records are converted into a single buffer that is written out in large blocks
+	buffer_.clear();
+	buffer_.reserve(2 * BLOCK_SIZE);
+	tags_ = tag_map();
+	filter_ = make_filter(fields);
 	// For all records and while the output is successful
 	if (out_book->header()) {
-		store_record(out_book->header(), out, result, nullptr);
+		// The header always has all its fields
+		field_set* filter = filter_;
+		filter_ = nullptr;
+		store_record(out_book->header(), out, result);
+		filter_ = filter;
 		status_->progress(1, out_book->book_type());
 	}
 	for (current_ = 0; current_ < out_book->size() && result; current_++) {
 		// Output the record
-		store_record(out_book->get_record(current_, false), out, result, fields);
+		store_record(out_book->get_record(current_, false), out, result);
 		status_->progress(current_ + 1, out_book->book_type());
 	}
+	if (result) {
+		out.write(buffer_.data(), buffer_.length());
+		out.flush();
+		result = out.good();
+	}
+	buffer_.clear();
+	buffer_.shrink_to_fit();
+	delete filter_;
+	filter_ = nullptr;
 	// Update the progress bar with complete or failed
 	if (result) {
 		status_->progress(out_book->size() + 1, out_book->book_type());
@@ -78,119 +100,216 @@ bool adi_writer::store_book(book* out_book, std::ostream& out, bool clean, field
 	return result;
 }
 
-// write record to output stream. If fields is not null, then only these fields. Output result not used
-std::ostream& adi_writer::store_record(record* record, std::ostream& out, bool& result, field_list* fields /* = nullptr */) {
+// Make the tags for all the fields known - called in the main std::thread before the background save
+void adi_writer::add_tags() {
+	tags_ = tag_map();
+	tags_.tags.resize(field_registry::count());
+	for (size_t id = 0; id < tags_.tags.size(); id++) {
+		make_tag(field_registry::name((field_id_t)id), tags_.tags[id]);
+	}
+	tags_.complete = true;
+}
+
+// write header and records to output stream - called from the background save std::thread
+bool adi_writer::store_records(record* header, const std::vector<record*>& records, std::ostream& out) {
+	// Each record is converted into this buffer while it cannot be changed, and the buffer
+	// is written out in blocks, so that edits in the main std::thread do not wait for the disk
+	std::string buffer;
+	buffer.reserve(2 * BLOCK_SIZE);
+	if (header) {
+		append_record(buffer, header, nullptr, false, tags_);
+	}
+	for (auto it = records.begin(); it != records.end() && out.good(); it++) {
+		// A record with fields not yet decoded is copied and decoded after releasing the mutex
+		record copy;
+		{
+			std::lock_guard<std::mutex> lock(record::write_mutex_);
+			if ((*it)->is_lazy()) {
+				(*it)->lazy_copy(copy);
+			}
+			else {
+				append_record(buffer, *it, nullptr, false, tags_);
+			}
+		}
+		if (copy.is_lazy()) {
+			copy.expand(false);
+			append_record(buffer, &copy, nullptr, false, tags_);
+		}
+		if (buffer.length() >= BLOCK_SIZE) {
+			out.write(buffer.data(), buffer.length());
+			buffer.clear();
+		}
+	}
+	out.write(buffer.data(), buffer.length());
+	out.flush();
+	return out.good();
+}
+
+// write record to output stream. If filter_ is not null, then only these fields. 
+std::ostream& adi_writer::store_record(record* record, std::ostream& out, bool& result) {
 	// convert to text
-	to_adif(record, out, fields);
+	append_record(buffer_, record, filter_, true, tags_);
+	if (buffer_.length() >= BLOCK_SIZE) {
+		out.write(buffer_.data(), buffer_.length());
+		buffer_.clear();
+		result = out.good();
+	}
 	if (clean_records_) out_book_->delete_dirty_record(record);
 	return out;
 }
 
 // Convert item to ADIF format text and send to the output stream
 std::string adi_writer::item_to_adif(record* record, std::string field) {
-	std::string value;
-	std::string adif_text = "";
-	unsigned int len_value;
-	//  <KEYWORD:length[:type]>VALUE
-	value = record->item(field);
-	len_value = value.length();
-	// minimum size of "<FIELD:n>VALUE " plus a safety margin
-	int out_size = len_value + field.length() + (int)log10(len_value) + 6;
-	// Get the type indicator from the ADIF spec database
-	char type_indicator = spec_data_->datatype_indicator(field);
-	// Don't write out any items that are an empty std::string.
-	if (len_value > 0) {
-		char* temp = nullptr;
-		if (field.length() > 3 && field.substr(0, 3) == "APP") {
-			// All application defined fields should include type character 
-			if (type_indicator == ' ') {
-				// But if it was not present on the input ADIF don't create one
-				temp = new char[out_size];
-				sprintf(temp, "<%s:%d>%s ", field.c_str(), len_value, value.c_str());
-			}
-			else {
-				// Add 2 bytes for the ":%c" for the type indicator
-				temp = new char[out_size + 2];
-				sprintf(temp, "<%s:%d:%c>%s ", field.c_str(), len_value, type_indicator, value.c_str());
-			}
-		}
-		else if (field.length() > 7 && field.substr(0, 7) == "USERDEF") {
-			// user defined fields require type and optional std::list or range of values
-			std::string list_range = spec_data_->userdef_values(field);
-			if (list_range.length() > 0) {
-				// Add enough bytes to cover the type indicator and the userdef range length
-				len_value += 3 + list_range.length();
-				temp = new char[out_size + 3 + list_range.length()];
-				sprintf(temp, "<%s:%d:%c>%s,{%s} ", field.c_str(), len_value, type_indicator, value.c_str(), list_range.c_str());
-			}
-			else {
-				// Add enough bytes for the type indicator
-				temp = new char[out_size + 2];
-				sprintf(temp, "<%s:%d:%c>%s ", field.c_str(), len_value, type_indicator, value.c_str());
-			}
+	return item_to_adif(field, record->item(field));
+}
+
+// Convert field and value to ADIF format text
+std::string adi_writer::item_to_adif(std::string field, const std::string& value) {
+	std::string result;
+	if (value.length()) {
+		field_tag_t tag;
+		make_tag(field, tag);
+		append_item(result, tag, value);
+	}
+	return result;
+}
+
+// Get the tag for the field - work it out the first time the field is seen
+const adi_writer::field_tag_t& adi_writer::field_tag(field_id_t field, tag_map& tags) {
+	if (field >= tags.tags.size()) {
+		tags.tags.resize(field + 1);
+	}
+	field_tag_t& tag = tags.tags[field];
+	if (tag.prefix.empty()) {
+		if (tags.complete) {
+			// A field first seen during a background save - the specification did not know its type
+			tag.prefix = "<" + field_registry::name(field) + ":";
+			tag.suffix = ">";
 		}
 		else {
-			// ADIF defined fields without type indicator
-			temp = new char[out_size];
-			sprintf(temp, "<%s:%d>%s ", field.c_str(), len_value, value.c_str());
+			make_tag(field_registry::name(field), tag);
+		}
+	}
+	return tag;
+}
+
+// Work out the text for the field:  <KEYWORD:length[:type]>VALUE
+void adi_writer::make_tag(const std::string& field, field_tag_t& tag) {
+	tag.prefix = "<" + field + ":";
+	tag.suffix = ">";
+	tag.tail = "";
+	// Get the type indicator from the ADIF spec database
+	std::string name = field;
+	char type_indicator = spec_data_->datatype_indicator(name);
+	if (field.length() > 3 && field.substr(0, 3) == "APP") {
+		// All application defined fields should include type character 
+		// But if it was not present on the input ADIF don't create one
+		if (type_indicator != ' ') {
+			tag.suffix = std::string(":") + type_indicator + ">";
+		}
+	}
+	else if (field.length() > 7 && field.substr(0, 7) == "USERDEF") {
+		// user defined fields require type and optional std::list or range of values
+		tag.suffix = std::string(":") + type_indicator + ">";
+		std::string list_range = spec_data_->userdef_values(name);
+		if (list_range.length() > 0) {
+			tag.tail = ",{" + list_range + "}";
 		}
-		// output the ADIF format text to the stream
-		return std::string(temp);
-		delete[] temp;
 	}
-	return "";
+	// ADIF defined fields without type indicator
+}
+
+// Append the field - empty values are not written
+void adi_writer::append_item(std::string& out, const field_tag_t& tag, const std::string& value) {
+	if (value.length() == 0) return;
+	char length[24];
+	std::to_chars_result res = std::to_chars(length, length + sizeof(length), value.length() + tag.tail.length());
+	out += tag.prefix;
+	out.append(length, res.ptr - length);
+	out += tag.suffix;
+	out += value;
+	out += tag.tail;
+	out += ' ';
+}
+
+// Fields to include as a set
+adi_writer::field_set* adi_writer::make_filter(field_list* fields) {
+	if (fields == nullptr) return nullptr;
+	field_set* filter = new field_set;
+	for (auto& field : *fields) {
+		field_id_t id = field_registry::id(field);
+		if (id == FI_NONE) continue;
+		if (id >= filter->size()) filter->resize(id + 1);
+		(*filter)[id] = true;
+	}
+	return filter;
 }
 
 // Convert record to ADIF format text
-void adi_writer::to_adif(record* record, std::ostream& out, field_list* fields /* = nullptr */) {
-	std::string temp;
+void adi_writer::to_adif(record* record, std::ostream& out, field_list* fields /* = nullptr */, bool convert_intl /* = true */) {
+	std::string buffer;
+	tag_map tags;
+	field_set* filter = make_filter(fields);
+	append_record(buffer, record, filter, convert_intl, tags);
+	delete filter;
+	out.write(buffer.data(), buffer.length());
+}
+
+// Append record as ADIF format text
+void adi_writer::append_record(std::string& out, record* qso, const field_set* filter, bool convert_intl, tag_map& tags) {
+	// _INTL fields renamed once the record has been written
+	std::vector<std::string> renames;
+	// Write any fields not yet decoded from a decoded copy
+	record copy;
+	record* record = qso->decoded(copy);
 
 	// Header - write out any comment first - 
 	if (record->is_header()) {
-		out << record->header();
+		out += record->header();
 	}
 	// Write out each ADIF field
 	for (auto it = record->begin(); it != record->end(); it++) {
-		std::string field = it->first;
-		std::string value = it->second;
-		bool in_filter = false;
-		if (fields) {
-			for (auto it = fields->begin(); it != fields->end() && !in_filter; it++) {
-				if ((*it) == field) {
-					in_filter = true;
-				}
-			}
-		}
+		const std::string& field = it->first;
+		const std::string& value = it->second;
+		field_id_t id = it->id;
 		// If field name is valid and either header record, no field filtering or the field is in the filter
-		if (field != "" && (record->is_header() || fields == nullptr || in_filter)) {
+		if (field != "" && (record->is_header() || filter == nullptr || (id < filter->size() && (*filter)[id]))) {
 			// Test whether field name end in _INTL
-			if (field.length() > 5 && field.substr(field.length() - 5) == "_INTL") {
+			if (field.length() > 5 && field.compare(field.length() - 5, 5, "_INTL") == 0) {
 				std::string non_intl_field = field.substr(0, field.length() - 5);
 				if (!record->item_exists(non_intl_field)) {
 					// ..._INTL exists and other doesn't - output it as non_intl
-					record->change_field_name(field, non_intl_field);
-					out << item_to_adif(record, non_intl_field);
+					if (convert_intl) {
+						renames.push_back(field);
+					}
+					append_item(out, field_tag(field_registry::id(non_intl_field), tags), value);
 				} // else if both exists don't output _INTL
 			}
 			else {
 				// send the field to the output stream
-				out << item_to_adif(record, field);
+				append_item(out, field_tag(id, tags), value);
 			}
 		}
 	}
+	// Rename them in the QSO itself - record may be a decoded copy
+	for (auto& field : renames) {
+		qso->change_field_name(field, field.substr(0, field.length() - 5));
+	}
 	if (record->is_header()) {
 		std::string year = now(false, "%Y");
 		char copyright[128];
 		snprintf(copyright, sizeof(copyright), DATA_COPYRIGHT.c_str(), year.c_str());
 		// Add red-tape after header fields
-		out << std::endl;
-		out << PROGRAM_ID << std::endl;
-		out << copyright << std::endl;
-		out << "<EOH>" << std::endl << std::endl;
+		out += '\n';
+		out += PROGRAM_ID;
+		out += '\n';
+		out += copyright;
+		out += '\n';
+		out += "<EOH>\n\n";
 	}
 	else {
 		// Add <EOR>
-		out << "<EOR>" << std::endl << std::endl;
+		out += "<EOR>\n\n";
 	}
 }
 
@@ -220,9 +339,11 @@ unsigned char adi_writer::adif_char(unsigned int utf8) {
 unsigned char adi_writer::adif_compliance(book* b, field_list* fields) {
 	unsigned char result = 0;
 	for (auto qso : *b) {
+		record copy;
+		record* full = qso->decoded(copy);
 		if (fields) {
 			for (auto field : *fields) {
-				std::string item = qso->item(field);
+				std::string item = full->item(field);
 				const char* pos = item.c_str();
 				const char* pend = pos + item.length();
 				int len;
@@ -234,7 +355,7 @@ unsigned char adi_writer::adif_compliance(book* b, field_list* fields) {
 			}
 		}
 		else {
-			for (auto field : *qso) {
+			for (auto field : *full) {
 				const char* pos = field.second.c_str();
 				const char* pend = pos + field.second.length();
 				int len;
@@ -4,6 +4,12 @@
 #include "main.h"
 #include "record.h"
 #include "status.h"
+#include "utils.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
 
 // pugixml
 #include "pugixml.hpp"
@@ -12,10 +18,16 @@ using xml_document = pugi::xml_document;
 using xml_node = pugi::xml_node;
 using xml_attribute = pugi::xml_attribute;
 
+// Read the input in blocks of this size - the output is also written in blocks of this size
+const size_t ADX_BLOCK_SIZE = 1 << 16;
+
 	//! Constructor
 adx_handler::adx_handler() {
 	loading_ = false;
 	storing_ = false;
+	total_records_ = 0;
+	num_records_ = 0;
+	encoding_ = pugi::encoding_utf8;
 }
 
 //! Destructor
@@ -27,57 +39,293 @@ adx_handler::~adx_handler() {
 bool adx_handler::load_book(book* my_book, std::istream& in) {
 	status_->misc_status(ST_NOTE, "LOG: Started loading ADX");
 	loading_ = true;
-	xml_document doc;
 	char msg[128];
-	pugi::xml_parse_result result = doc.load(in, pugi::parse_default | pugi::parse_declaration);
-	if (result.status != pugi::status_ok) {
+	buffer_.clear();
+	total_records_ = 0;
+	num_records_ = 0;
+	bool started = false;
+	bool ok = true;
+	size_t pos = 0;
+	detect_encoding(in);
+	// Look at each tag in turn - only the HEADER and RECORD elements are parsed
+	while (ok) {
+		// Discard the input already processed
+		if (pos >= ADX_BLOCK_SIZE) {
+			buffer_.erase(0, pos);
+			pos = 0;
+		}
+		size_t lt = find_text(in, "<", pos);
+		if (lt == std::string::npos) break;
+		// Comment or CDATA section - may include '<' or '>'
+		size_t after = skip_section(in, lt);
+		if (after == std::string::npos) {
+			ok = false;
+			break;
+		}
+		if (after != lt) {
+			pos = after;
+			continue;
+		}
+		size_t gt = find_text(in, ">", lt);
+		if (gt == std::string::npos) {
+			ok = false;
+			break;
+		}
+		// Get the element name
+		size_t name_end = buffer_.find_first_of(" \t\r\n/>", lt + 1);
+		std::string name = buffer_.substr(lt + 1, name_end - lt - 1);
+		if (name != "HEADER" && name != "RECORD") {
+			// Declaration, ADX, RECORDS or closing tag
+			pos = gt + 1;
+			continue;
+		}
+		// Find the end of the element
+		size_t element_end = gt;
+		if (buffer_[gt - 1] != '/') {
+			element_end = find_close(in, name, gt + 1);
+			if (element_end == std::string::npos) {
+				ok = false;
+				break;
+			}
+		}
+		const char* element = buffer_.data() + lt;
+		size_t length = element_end + 1 - lt;
+		pos = element_end + 1;
+		if (name == "HEADER") {
+			record* header = new record();
+			if (!load_element(header, element, length)) {
+				delete header;
+				status_->misc_status(ST_ERROR, "LOG: Loading ADX failed: bad header");
+				loading_ = false;
+				return false;
+			}
+			my_book->header(header);
+			header->item("APP_ZZA_NUMRECORDS", total_records_);
+		}
+		else {
+			if (!started) {
+				if (total_records_ == 0) {
+					// None supplied -assume 10K
+					total_records_ = 10000;
+				}
+				status_->progress(total_records_, my_book->book_type(), "Parsing ADX", "records");
+				started = true;
+			}
+			record* qso = new record();
+			num_records_++;
+			if (!load_element(qso, element, length)) {
+				delete qso;
+				status_->misc_status(ST_ERROR, "LOG: Load ADX failed: Bad record");
+				status_->progress("ADX conversion failed", my_book->book_type());
+				loading_ = false;
+				return false;
+			}
+			my_book->insert_record(qso);
+			status_->progress(num_records_, my_book->book_type());
+		}
+	}
+	buffer_.clear();
+	buffer_.shrink_to_fit();
+	raw_.clear();
+	if (!ok) {
 		// Parsing the XML failed for some reason
-		snprintf(msg, sizeof(msg), "LOG: Loading ADX failed: %s", 
-			result.description());
+		snprintf(msg, sizeof(msg), "LOG: Loading ADX failed: %s after %d records",
+			in.bad() ? "read error" : "unexpected end of file", num_records_);
 		status_->misc_status(ST_ERROR, msg);
+		if (started) status_->progress("ADX conversion failed", my_book->book_type());
 		loading_ = false;
 		return false;
 	}
 	status_->misc_status(ST_OK, "LOG: Loaded ADX OK");
-	// Top node is ADX - 
-	xml_node top = doc.document_element();
-	// Process header
-	record* header = new record();
-	xml_node n_header = top.child("HEADER");
-	if (n_header) {
-		if (!load_record(header, n_header)) {
-			status_->misc_status(ST_ERROR, "LOG: Loading ADX failed: bad header");
-			loading_ = false;
-			return false;
+	if (num_records_ < total_records_) {
+		status_->progress("ADX conversion complete", my_book->book_type());
+	}
+	loading_ = false;
+	return true;
+}
+
+// Read the next block of input
+bool adx_handler::read_block(std::istream& in) {
+	if (!in.good()) return false;
+	// UTF-16 and UTF-32 are read separately and converted to UTF-8
+	bool wide = encoding_ != pugi::encoding_utf8 && encoding_ != pugi::encoding_latin1;
+	std::string& into = wide ? raw_ : buffer_;
+	size_t length = into.length();
+	into.resize(length + ADX_BLOCK_SIZE);
+	in.read(&into[length], ADX_BLOCK_SIZE);
+	into.resize(length + (size_t)in.gcount());
+	if (wide) convert();
+	return in.gcount() > 0;
+}
+
+// Work out the encoding from the byte order mark or the declaration - as pugixml does for a whole document
+void adx_handler::detect_encoding(std::istream& in) {
+	encoding_ = pugi::encoding_utf8;
+	raw_.clear();
+	read_block(in);
+	auto starts = [this](const char* bytes, size_t count) {
+		return buffer_.length() >= count && memcmp(buffer_.data(), bytes, count) == 0;
+	};
+	size_t bom = 0;
+	if (starts("\xEF\xBB\xBF", 3)) {
+		// UTF-8
+		buffer_.erase(0, 3);
+		return;
+	}
+	else if (starts("\xFF\xFE\0\0", 4)) {
+		encoding_ = pugi::encoding_utf32_le;
+		bom = 4;
+	}
+	else if (starts("\0\0\xFE\xFF", 4)) {
+		encoding_ = pugi::encoding_utf32_be;
+		bom = 4;
+	}
+	else if (starts("\xFF\xFE", 2)) {
+		encoding_ = pugi::encoding_utf16_le;
+		bom = 2;
+	}
+	else if (starts("\xFE\xFF", 2)) {
+		encoding_ = pugi::encoding_utf16_be;
+		bom = 2;
+	}
+	else if (starts("<\0?\0", 4)) {
+		// UTF-16 declaration without a byte order mark
+		encoding_ = pugi::encoding_utf16_le;
+	}
+	else if (starts("\0<\0?", 4)) {
+		encoding_ = pugi::encoding_utf16_be;
+	}
+	else {
+		// Read as UTF-8 unless the declaration says Latin-1
+		size_t end = buffer_.find("?>");
+		if (starts("<?xml", 5) && end != std::string::npos) {
+			std::string declaration = to_upper(buffer_.substr(0, end));
+			if (declaration.find("ISO-8859-1") != std::string::npos ||
+				declaration.find("LATIN1") != std::string::npos) {
+				encoding_ = pugi::encoding_latin1;
+			}
+		}
+		return;
+	}
+	// Convert what has been read so far
+	raw_ = buffer_.substr(bom);
+	buffer_.clear();
+	convert();
+}
+
+// Convert the UTF-16 or UTF-32 text read to UTF-8
+void adx_handler::convert() {
+	const unsigned char* bytes = (const unsigned char*)raw_.data();
+	bool big_endian = encoding_ == pugi::encoding_utf16_be || encoding_ == pugi::encoding_utf32_be;
+	size_t width = (encoding_ == pugi::encoding_utf16_le || encoding_ == pugi::encoding_utf16_be) ? 2 : 4;
+	// Get the code unit at the position
+	auto unit = [&](size_t at) {
+		uint32_t value = 0;
+		for (size_t ix = 0; ix < width; ix++) {
+			value |= (uint32_t)bytes[at + ix] << (8 * (big_endian ? width - 1 - ix : ix));
+		}
+		return value;
+	};
+	size_t pos = 0;
+	while (pos + width <= raw_.length()) {
+		uint32_t c = unit(pos);
+		size_t used = width;
+		if (width == 2 && c >= 0xD800 && c < 0xDC00) {
+			// Surrogate pair - wait for the second half if it has not been read
+			if (pos + 4 > raw_.length()) break;
+			c = 0x10000 + ((c - 0xD800) << 10) + (unit(pos + 2) - 0xDC00);
+			used = 4;
+		}
+		if (c < 0x80) {
+			buffer_ += (char)c;
+		}
+		else if (c < 0x800) {
+			buffer_ += (char)(0xC0 | (c >> 6));
+			buffer_ += (char)(0x80 | (c & 0x3F));
 		}
-		my_book->header(header);
+		else if (c < 0x10000) {
+			buffer_ += (char)(0xE0 | (c >> 12));
+			buffer_ += (char)(0x80 | ((c >> 6) & 0x3F));
+			buffer_ += (char)(0x80 | (c & 0x3F));
+		}
+		else {
+			buffer_ += (char)(0xF0 | (c >> 18));
+			buffer_ += (char)(0x80 | ((c >> 12) & 0x3F));
+			buffer_ += (char)(0x80 | ((c >> 6) & 0x3F));
+			buffer_ += (char)(0x80 | (c & 0x3F));
+		}
+		pos += used;
+	}
+	raw_.erase(0, pos);
+}
+
+// Find the text - reading more input until it is found
+size_t adx_handler::find_text(std::istream& in, const char* text, size_t from) {
+	size_t length = strlen(text);
+	while (true) {
+		size_t found = buffer_.find(text, from);
+		if (found != std::string::npos) return found;
+		// The text may start in the last few characters already read
+		if (buffer_.length() >= length && buffer_.length() - length + 1 > from) {
+			from = buffer_.length() - length + 1;
+		}
+		if (!read_block(in)) return std::string::npos;
 	}
-	header->item("APP_ZZA_NUMRECORDS", total_records_);
-	if (total_records_ == 0) {
-		// None supplied -assume 10K
-		total_records_ = 10000;
+}
+
+// Skip a comment or CDATA section
+size_t adx_handler::skip_section(std::istream& in, size_t lt) {
+	// Make sure enough has been read to tell
+	while (buffer_.length() < lt + 9 && read_block(in));
+	if (buffer_.compare(lt, 4, "<!--") == 0) {
+		size_t end = find_text(in, "-->", lt + 4);
+		return end == std::string::npos ? end : end + 3;
 	}
-	num_records_ = 0;
-	status_->progress(total_records_, my_book->book_type(), "Parsing ADX", "records");
-	xml_node n_records = top.child("RECORDS");
-	// Convert each record in turn
-	for (auto n_qso : n_records.children("RECORD")) {
-		record* qso = new record();
-		num_records_++;
-		if (!load_record(qso, n_qso)) {
-			status_->misc_status(ST_ERROR, "LOG: Load ADX failed: Bad record");
-			status_->progress("ADX conversion failed", my_book->book_type());
-			loading_ = false;
-			return false;
+	if (buffer_.compare(lt, 9, "<![CDATA[") == 0) {
+		size_t end = find_text(in, "]]>", lt + 9);
+		return end == std::string::npos ? end : end + 3;
+	}
+	return lt;
+}
+
+// Find the closing tag of the element - text in a comment or CDATA section is not the closing tag
+size_t adx_handler::find_close(std::istream& in, const std::string& name, size_t from) {
+	std::string close = "</" + name;
+	while (true) {
+		size_t lt = find_text(in, "<", from);
+		if (lt == std::string::npos) return lt;
+		size_t after = skip_section(in, lt);
+		if (after == std::string::npos) return after;
+		if (after != lt) {
+			from = after;
+			continue;
 		}
-		my_book->insert_record(qso);
-		status_->progress(num_records_, my_book->book_type());
+		// The name must not continue - e.g. </RECORDS> is not </RECORD>
+		while (buffer_.length() <= lt + close.length() && read_block(in));
+		if (buffer_.compare(lt, close.length(), close) == 0 && lt + close.length() < buffer_.length()) {
+			char next = buffer_[lt + close.length()];
+			if (next == '>' || isspace((unsigned char)next)) {
+				return find_text(in, ">", lt);
+			}
+		}
+		from = lt + 1;
 	}
-	if (num_records_ < total_records_) {
-		status_->progress("ADX conversion complete", my_book->book_type());
+}
+
+// Parse the element as an XML fragment
+bool adx_handler::load_element(record* qso, const char* data, size_t length) {
+	// UTF-16 and UTF-32 have been converted to UTF-8 as they were read
+	pugi::xml_encoding encoding = encoding_ == pugi::encoding_latin1 ? pugi::encoding_latin1 : pugi::encoding_utf8;
+	pugi::xml_parse_result result = fragment_.load_buffer(data, length,
+		pugi::parse_default | pugi::parse_fragment, encoding);
+	if (result.status != pugi::status_ok) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "LOG: Loading ADX failed: %s", result.description());
+		status_->misc_status(ST_ERROR, msg);
+		return false;
 	}
-	loading_ = false;
-	return true;
+	xml_node node = fragment_.first_child();
+	return load_record(qso, node);
 }
 
 //! Generate XML for the records in book and send them to the output stream.
@@ -90,36 +338,35 @@ bool adx_handler::store_book(book* my_book, std::ostream& os, bool clean) {
 	char msg[128];
 	status_->misc_status(ST_NOTE, "LOG: Started storing ADX");
 	status_->progress(my_book->size(), my_book->book_type(), "Storing ADX", "records");
+	storing_ = true;
 	num_records_ = 0;
-	// Generate the new ADX document
-	xml_document doc;
-	// Add the declaration
-	auto n_decl = doc.append_child(pugi::node_declaration);
-	n_decl.append_attribute("version") = "1.0";
-	n_decl.append_attribute("encoding") = "UTF-8";
-
-	// Top level node
-	auto root = doc.append_child("ADX");
+	// The XML is generated in this buffer and written out in blocks
+	std::string out;
+	out.reserve(2 * ADX_BLOCK_SIZE);
+	// Add the declaration and top level element
+	out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	out += "<ADX>\n";
 
 	// Store HEADER
 	record* header = my_book->header();
-	xml_node n_header = root.append_child("HEADER");
-	if (!store_record(header, n_header)) {
-		status_->misc_status(ST_ERROR, "LOG: Storing ADX failed: Error in header");
-		status_->progress("Storing ADX failed", my_book->book_type());
-		return false;
+	if (header) {
+		if (!store_record(header, out, "HEADER", "  ")) {
+			status_->misc_status(ST_ERROR, "LOG: Storing ADX failed: Error in header");
+			status_->progress("Storing ADX failed", my_book->book_type());
+			storing_ = false;
+			return false;
+		}
+		// Mark the header clean
+		if (clean) {
+			my_book->delete_dirty_record(header);
+		}
 	}
 	num_records_++;
-	// Mark the header clean
-	if (clean) {
-		my_book->delete_dirty_record(header);
-	}
 
 	// Store RECORDS
-	xml_node n_records = root.append_child("RECORDS");
+	out += "  <RECORDS>\n";
 	for (auto qso : *my_book) {
-		xml_node n_qso = n_records.append_child("RECORD");
-		if (!store_record(qso, n_qso)) {
+		if (!store_record(qso, out, "RECORD", "    ")) {
 			snprintf(msg, sizeof(msg),
 				"LOG: Storing ADX failed: Error in record %s %s %s",
 				qso->item("QSO_DATE").c_str(),
@@ -127,17 +374,30 @@ bool adx_handler::store_book(book* my_book, std::ostream& os, bool clean) {
 				qso->item("CALL").c_str());
 			status_->misc_status(ST_ERROR, msg);
 			status_->progress("Storing ADX failed", my_book->book_type());
+			storing_ = false;
 			return false;
 		}
 		// Mark the QSO clean
 		if (clean) {
 			my_book->delete_dirty_record(qso);
 		}
+		if (out.length() >= ADX_BLOCK_SIZE) {
+			os.write(out.data(), out.length());
+			out.clear();
+		}
 		status_->progress(num_records_, my_book->book_type());
 		num_records_++;
 	}
-	// Save the data
-	doc.save(os, "  ");
+	out += "  </RECORDS>\n";
+	out += "</ADX>\n";
+	os.write(out.data(), out.length());
+	os.flush();
+	storing_ = false;
+	if (!os.good()) {
+		status_->misc_status(ST_ERROR, "LOG: Storing ADX failed: Error writing file");
+		status_->progress("Storing ADX failed", my_book->book_type());
+		return false;
+	}
 
 	// Done!
 	status_->misc_status(ST_OK, "LOG: Finished storing ADX");
@@ -177,28 +437,78 @@ bool adx_handler::load_record(record* rec, xml_node& node) {
 	return true;
 }
 
-bool adx_handler::store_record(record* qso, xml_node& node) {
+// Generate the XML for the record
+bool adx_handler::store_record(record* rec, std::string& out, const char* element, const char* indent) {
+	// Write any fields not yet decoded from a decoded copy
+	record copy;
+	record* qso = rec->decoded(copy);
+	std::string field_indent = std::string(indent) + "  ";
+	out += indent;
+	out += '<';
+	out += element;
+	out += ">\n";
 	for (auto field : *qso) {
+		out += field_indent;
 		// Check if it is ann APP... field
 		if (field.first.substr(0, 3) == "APP") {
-			size_t pos = 4;
-			while (field.first[pos] != '_') pos++;
-			std::string pid = field.first.substr(4, pos - 4);
-			std::string name = field.first.substr(pos + 1);
-			xml_node n_field = node.append_child("APP");
-			n_field.append_attribute("PROGRAMID") = pid;
-			n_field.append_attribute("FIELDNAME") = name;
-			n_field.append_attribute("TYPE") = "S";
-			if (!n_field.text().set(field.second)) return false;
+			size_t pos = field.first.find('_', 4);
+			if (pos == std::string::npos) return false;
+			out += "<APP PROGRAMID=\"";
+			escape(field.first.substr(4, pos - 4), out);
+			out += "\" FIELDNAME=\"";
+			escape(field.first.substr(pos + 1), out);
+			out += "\" TYPE=\"S\">";
+			escape(field.second, out);
+			out += "</APP>\n";
 		}
 		else {
-			if(!node.append_child(field.first).text().set(field.second))
-				return false;
+			out += '<';
+			out += field.first;
+			out += '>';
+			escape(field.second, out);
+			out += "</";
+			out += field.first;
+			out += ">\n";
 		}
 	}
+	out += indent;
+	out += "</";
+	out += element;
+	out += ">\n";
 	return true;
 }
 
+// Replace the characters XML reserves with references
+void adx_handler::escape(const std::string& text, std::string& out) {
+	for (char c : text) {
+		switch (c) {
+		case '&':
+			out += "&amp;";
+			break;
+		case '<':
+			out += "&lt;";
+			break;
+		case '>':
+			out += "&gt;";
+			break;
+		case '"':
+			out += "&quot;";
+			break;
+		case '\t':
+		case '\n':
+		case '\r':
+			out += c;
+			break;
+		default:
+			// Other control characters are not allowed in XML 1.0, even as references - drop them
+			if ((unsigned char)c >= ' ') {
+				out += c;
+			}
+			break;
+		}
+	}
+}
+
 bool adx_handler::loading() { return loading_; }
 bool adx_handler::storing() { return storing_; }
 
@@ -5,8 +5,11 @@
 #include "adx_handler.h"
 #include "club_handler.h"
 #include "cty_data.h"
+#include "dupe_dialog.h"
 #include "eqsl_handler.h"
+#include "gz_stream.h"
 #include "intl_widgets.h"
+#include "journal.h"
 #include "lotw_handler.h"
 #include "main.h"
 #include "main_window.h"
@@ -14,6 +17,7 @@
 #include "qrz_handler.h"
 #include "qso_manager.h"
 #include "record.h"
+#include "regices.h"
 #include "search.h"
 #include "settings.h"
 #include "spec_data.h"
@@ -22,20 +26,30 @@
 #include "stn_data.h"
 #include "tabbed_forms.h"
 #include "view.h"
+#include "zzb_handler.h"
 
 #include "drawing.h"
 #include "utils.h"
 
 // C/C++ header files
+#include <algorithm>
 #include <ctime>
+#include <filesystem>
+#include <iterator>
+#include <numeric>
 // FLTK header files
 #include <FL/Fl.H>
 #include <FL/fl_ask.H>
+#include <FL/fl_utf8.h>
 #include <FL/Fl_Menu_Item.H>
 #include <FL/Fl_Single_Window.H>
 #include <FL/Fl_Button.H>
 
 const std::string default_header_ = "ADIF File generated by ZZALOG\n";
+// Number of entries in the journal before the whole log is written and the journal compacted
+const int JOURNAL_COMPACT_ENTRIES = 500;
+// The FLTK thread - defined in banner.cpp
+extern std::thread::id main_thread_id_;
 
 // Constructor - initialises some attributes
 book::book(object_t type)
@@ -50,6 +64,7 @@ book::book(object_t type)
 	, last_search_result_(0)
 	, save_in_progress_(false)
 	, delete_in_progress_(false)
+	, th_dupes_(nullptr)
 	, old_record_(nullptr)
 	, main_loading_(false)
 	, save_level_(0)
@@ -58,6 +73,19 @@ book::book(object_t type)
 	, adx_handler_(nullptr)
 	, upload_allowed_(true)
 	, deleted_record_(false)
+	, th_save_(nullptr)
+	, save_running_(false)
+	, save_pending_(false)
+	, save_ok_(false)
+	, save_changed_file_(false)
+	, save_header_(nullptr)
+	, save_zzb_(nullptr)
+	, save_adi_(nullptr)
+	, deleted_during_save_(false)
+	, save_journal_size_(-1)
+	, journal_(type == OT_MAIN ? new journal : nullptr)
+	, journal_ids_unsaved_(false)
+	, calls_indexed_(false)
 {
 	used_bands_.clear();
 	used_modes_.clear();
@@ -65,17 +93,21 @@ book::book(object_t type)
 	used_rigs_.clear();
 	used_antennas_.clear();
 	used_callsigns_.clear();
-	bands_.clear();
-	modes_.clear();
-	submodes_.clear();
+	clear_use();
 	delete_contents(true);
 }
 
 // Destructor - iterative destroys contents
 book::~book()
 {
+	// Do not leave the duplicate check std::thread running
+	if (th_dupes_) {
+		th_dupes_->join();
+		delete th_dupes_;
+	}
 	// Just destroy the contents
 	delete_contents(false);
+	delete journal_;
 }
 
 // constructor to open a file and populate book
@@ -114,22 +146,35 @@ bool book::load_data(std::string filename)
 				// Update status bar
 				snprintf(message, sizeof(message), "LOG: Loading log-book %s", filename_.c_str());
 				status_->misc_status(ST_NOTE, message);
-				// Get the filetype suffix from the filename to know which reader to use
-				std::string filetype;
-				size_t last_period = filename.find_last_of('.');
-				if (last_period != std::string::npos) {
-					filetype = to_lower(filename.substr(last_period));
-				}
+				// Get the filetype suffix from the filename to know which reader to use - ignoring any .gz
+				std::string filetype = gz_streambuf::file_type(filename);
+				bool compressed = gz_streambuf::is_compressed(filename);
 				// Check for .adi or .adif format
 				if (filetype == ".adi" || filetype == ".adif") {
-					// Use ADI reader to read from an input stream connected to thefile
-					adi_reader_ = new adi_reader;
-					input_.open(filename.c_str(), std::fstream::in);
 					// Load the book
 					if (book_type_ == OT_MAIN) {
 						main_loading_ = true;
 					}
-					if (!adi_reader_->load_book(this, input_)) {
+					// Use the binary snapshot of the main log if it was written from this version of the file
+					bool loaded = false;
+					if (book_type_ == OT_MAIN) {
+						zzb_handler snapshot;
+						loaded = snapshot.load_book(this, filename);
+					}
+					if (!loaded) {
+						// Use ADI reader to read from an input stream connected to thefile
+						adi_reader_ = new adi_reader;
+						if (compressed) {
+							// Decompress the file as it is read
+							gz_ifstream gz_input(filename);
+							loaded = adi_reader_->load_book(this, gz_input);
+						}
+						else {
+							input_.open(filename.c_str(), std::fstream::in);
+							loaded = adi_reader_->load_book(this, input_);
+						}
+					}
+					if (!loaded) {
 						if (new_installation_) {
 							snprintf(message, sizeof(message), "LOG: New logbook %s", filename.c_str());
 							status_->misc_status(ST_NOTE, message);
@@ -157,6 +202,9 @@ bool book::load_data(std::string filename)
 						snprintf(msg, sizeof(msg), "LOG: File %s loaded OK", filename.c_str());
 						status_->misc_status(ST_OK, msg);
 						if (book_type_ == OT_MAIN) {
+							// Apply the changes made since the file was last written
+							replay_journal();
+							add_journal_ids();
 							main_loading_ = false;
 							// Display filename in title bar and update views there's new data
 							if (READ_ONLY) {
@@ -188,9 +236,16 @@ bool book::load_data(std::string filename)
 					adx_handler_ = new adx_handler;
 					// Opening in text mode appears to do some behind-the-scenes processing
 					// when seeking backwards passed NL.
-					input_.open(filename.c_str(), std::fstream::in | std::fstream::binary);
+					gz_ifstream gz_input;
+					std::istream& in = compressed ? (std::istream&)gz_input : (std::istream&)input_;
+					if (compressed) {
+						gz_input.open(filename);
+					}
+					else {
+						input_.open(filename.c_str(), std::fstream::in | std::fstream::binary);
+					}
 					main_loading_ = true;
-					if (!input_.good() || !adx_handler_->load_book(this, input_)) {
+					if (!in.good() || !adx_handler_->load_book(this, in)) {
 						if (new_installation_) {
 							snprintf(message, sizeof(message), "LOG: New logbook %s", filename.c_str());
 							status_->misc_status(ST_NOTE, message);
@@ -294,6 +349,15 @@ bool book::load_data(std::string filename)
 bool book::store_data(std::string filename, bool force, field_list* fields) {
 	bool ok = false;
 	bool changed_file = false;
+	if (save_running_) {
+		if (book_type_ == OT_MAIN && filename == "" && fields == nullptr) {
+			// Save again when the current background save has finished
+			save_pending_ = true;
+			return true;
+		}
+		// Otherwise finish the background save first
+		wait_for_save();
+	}
 	if (save_in_progress_) {
 		// Race hazard - can instigate a second store before finished this one
 		status_->misc_status(ST_WARNING, "LOG: Ignoring request to store log as currently doing so");
@@ -318,7 +382,7 @@ bool book::store_data(std::string filename, bool force, field_list* fields) {
 			}
 
 			// First parse and validate if necessary
-			if (is_dirty() == true || force || new_installation_) {
+			if (is_dirty() == true || force || new_installation_ || (journal_ && journal_->entries())) {
 				// Only write out if modified or force is set
 				if (!header_) {
 					// No header then create one.
@@ -346,90 +410,111 @@ bool book::store_data(std::string filename, bool force, field_list* fields) {
 				sprintf(message, "LOG: %s", filename_.c_str());
 				status_->misc_status(ST_NOTE, message);
 				delete[] message;
-				// Rename the last 8 saves
-				for (char c = '8'; c > '0'; c--) {
-					// Rename will fail if file does not exist, so no need to test file exists
-					std::string oldfile = filename_ + c;
-					char c2 = c + 1;
-					std::string newfile = filename_ + c2;
-					fl_rename(oldfile.c_str(), newfile.c_str());
-				}
-				fl_rename(filename_.c_str(), (filename_ + '1').c_str());
-
-				// Output stream
-				std::ofstream file;
-				// Get file type suffix
-				std::string filetype = "";
-				size_t last_period = filename_.find_last_of('.');
-				if (last_period != std::string::npos) {
-					// Get file type
-					filetype = to_lower(filename_.substr(last_period));
+				// Get file type suffix - ignoring any .gz
+				std::string filetype = gz_streambuf::file_type(filename_);
+				bool compressed = gz_streambuf::is_compressed(filename_);
+				// The log will include all the changes in the journal
+				save_journal_size_ = (book_type_ == OT_MAIN && fields == nullptr) ? mark_journal() : -1;
+				if (book_type_ == OT_MAIN && fields == nullptr && (filetype == ".adi" || filetype == ".adif")) {
+					// Write the log in a separate std::thread - save_done() reports the result
+					ok = store_background(changed_file);
 				}
-				// Check for .adi format
-				if (filetype == ".adi" || filetype == ".adif") {
-					// Connect file to output stream and get ADI writer to write it
-					if (book_type_ == OT_MAIN) {
-					}
-					file.open(filename_.c_str(), std::fstream::out);
-					adi_writer_ = new adi_writer;
-					if (!adi_writer_->store_book(this, file, book_type_ == OT_MAIN ? true : false, fields)) {
-						// Store failed
-						char* message = new char[filename_.length() + 100];
-						sprintf(message, "LOG: Failed to open %s", filename_.c_str());
-						delete[] message;
-						file.close();
-						ok = false;
+				else {
+					// Rename the last 8 saves
+					for (char c = '8'; c > '0'; c--) {
+						// Rename will fail if file does not exist, so no need to test file exists
+						std::string oldfile = filename_ + c;
+						char c2 = c + 1;
+						std::string newfile = filename_ + c2;
+						fl_rename(oldfile.c_str(), newfile.c_str());
 					}
-					else {
-						ok = true;
+					fl_rename(filename_.c_str(), (filename_ + '1').c_str());
+
+					// Output stream - compressed if the filename ends .gz
+					std::ofstream file;
+					gz_ofstream gz_file;
+					std::ostream& out = compressed ? (std::ostream&)gz_file : (std::ostream&)file;
+					// Check for .adi format
+					if (filetype == ".adi" || filetype == ".adif") {
+						// Connect file to output stream and get ADI writer to write it
+						if (book_type_ == OT_MAIN) {
+						}
+						if (compressed) {
+							gz_file.open(filename_);
+						}
+						else {
+							file.open(filename_.c_str(), std::fstream::out);
+						}
+						adi_writer_ = new adi_writer;
+						if (!adi_writer_->store_book(this, out, book_type_ == OT_MAIN ? true : false, fields)) {
+							// Store failed
+							char* message = new char[filename_.length() + 100];
+							sprintf(message, "LOG: Failed to open %s", filename_.c_str());
+							delete[] message;
+							file.close();
+							gz_file.close();
+							ok = false;
+						}
+						else {
+							ok = true;
+						}
+						delete adi_writer_;
+						adi_writer_ = nullptr;
 					}
-					delete adi_writer_;
-					adi_writer_ = nullptr;
-				}
-				// check for .adx format
-				else if (filetype == ".adx") {
-					// Connect file to output stream and store data
-					if (book_type_ == OT_MAIN) {
+					// check for .adx format
+					else if (filetype == ".adx") {
+						// Connect file to output stream and store data
+						if (book_type_ == OT_MAIN) {
+						}
+						if (compressed) {
+							gz_file.open(filename_);
+						}
+						else {
+							file.open(filename_.c_str(), std::fstream::out);
+						}
+						adx_handler_ = new adx_handler;
+						if (!adx_handler_->store_book(this, out, book_type_ == OT_MAIN ? true: false)) {
+							// Store failed
+							char * message = new char[filename_.length() + 100];
+							sprintf(message, "LOG: Failed to open %s", filename_.c_str());
+							status_->misc_status(ST_ERROR, message);
+							delete[] message;
+							file.close();
+							gz_file.close();
+							ok = false;
+						}
+						else {
+							ok = true;
+						}
+						delete adx_handler_;
+						adx_handler_ = nullptr;
 					}
-					file.open(filename_.c_str(), std::fstream::out);
-					adx_handler_ = new adx_handler;
-					if (!adx_handler_->store_book(this, file, book_type_ == OT_MAIN ? true: false)) {
-						// Store failed
+					else {
+						// Unknown file type
 						char * message = new char[filename_.length() + 100];
-						sprintf(message, "LOG: Failed to open %s", filename_.c_str());
-						status_->misc_status(ST_ERROR, message);
+						sprintf(message, "LOG: Unknown file format. %s ignored", filename_.c_str());
+						status_->misc_status(ST_WARNING, message);
 						delete[] message;
-						file.close();
 						ok = false;
 					}
-					else {
-						ok = true;
+					if (ok) {
+						deleted_record_ = false;
+						char* message = new char[filename_.length() + 100];
+						size_t num_records = size();
+						if (header()) num_records++;
+						sprintf(message, "LOG: %zu records written to %s", num_records, filename_.c_str());
+						status_->misc_status(ST_OK, message);
+						delete[] message;
+					}
+					if (ok && book_type_ == OT_MAIN) {
+						// File was closed in the fail paths
+						file.close();
+						gz_file.close();
+						// Update file name on window label
+						if (changed_file) main_window_label(filename_);
+						// Keep only the journal entries made since the mark
+						if (journal_) journal_->compact(save_journal_size_, filename_);
 					}
-					delete adx_handler_;
-					adx_handler_ = nullptr;
-				}
-				else {
-					// Unknown file type
-					char * message = new char[filename_.length() + 100];
-					sprintf(message, "LOG: Unknown file format. %s ignored", filename_.c_str());
-					status_->misc_status(ST_WARNING, message);
-					delete[] message;
-					ok = false;
-				}
-				if (ok) {
-					deleted_record_ = false;
-					char* message = new char[filename_.length() + 100];
-					size_t num_records = size();
-					if (header()) num_records++;
-					sprintf(message, "LOG: %zu records written to %s", num_records, filename_.c_str());
-					status_->misc_status(ST_OK, message);
-					delete[] message;
-				}
-				if (ok && book_type_ == OT_MAIN) {
-					// File was closed in the fail paths
-					file.close();
-					// Update file name on window label
-					if (changed_file) main_window_label(filename_);
 				}
 			}
 			else {
@@ -451,6 +536,375 @@ bool book::store_data(std::string filename, bool force, field_list* fields) {
 	return ok;
 }
 
+// Take a snapshot of the log and start the std::thread that writes it
+bool book::store_background(bool changed_file) {
+	// The header may be replaced while writing, so copy it. The records are only
+	// referenced - they are not deleted while in the book and are changed under record::write_mutex_
+	save_filename_ = filename_;
+	save_changed_file_ = changed_file;
+	save_header_ = header_ ? new record(*header_) : nullptr;
+	save_records_.assign(begin(), end());
+	save_dirty_ = dirty_qsos_;
+	dirty_during_save_.clear();
+	deleted_during_save_ = false;
+	save_error_ = "";
+	save_ok_ = false;
+	// The summary tables are only changed in this std::thread so encode them now
+	save_zzb_ = new zzb_handler;
+	save_zzb_->add_tables(this);
+	// The ADIF specification can also be changed in this std::thread - e.g. by a new APP_ field
+	save_adi_ = new adi_writer;
+	save_adi_->add_tags();
+	record::lock_writes_ = true;
+	save_running_ = true;
+	if (DEBUG_THREADS) printf("BOOK MAIN: Starting save std::thread\n");
+	th_save_ = new std::thread(thread_save, this);
+	return true;
+}
+
+// Background save std::thread
+void book::thread_save(book* that) {
+	if (DEBUG_THREADS) printf("BOOK THREAD: Writing %zu records to %s\n",
+		that->save_records_.size(), that->save_filename_.c_str());
+	that->save_ok_ = that->write_snapshot();
+	if (that->save_ok_) {
+		// The binary snapshot is only an aid to loading the log - just remove it if it cannot be written
+		if (!that->save_zzb_->store_book(that->save_filename_, that->save_header_, that->save_records_)) {
+			zzb_handler::remove(that->save_filename_);
+		}
+	}
+	if (DEBUG_THREADS) printf("BOOK THREAD: Calling std::thread callback result = %d\n", that->save_ok_);
+	Fl::awake(cb_save_done, (void*)that);
+}
+
+// Write the snapshot to a temporary file, rotate the backups and replace the log file (in std::thread)
+bool book::write_snapshot() {
+	std::string temp_file = save_filename_ + ".tmp";
+	// Compress the log as it is written if the filename ends .gz
+	bool compressed = gz_streambuf::is_compressed(save_filename_);
+	std::ofstream file;
+	gz_ofstream gz_file;
+	std::ostream& out = compressed ? (std::ostream&)gz_file : (std::ostream&)file;
+	if (compressed) {
+		gz_file.open(temp_file);
+	}
+	else {
+		file.open(temp_file.c_str(), std::fstream::out);
+	}
+	if (!out.good()) {
+		save_error_ = "cannot open " + temp_file;
+		return false;
+	}
+	bool ok = save_adi_->store_records(save_header_, save_records_, out);
+	if (compressed) {
+		gz_file.close();
+	}
+	else {
+		file.close();
+	}
+	if (!ok || out.fail()) {
+		save_error_ = "cannot write " + temp_file;
+		fl_unlink(temp_file.c_str());
+		return false;
+	}
+	// Make sure the new file is on the disk before the existing one is replaced
+	if (!sync_file(temp_file)) {
+		save_error_ = "cannot flush " + temp_file + " to disk";
+		fl_unlink(temp_file.c_str());
+		return false;
+	}
+	// Rename the last 8 saves - both the compressed backups and any earlier uncompressed ones
+	for (char c = '8'; c > '0'; c--) {
+		// Rename will fail if file does not exist, so no need to test file exists
+		std::string oldfile = save_filename_ + c;
+		char c2 = c + 1;
+		std::string newfile = save_filename_ + c2;
+		fl_rename(oldfile.c_str(), newfile.c_str());
+		fl_rename((oldfile + ".gz").c_str(), (newfile + ".gz").c_str());
+	}
+	// Keep the existing log as the first backup. A link leaves the log in place
+	// until it is replaced: copy it if the file system does not support links.
+	std::error_code ec;
+	std::filesystem::path log_path = std::filesystem::u8path(save_filename_);
+	std::filesystem::path backup_path = std::filesystem::u8path(save_filename_ + '1');
+	if (std::filesystem::exists(log_path, ec)) {
+		std::filesystem::create_hard_link(log_path, backup_path, ec);
+		if (ec) {
+			std::filesystem::copy_file(log_path, backup_path, std::filesystem::copy_options::overwrite_existing, ec);
+		}
+	}
+	// Replace the log in a single step
+	std::filesystem::rename(std::filesystem::u8path(temp_file), log_path, ec);
+	if (ec) {
+		save_error_ = "cannot rename " + temp_file + ": " + ec.message();
+		return false;
+	}
+	// Now compress the backup of an uncompressed log - it is kept uncompressed if this fails
+	if (!compressed && std::filesystem::exists(backup_path, ec)) {
+		std::string backup_file = save_filename_ + '1';
+		std::string compressed_file = backup_file + ".gz";
+		std::string temp_backup = compressed_file + ".tmp";
+		if (gz_streambuf::compress_file(backup_file, temp_backup)) {
+			std::filesystem::rename(std::filesystem::u8path(temp_backup), std::filesystem::u8path(compressed_file), ec);
+			if (ec) {
+				fl_unlink(temp_backup.c_str());
+			}
+			else {
+				fl_unlink(backup_file.c_str());
+			}
+		}
+	}
+	return true;
+}
+
+// Callback from the save std::thread
+void book::cb_save_done(void* v) {
+	if (DEBUG_THREADS) printf("BOOK MAIN: Entered std::thread callback handler\n");
+	((book*)v)->save_done();
+}
+
+// Background save has finished - called in the main std::thread
+void book::save_done() {
+	// Already handled by wait_for_save()
+	if (!th_save_) return;
+	th_save_->join();
+	delete th_save_;
+	th_save_ = nullptr;
+	record::lock_writes_ = false;
+	save_running_ = false;
+	char message[256];
+	if (save_ok_) {
+		// Records changed after the snapshot was taken still need saving
+		for (auto qso : save_dirty_) {
+			if (dirty_during_save_.find(qso) == dirty_during_save_.end()) {
+				dirty_qsos_.erase(qso);
+			}
+		}
+		if (!deleted_during_save_) deleted_record_ = false;
+		size_t num_records = save_records_.size();
+		if (save_header_) num_records++;
+		snprintf(message, sizeof(message), "LOG: %zu records written to %s", num_records, save_filename_.c_str());
+		status_->misc_status(ST_OK, message);
+		// Update file name on window label
+		if (save_changed_file_) main_window_label(save_filename_);
+		// Keep only the journal entries made since the mark
+		if (journal_) journal_->compact(save_journal_size_, save_filename_);
+		// The log file now has the identifiers that the journal uses
+		journal_ids_unsaved_ = false;
+		// The binary snapshot may have seen records in a different state from the log file
+		if (!dirty_during_save_.empty() || deleted_during_save_) {
+			zzb_handler::remove(save_filename_);
+		}
+	}
+	else {
+		snprintf(message, sizeof(message), "LOG: Failed to save %s - %s", save_filename_.c_str(), save_error_.c_str());
+		status_->misc_status(ST_ERROR, message);
+	}
+	delete save_header_;
+	save_header_ = nullptr;
+	delete save_zzb_;
+	save_zzb_ = nullptr;
+	delete save_adi_;
+	save_adi_ = nullptr;
+	save_records_.clear();
+	save_dirty_.clear();
+	dirty_during_save_.clear();
+	// Update menu item activeness - redraw log tables to remove modified hue
+	tabbed_forms_->update_views(nullptr, HT_FORMAT, 0);
+	menu_->update_items();
+	// A save was requested while this one was in progress
+	if (save_pending_) {
+		save_pending_ = false;
+		if (is_dirty()) store_data();
+	}
+}
+
+// Wait for the background save to finish
+void book::wait_for_save() {
+	if (th_save_) {
+		// The caller is about to save or discard the log so do not save again
+		save_pending_ = false;
+		save_done();
+	}
+}
+
+// A background save is in progress
+bool book::save_running() {
+	return save_running_;
+}
+
+// Append the changes to the journal - store the whole log if there is no journal
+bool book::journal_data() {
+	if (!journal_ || !journal_->active() || journal_ids_unsaved_) {
+		return store_data();
+	}
+	if (journal_keys_.empty() && journal_deletes_.empty()) {
+		// Nothing new to save
+		return true;
+	}
+	if (!flush_journal()) {
+		status_->misc_status(ST_WARNING, "LOG: Cannot write to the journal - saving the whole log");
+		return store_data();
+	}
+	if (journal_->entries() >= JOURNAL_COMPACT_ENTRIES && !save_running_) {
+		// Write the whole log in the background - this compacts the journal
+		return store_data();
+	}
+	// Update menu item activeness - redraw log tables to remove modified hue
+	tabbed_forms_->update_views(nullptr, HT_FORMAT, 0);
+	menu_->update_items();
+	return true;
+}
+
+// Append the changed and deleted records to the journal
+bool book::flush_journal() {
+	if (journal_keys_.empty() && journal_deletes_.empty()) {
+		return true;
+	}
+	// Deletions first as a new record may have the key of a deleted one
+	for (auto& key : journal_deletes_) {
+		journal_->remove(key);
+	}
+	for (auto& it : journal_keys_) {
+		journal_->put(it.first, it.second);
+	}
+	if (!journal_->flush()) {
+		return false;
+	}
+	// The changes are now safe in the journal
+	for (auto& it : journal_keys_) {
+		dirty_qsos_.erase(it.first);
+	}
+	char message[128];
+	snprintf(message, sizeof(message), "LOG: %zu changes written to journal",
+		journal_keys_.size() + journal_deletes_.size());
+	status_->misc_status(ST_LOG, message);
+	journal_keys_.clear();
+	journal_deletes_.clear();
+	deleted_record_ = false;
+	return true;
+}
+
+// Append the outstanding changes and a mark to the journal before writing the whole log
+std::streamoff book::mark_journal() {
+	if (!journal_ || !journal_->active()) {
+		return -1;
+	}
+	if (journal_ids_unsaved_ || !flush_journal()) {
+		// The records are still dirty, so the log will include them
+		journal_keys_.clear();
+		journal_deletes_.clear();
+	}
+	// The header holds the mark to say the log includes the journal up to it
+	std::string token = now(false, "%Y%m%d%H%M%S", true);
+	journal_->mark(token);
+	if (journal_->flush()) {
+		header_->item("APP_ZZA_JNL_MARK", token);
+	}
+	else {
+		header_->item("APP_ZZA_JNL_MARK", std::string(""));
+	}
+	return journal_->size();
+}
+
+// The record has been removed from the log
+void book::journal_remove(record* qso) {
+	if (!journal_) return;
+	std::string key;
+	auto it = journal_keys_.find(qso);
+	if (it != journal_keys_.end()) {
+		key = it->second;
+		journal_keys_.erase(it);
+	}
+	else {
+		key = journal::key(qso);
+	}
+	// A record inserted since the last save is not known to the journal
+	if (key.length()) {
+		journal_deletes_.push_back(key);
+	}
+}
+
+// Apply the journal to the log just loaded
+void book::replay_journal() {
+	journal_->log_filename(filename_);
+	std::string base_mark = header_ ? header_->item("APP_ZZA_JNL_MARK") : "";
+	std::vector<record*> entries;
+	journal_->read(base_mark, entries);
+	if (entries.empty()) {
+		return;
+	}
+	for (auto entry : entries) {
+		std::string op = entry->item("APP_ZZA_JNL_OP");
+		std::string key = entry->item("APP_ZZA_JNL_KEY");
+		entry->erase("APP_ZZA_JNL_OP");
+		entry->erase("APP_ZZA_JNL_KEY");
+		record* qso = nullptr;
+		item_num_t pos = key.length() ? journal_position(key) : size();
+		if (pos < size()) {
+			qso = at(pos);
+			// Take it out of the log - it is put back below if it has changed
+			erase(begin() + pos);
+		}
+		if (op == "DEL") {
+			delete qso;
+			delete entry;
+		}
+		else {
+			if (qso) {
+				// Replace the contents of the existing record
+				qso->clear();
+				*qso = *entry;
+				delete entry;
+			}
+			else {
+				qso = entry;
+			}
+			insert_record(qso);
+		}
+	}
+	char message[256];
+	snprintf(message, sizeof(message), "LOG: %zu changes applied from the journal for %s", entries.size(), filename_.c_str());
+	status_->misc_status(ST_NOTE, message);
+}
+
+// Find the QSO with the journal key among those at the time in the key
+item_num_t book::journal_position(const std::string& key) {
+	// "QSO_DATE TIME_ON #APP_ZZA_JNL_ID" or "QSO_DATE TIME_ON CALL" if written before the identifiers
+	size_t date_end = key.find(' ');
+	size_t time_end = key.find(' ', date_end + 1);
+	if (date_end == std::string::npos || time_end == std::string::npos) return size();
+	time_t timestamp = adif_to_time(key.substr(0, date_end), key.substr(date_end + 1, time_end - date_end - 1));
+	if (timestamp == -1) return size();
+	std::string ident = key.substr(time_end + 1);
+	bool legacy = ident.empty() || ident[0] != '#';
+	auto range = time_range(timestamp, timestamp);
+	for (item_num_t ix = range.first; ix < range.second; ix++) {
+		record* qso = at(ix);
+		if (legacy ? qso->item("CALL") == ident : journal::key(qso) == key) return ix;
+	}
+	return size();
+}
+
+// Give the QSOs read from a log written before they had journal identifiers one each
+void book::add_journal_ids() {
+	if (!journal_->active()) return;
+	size_t count = 0;
+	for (auto qso : *this) {
+		if (qso->item("APP_ZZA_JNL_ID").empty()) {
+			qso->item("APP_ZZA_JNL_ID", journal::new_id(qso), false, false);
+			count++;
+		}
+	}
+	if (count) {
+		// The journal is not used until the log has been written with them
+		journal_ids_unsaved_ = true;
+		char message[128];
+		snprintf(message, sizeof(message), "LOG: %zu QSOs given journal identifiers - the whole log is saved next", count);
+		status_->misc_status(ST_NOTE, message);
+	}
+}
+
 // Get the current selected record - return NULL if current_record beyond the size of array
 record* book::get_record() {
 	if (current_item_ < size()) {
@@ -511,7 +965,6 @@ item_num_t book::selection(item_num_t num_item, hint_t hint /* = HT_SELECTED */,
 		switch (hint) {
 		case HT_IMPORT_QUERY:
 		case HT_IMPORT_QUERYNEW:
-		case HT_DUPE_QUERY:
 			// Query against first record in import_data or identified record
 			tabbed_forms_->update_views(requester, hint, record_num, record_number(num_other));
 			break;
@@ -533,6 +986,10 @@ item_num_t book::selection(item_num_t num_item, hint_t hint /* = HT_SELECTED */,
 		case HT_START_CHANGED:
 			// The QSO start date has been changed. Re-order the book and tell everyone
 			this_record = get_record(current_item_, false);
+			// Not a new record - the journal identifies it as last saved
+			if (journal_ && journal_keys_.find(this_record) == journal_keys_.end()) {
+				journal_keys_[this_record] = journal::key(this_record);
+			}
 			erase(begin() + current_item_);
 			record_num = insert_record(this_record);
 			tabbed_forms_->update_views(requester, HT_ALL, record_num);
@@ -548,7 +1005,7 @@ item_num_t book::selection(item_num_t num_item, hint_t hint /* = HT_SELECTED */,
 			save_level_ == 0 && 
 			is_dirty() && 
 			!save_in_progress_ ) {
-			if (AUTO_SAVE) store_data();
+			if (AUTO_SAVE) journal_data();
 		}
 		// Update menu item activeness
 		menu_->update_items();
@@ -580,6 +1037,35 @@ item_num_t book::append_record(record* record) {
 	return pos_record;
 }
 
+// Insert a batch of records - sort them and merge with the existing records in one pass
+void book::insert_records(std::vector<record*>& records) {
+	// operator> compares record date and start time - keep the file order for equal times
+	auto earlier = [](record* lhs, record* rhs) { return *rhs > *lhs; };
+	std::stable_sort(records.begin(), records.end(), earlier);
+	std::vector<record*> merged;
+	merged.reserve(size() + records.size());
+	std::merge(begin(), end(), records.begin(), records.end(), std::back_inserter(merged), earlier);
+	swap(merged);
+	// Now do the bookkeeping that insert_record_at does for each record
+	for (auto qso : records) {
+		if (!loading() && !main_loading_) {
+			// New to the journal
+			if (journal_ && journal_keys_.find(qso) == journal_keys_.end()) {
+				journal_keys_[qso] = "";
+				if (journal_->active()) qso->item("APP_ZZA_JNL_ID", journal::new_id(qso), false, false);
+			}
+			add_dirty_record(qso, "Inserting record");
+		}
+		if (book_type_ == OT_MAIN) {
+			// Update summary lookups
+			if (qso->item("QSO_COMPLETE") == "" || qso->item("QSO_COMPLETE") == "Y") {
+				add_use_data(qso);
+			}
+			add_call(qso);
+		}
+	}
+}
+
 // add a header record
 void book::header(record* header) {
 	delete header_;
@@ -593,14 +1079,23 @@ record* book::header() {
 
 // Delete all records and tidy up
 void book::delete_contents(bool new_book) {
+	// The background save may still be reading the records
+	wait_for_save();
 	// Delete the individual records
 	for (auto it = begin(); it != end(); it++) {
 		delete *it;
 	}
 	// Clear the array
 	clear();
+	calls_.clear();
+	call_grams_.clear();
+	call_changes_.clear();
+	calls_indexed_ = false;
 	// Set it unmodified
 	dirty_qsos_.clear();
+	journal_keys_.clear();
+	journal_deletes_.clear();
+	if (journal_) journal_->log_filename("");
 	filename_ = "";
 	format_ = FT_NONE;
 	delete header_;
@@ -612,9 +1107,7 @@ void book::delete_contents(bool new_book) {
 	used_rigs_.clear();
 	used_antennas_.clear();
 	used_callsigns_.clear();
-	bands_.clear();
-	modes_.clear();
-	submodes_.clear();
+	clear_use();
 	if (new_book && book_type_ == OT_MAIN) {
 		// Delete all non-ADIF defined fields 
 		spec_data_->delete_user_data();
@@ -682,11 +1175,24 @@ item_num_t book::get_insert_point(record* record) {
 	}
 }
 
+// Get the QSOs that start between the times - the records are in start time order
+std::pair<item_num_t, item_num_t> book::time_range(time_t from, time_t to) {
+	auto first = std::partition_point(begin(), end(), [from](record* qso) { return qso->timestamp() < from; });
+	auto last = std::partition_point(first, end(), [to](record* qso) { return qso->timestamp() <= to; });
+	return { first - begin(), last - begin() };
+}
+
 // insert the record at specific position
 void book::insert_record_at(item_num_t pos_record, record* record) {
 	// get the iterator to the insert position
 	insert(begin() + pos_record, record);
-	if (!loading()) {
+	if (book_type_ == OT_MAIN) add_call(record);
+	if (!loading() && !main_loading_) {
+		// New to the journal
+		if (journal_ && journal_keys_.find(record) == journal_keys_.end()) {
+			journal_keys_[record] = "";
+			if (journal_->active()) record->item("APP_ZZA_JNL_ID", journal::new_id(record), false, false);
+		}
 		add_dirty_record(record, "Inserting record");
 	}
 	if (book_type_ == OT_MAIN) {
@@ -697,6 +1203,264 @@ void book::insert_record_at(item_num_t pos_record, record* record) {
 	}
 }
 
+// Get the position of the QSO with the identifier
+item_num_t book::position(qso_id_t id) {
+	return find_id(id);
+}
+
+// Get the QSOs with the call - from the index in the main log
+std::vector<item_num_t> book::qsos_with_call(std::string call) {
+	call = to_upper(call);
+	std::vector<item_num_t> result;
+	if (book_type_ == OT_MAIN) {
+		// The key also finds QSOs where this call is only the body of theirs
+		for (auto pos : qsos_with_key(call)) {
+			if (at(pos)->item(FI_CALL) == call) result.push_back(pos);
+		}
+	}
+	else {
+		for (item_num_t pos = 0; pos < size(); pos++) {
+			if (at(pos)->item(FI_CALL) == call) result.push_back(pos);
+		}
+	}
+	return result;
+}
+
+// Get the QSOs that may be with the same station - all of them if this is not the main log
+std::vector<item_num_t> book::qsos_like_call(std::string call) {
+	call = to_upper(call);
+	std::vector<item_num_t> result;
+	if (book_type_ == OT_MAIN) {
+		for (auto& key : call_keys(call, false)) {
+			std::vector<item_num_t> found = qsos_with_key(key);
+			result.insert(result.end(), found.begin(), found.end());
+		}
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+	}
+	else {
+		for (item_num_t pos = 0; pos < size(); pos++) {
+			result.push_back(pos);
+		}
+	}
+	return result;
+}
+
+// Get the keys for the call - e.g. G4ABC/P gives G4ABC/P, G4ABC (and P if every part), and GM4ABC gives GM4ABC and G4ABC
+std::vector<std::string> book::call_keys(const std::string& call, bool every_part) {
+	std::vector<std::string> keys = { call };
+	std::vector<std::string> parts;
+	split_line(call, parts, '/');
+	std::smatch m;
+	for (auto& part : parts) {
+		std::vector<std::string> part_keys;
+		if (regex_search(part, m, REGEX_CALL_BODY)) {
+			part_keys = { part, m[1].str() + m[2].str() };
+		}
+		else if (every_part) {
+			part_keys = { part };
+		}
+		for (auto& key : part_keys) {
+			if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+				keys.push_back(key);
+			}
+		}
+	}
+	return keys;
+}
+
+// Add the QSO under each of the keys for its call
+void book::add_call(record* qso) {
+	if (!calls_indexed_) return;
+	std::string call = qso->item(FI_CALL);
+	if (call.empty()) return;
+	for (auto& key : call_keys(call, true)) {
+		std::vector<qso_id_t>& ids = calls_[key];
+		if (ids.empty()) {
+			// A new key - index it by its trigrams
+			for (size_t ix = 0; ix + 3 <= key.length(); ix++) {
+				call_grams_[key.substr(ix, 3)].insert(key);
+			}
+		}
+		if (std::find(ids.begin(), ids.end(), qso->id()) == ids.end()) {
+			ids.push_back(qso->id());
+		}
+	}
+}
+
+// Remove the key from the callsign index
+void book::drop_call_key(const std::string& key) {
+	for (size_t ix = 0; ix + 3 <= key.length(); ix++) {
+		auto it = call_grams_.find(key.substr(ix, 3));
+		if (it != call_grams_.end()) {
+			it->second.erase(key);
+			if (it->second.empty()) call_grams_.erase(it);
+		}
+	}
+	calls_.erase(key);
+}
+
+// Build the callsign index if it has not yet been
+void book::index_calls() {
+	if (!calls_indexed_) {
+		calls_indexed_ = true;
+		call_changes_.clear();
+		for (auto qso : *this) {
+			add_call(qso);
+		}
+	}
+	else {
+		index_call_changes();
+	}
+}
+
+// Move the QSOs whose CALL has changed from the keys of their old call
+void book::index_call_changes() {
+	for (auto& change : call_changes_) {
+		record* qso = change.first;
+		if (qso->item(FI_CALL) == change.second) continue;
+		for (auto& key : call_keys(change.second, true)) {
+			auto it = calls_.find(key);
+			if (it != calls_.end()) {
+				std::vector<qso_id_t>& ids = it->second;
+				ids.erase(std::remove(ids.begin(), ids.end(), qso->id()), ids.end());
+				if (ids.empty()) drop_call_key(key);
+			}
+		}
+		add_call(qso);
+	}
+	call_changes_.clear();
+}
+
+// Get the QSOs indexed by the key - building the index when it is first used
+std::vector<item_num_t> book::qsos_with_key(const std::string& key) {
+	std::vector<item_num_t> result;
+	index_calls();
+	auto it = calls_.find(key);
+	if (it == calls_.end()) return result;
+	std::vector<qso_id_t>& ids = it->second;
+	for (auto id = ids.begin(); id != ids.end(); ) {
+		item_num_t pos = position(*id);
+		if (pos == -1) {
+			// The QSO has been deleted
+			id = ids.erase(id);
+		}
+		else {
+			result.push_back(pos);
+			id++;
+		}
+	}
+	if (ids.empty()) drop_call_key(key);
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Get the calls in the log that match the pattern - only testing those that contain its literal text
+std::vector<std::string> book::calls_matching(const std::string& pattern) {
+	std::basic_regex<char> regex(to_upper(pattern));
+	std::string literal = regex_literal(to_upper(pattern));
+	index_calls();
+	std::vector<std::string> candidates;
+	if (literal.length() >= 3) {
+		// Use the calls with the least common trigram of the text
+		const std::set<std::string>* fewest = nullptr;
+		for (size_t ix = 0; ix + 3 <= literal.length(); ix++) {
+			auto it = call_grams_.find(literal.substr(ix, 3));
+			if (it == call_grams_.end()) return candidates;
+			if (fewest == nullptr || it->second.size() < fewest->size()) fewest = &it->second;
+		}
+		for (auto& key : *fewest) {
+			if (key.find(literal) != std::string::npos) candidates.push_back(key);
+		}
+	}
+	else {
+		for (auto& entry : calls_) {
+			candidates.push_back(entry.first);
+		}
+	}
+	std::vector<std::string> result;
+	for (auto& key : candidates) {
+		// The keys include the parts of calls - only return the calls themselves
+		if (regex_match(key, regex) && qsos_with_call(key).size()) {
+			result.push_back(key);
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+// Get the longest text that every match of the pattern must contain
+std::string book::regex_literal(const std::string& pattern) {
+	std::string longest;
+	std::string run;
+	// Alternatives can match without any one piece of text
+	if (pattern.find('|') != std::string::npos) return longest;
+	auto end_run = [&]() {
+		if (run.length() > longest.length()) longest = run;
+		run = "";
+	};
+	int depth = 0;
+	for (size_t ix = 0; ix < pattern.length(); ix++) {
+		char c = pattern[ix];
+		char next = ix + 1 < pattern.length() ? pattern[ix + 1] : '\0';
+		if (c == '\\') {
+			// Escaped character - skip it
+			end_run();
+			ix++;
+		}
+		else if (c == '[') {
+			// Character class - skip to its end
+			end_run();
+			ix = pattern.find(']', ix + 2);
+			if (ix == std::string::npos) return "";
+		}
+		else if (c == '{') {
+			// Repeat count - skip to its end
+			end_run();
+			ix = pattern.find('}', ix + 1);
+			if (ix == std::string::npos) return "";
+		}
+		else if (c == '(' || c == ')') {
+			// Only text outside groups is certain to be matched
+			end_run();
+			depth += c == '(' ? 1 : -1;
+		}
+		else if (depth == 0 && (isalnum(c) || c == '/') && next != '*' && next != '?' && next != '{') {
+			run += c;
+			// Repeated so the next character may not follow it
+			if (next == '+') end_run();
+		}
+		else {
+			end_run();
+		}
+	}
+	end_run();
+	return longest;
+}
+
+// Get the QSOs that the search criteria can match using the callsign index
+bool book::call_candidates(search_criteria_t* criteria, std::vector<item_num_t>& found) {
+	found.clear();
+	if (book_type_ != OT_MAIN || criteria->condition != XC_CALL) return false;
+	switch (criteria->comparator) {
+	case XP_EQ:
+		if (criteria->pattern.empty()) return false;
+		found = qsos_with_call(criteria->pattern);
+		return true;
+	case XP_REGEX:
+		// QSOs with no CALL are not indexed
+		if (regex_match(std::string(""), std::basic_regex<char>(to_upper(criteria->pattern)))) return false;
+		for (auto& call : calls_matching(criteria->pattern)) {
+			std::vector<item_num_t> qsos = qsos_with_call(call);
+			found.insert(found.end(), qsos.begin(), qsos.end());
+		}
+		std::sort(found.begin(), found.end());
+		return true;
+	default:
+		return false;
+	}
+}
+
 // Navigate the log - i.e. go to specific position
 void book::navigate(navigate_t target) {
 	switch (target) {
@@ -794,8 +1558,13 @@ void book::delete_record(bool force) {
 			record* del_record = get_record();
 			delete_dirty_record(del_record);
 			if (book_type_ == OT_EXTRACT) {
-				book_->erase(book_->begin() + record_number(current_item_));
+				qso_num_t record_num = record_number(current_item_);
+				book_->journal_remove(del_record);
+				book_->call_changes_.erase(del_record);
+				book_->erase(book_->begin() + record_num);
 			} 
+			journal_remove(del_record);
+			call_changes_.erase(del_record);
 			erase(begin() + current_item_);
 			// if current record no longer exists decrement it (exept if already first record)
 			if (current_item_ == size() && current_item_ > 0) {
@@ -805,6 +1574,7 @@ void book::delete_record(bool force) {
 			selection(current_item_, HT_DELETED);
 			new_record_ = false;
 			deleted_record_ = true;
+			if (save_running_) deleted_during_save_ = true;
 			// After selection has done its all can allow another delete
 			delete_in_progress_ = false;
 			menu_->update_items();
@@ -829,7 +1599,7 @@ void book::delete_record(bool force) {
 		menu_->update_items();
 	}
 	if (AUTO_SAVE && save_level_ == 0 && !READ_ONLY && is_dirty()) {
-		store_data();
+		journal_data();
 	}
 
 }
@@ -839,6 +1609,10 @@ item_num_t book::correct_record_position(item_num_t current_pos) {
 	// First delete the old position so it doesn't confuse GetOffset
 	// Save the record first
 	record* this_record = get_record(current_pos, false);
+	// Not a new record - the journal identifies it as last saved
+	if (journal_ && journal_keys_.find(this_record) == journal_keys_.end()) {
+		journal_keys_[this_record] = journal::key(this_record);
+	}
 	// remove record at existing position
 	erase(begin() + current_pos);
 	// now insert it in the correct position and other bookkeeping
@@ -861,15 +1635,15 @@ bool book::basic_match(record* record) {
 		return true;
 	case XC_CALL:
 		// match by callsign
-		return match_string(criteria_->pattern, criteria_->comparator, record->item("CALL"));
+		return match_string(criteria_->pattern, criteria_->comparator, record->item(FI_CALL));
 		break;
 	case XC_CONT:
 		// match by continent
-		return match_string(criteria_->pattern, criteria_->comparator, record->item("CONT"));
+		return match_string(criteria_->pattern, criteria_->comparator, record->item(FI_CONT));
 		break;
 	case XC_CQZ:
 		// match by CQ Zone number
-		return match_int(criteria_->pattern, criteria_->comparator, record->item("CQZ"));
+		return match_int(criteria_->pattern, criteria_->comparator, record->item(FI_CQZ));
 		break;
 	case XC_DXCC:
 	{
@@ -877,16 +1651,16 @@ bool book::basic_match(record* record) {
 		int dxcc = cty_data_->entity(criteria_->pattern);
 		if (criteria_->pattern.length() == 0) {
 			// Null std::string - check records with no value
-			return match_string(criteria_->pattern, criteria_->comparator, record->item("DXCC"));
+			return match_string(criteria_->pattern, criteria_->comparator, record->item(FI_DXCC));
 		}
 		else if (dxcc == -1 || criteria_->comparator == XP_LT || criteria_->comparator == XP_LE ||
 			criteria_->comparator == XP_GE || criteria_->comparator == XP_GT) {
 			// Not a nickname so match against the raw value
-			return match_int(criteria_->pattern, criteria_->comparator, record->item("DXCC"));
+			return match_int(criteria_->pattern, criteria_->comparator, record->item(FI_DXCC));
 		}
 		else {
 			// Treat as a nickname - match against the dxcc value for the nickname
-			return match_string(std::to_string(dxcc), criteria_->comparator, record->item("DXCC"));
+			return match_string(std::to_string(dxcc), criteria_->comparator, record->item(FI_DXCC));
 		}
 	}
 	case XC_FIELD:
@@ -895,21 +1669,21 @@ bool book::basic_match(record* record) {
 		break;
 	case XC_ITUZ:
 		// match by ITU zone number
-		return match_int(criteria_->pattern, criteria_->comparator, record->item("ITUZ"));
+		return match_int(criteria_->pattern, criteria_->comparator, record->item(FI_ITUZ));
 		break;
 	case XC_SQ2:
 		// match by first two characters of locator
 		// condition too short
 		if (criteria_->pattern.length() < 2) break;
 		// gridsquare in record too short
-		if (criteria_->comparator != XP_REGEX && record->item("GRIDSQUARE").length() < 2) break;
-		return match_string(criteria_->pattern.substr(0, 2), criteria_->comparator, record->item("GRIDSQUARE").substr(0, 2));
+		if (criteria_->comparator != XP_REGEX && record->item(FI_GRIDSQUARE).length() < 2) break;
+		return match_string(criteria_->pattern.substr(0, 2), criteria_->comparator, record->item(FI_GRIDSQUARE).substr(0, 2));
 		break;
 	case XC_SQ4:
 		// match by first 4 charactes of locator
 		if (criteria_->pattern.length() < 4) break;
-		if (criteria_->comparator != XP_REGEX && record->item("GRIDSQUARE").length() < 4) break;
-		return match_string(criteria_->pattern.substr(0, 4), criteria_->comparator, record->item("GRIDSQUARE").substr(0, 4));
+		if (criteria_->comparator != XP_REGEX && record->item(FI_GRIDSQUARE).length() < 4) break;
+		return match_string(criteria_->pattern.substr(0, 4), criteria_->comparator, record->item(FI_GRIDSQUARE).substr(0, 4));
 		break;
 	default:
 		return false;
@@ -922,35 +1696,35 @@ bool book::basic_match(record* record) {
 bool book::refine_match(record* record) {
 	// now refine by dates
 	if (criteria_->by_dates) {
-		std::string record_date = record->item("QSO_DATE");
+		std::string record_date = record->item(FI_QSO_DATE);
 		// confirm the match is between specified dates - inclusive
 		if (record_date < criteria_->from_date || record_date > criteria_->to_date) {
 			return false;
 		}
 	}
 	// now refine by band - confirm if the record is on that band
-	if (criteria_->band != "Any" && criteria_->band != record->item("BAND")) {
+	if (criteria_->band != "Any" && criteria_->band != record->item(FI_BAND)) {
 		return false;
 	}
 	// Refine by mode - confirm if the record has that mode 
-	if (criteria_->mode != "Any" && criteria_->mode != record->item("MODE") &&
-		criteria_->mode != record->item("SUBMODE")) {
+	if (criteria_->mode != "Any" && criteria_->mode != record->item(FI_MODE) &&
+		criteria_->mode != record->item(FI_SUBMODE)) {
 		return false;
 	}
 	// Refine by call - confirm if the record matches my_call (STATION_CALLSIGN)
-	if (criteria_->my_call != "Any" && criteria_->my_call != record->item("STATION_CALLSIGN")) {
+	if (criteria_->my_call != "Any" && criteria_->my_call != record->item(FI_STATION_CALLSIGN)) {
 		return false;
 	}
 	// Refine by eQSL card - confirm if eQSL confirmation
-	if (criteria_->confirmed_eqsl && record->item("EQSL_QSL_RCVD") != "Y") {
+	if (criteria_->confirmed_eqsl && record->item(FI_EQSL_QSL_RCVD) != "Y") {
 		return false;
 	}
 	// Refine by LotW - confirm if LotW confirmation
-	if (criteria_->confirmed_eqsl && record->item("LOTW_QSL_RCVD") != "Y") {
+	if (criteria_->confirmed_eqsl && record->item(FI_LOTW_QSL_RCVD) != "Y") {
 		return false;
 	}
 	// Refine by card - confirm if card confirmation
-	if (criteria_->confirmed_card && record->item("QSL_RCVD") != "Y") {
+	if (criteria_->confirmed_card && record->item(FI_QSL_RCVD) != "Y") {
 		return false;
 	}
 	return true;
@@ -960,8 +1734,13 @@ bool book::refine_match(record* record) {
 bool book::match_string(std::string test, int comparator, std::string value) {
 	switch ((search_comp_t)comparator) {
 	case XP_REGEX: {
-		std::basic_regex<char> regex(to_upper(test));
-		return regex_match(to_upper(value), regex);
+		// Compile the pattern only when it changes
+		std::string pattern = to_upper(test);
+		if (pattern != regex_text_) {
+			regex_ = std::basic_regex<char>(pattern);
+			regex_text_ = pattern;
+		}
+		return regex_match(to_upper(value), regex_);
 	}
 	case XP_NE:
 		return (to_upper(value) != to_upper(test));
@@ -1021,7 +1800,16 @@ item_num_t book::search(search_criteria_t* criteria, bool reset_search) {
 	else {
 		ix = last_search_result_ + 1;
 	}
-	for (; ix < size() && !match_record(get_record(ix, false)); ix++) {}
+	std::vector<item_num_t> found;
+	if (call_candidates(criteria_, found)) {
+		// Only look at the QSOs with a matching call
+		auto it = std::lower_bound(found.begin(), found.end(), ix);
+		for (; it != found.end() && !match_record(get_record(*it, false)); it++) {}
+		ix = it == found.end() ? size() : *it;
+	}
+	else {
+		for (; ix < size() && !match_record(get_record(ix, false)); ix++) {}
+	}
 	if (ix < size()) {
 		last_search_result_ = ix;
 	}
@@ -1042,16 +1830,16 @@ void book::book_type(object_t value) {
 // Add the band and mode to the lists of used bands and modes if not already there
 void book::add_use_data(record* use_record) {
 	// Do not look at SWL records
-	if (use_record->item("SWL") == "") {
-		std::string band = use_record->item("BAND");
-		std::string dxcc = use_record->item("DXCC");
-		std::string call = use_record->item("STATION_CALLSIGN");
-		std::string grid = use_record->item("GRIDSQUARE");
+	if (use_record->item(FI_SWL) == "") {
+		std::string band = use_record->item(FI_BAND);
+		std::string dxcc = use_record->item(FI_DXCC);
+		std::string call = use_record->item(FI_STATION_CALLSIGN);
+		std::string grid = use_record->item(FI_GRIDSQUARE);
 		if (grid.length() < 4) grid = "";
 		else grid = grid.substr(0, 4);
-		std::string cqz = use_record->item("CQZ");
-		std::string ituz = use_record->item("ITUZ");
-		std::string cont = use_record->item("CONT");
+		std::string cqz = use_record->item(FI_CQZ);
+		std::string ituz = use_record->item(FI_ITUZ);
+		std::string cont = use_record->item(FI_CONT);
 
 		if (band == "") {
 			// Get the band from the frequency 
@@ -1060,51 +1848,26 @@ void book::add_use_data(record* use_record) {
 			band = spec_data_->band_for_freq(freq);
 			use_record->item("BAND", band);
 		}
-		if (band.length()) {
-			used_bands_.insert(band);
-			bands_[call][WK_DXCC][dxcc].insert(band);
-			bands_[call][WK_GRID4][grid].insert(band);
-			bands_[call][WK_CQZ][cqz].insert(band);
-			bands_[call][WK_ITUZ][ituz].insert(band);
-			bands_[call][WK_CONT][cont].insert(band);
-			bands_[""][WK_DXCC][dxcc].insert(band);
-			bands_[""][WK_GRID4][grid].insert(band);
-			bands_[""][WK_CQZ][cqz].insert(band);
-			bands_[""][WK_ITUZ][ituz].insert(band);
-			bands_[""][WK_CONT][cont].insert(band);
-		}
-		std::string mode = use_record->item("MODE");
-		if (mode.length()) {
-			used_modes_.insert(mode);
-			modes_[call][WK_DXCC][dxcc].insert(mode);
-			modes_[call][WK_GRID4][grid].insert(mode);
-			modes_[call][WK_CQZ][cqz].insert(mode);
-			modes_[call][WK_ITUZ][ituz].insert(mode);
-			modes_[call][WK_CONT][cont].insert(mode);
-			modes_[""][WK_DXCC][dxcc].insert(mode);
-			modes_[""][WK_GRID4][grid].insert(mode);
-			modes_[""][WK_CQZ][cqz].insert(mode);
-			modes_[""][WK_ITUZ][ituz].insert(mode);
-			modes_[""][WK_CONT][cont].insert(mode);
-		}
-		std::string submode = use_record->item("SUBMODE");
+		std::string mode = use_record->item(FI_MODE);
+		std::string submode = use_record->item(FI_SUBMODE);
 		if (!submode.length()) {
-			submode = use_record->item("MODE");
-		}
-		if (submode.length()) {
-			used_submodes_.insert(submode);
-			submodes_[call][WK_DXCC][dxcc].insert(submode);
-			submodes_[call][WK_GRID4][grid].insert(submode);
-			submodes_[call][WK_CQZ][cqz].insert(submode);
-			submodes_[call][WK_ITUZ][ituz].insert(submode);
-			submodes_[call][WK_CONT][cont].insert(submode);
-			submodes_[""][WK_DXCC][dxcc].insert(submode);
-			submodes_[""][WK_GRID4][grid].insert(submode);
-			submodes_[""][WK_CQZ][cqz].insert(submode);
-			submodes_[""][WK_ITUZ][ituz].insert(submode);
-			submodes_[""][WK_CONT][cont].insert(submode);
-		}
-		std::string rig = use_record->item("MY_RIG");
+			submode = use_record->item(FI_MODE);
+		}
+		if (band.length()) used_bands_.insert(band);
+		if (mode.length()) used_modes_.insert(mode);
+		if (submode.length()) used_submodes_.insert(submode);
+		// Add them to the cells for each category for this station callsign and for all
+		uint32_t band_id = use_id(use_value_ids_, use_values_, band);
+		uint32_t mode_id = use_id(use_value_ids_, use_values_, mode);
+		uint32_t submode_id = use_id(use_value_ids_, use_values_, submode);
+		const std::pair<worked_t, const std::string*> entities[] = {
+			{ WK_DXCC, &dxcc }, { WK_GRID4, &grid }, { WK_CQZ, &cqz }, { WK_ITUZ, &ituz }, { WK_CONT, &cont }
+		};
+		for (auto& entity : entities) {
+			add_use(use_cell(entity.first, *entity.second, call), band_id, mode_id, submode_id);
+			add_use(use_cell(entity.first, *entity.second, ""), band_id, mode_id, submode_id);
+		}
+		std::string rig = use_record->item(FI_MY_RIG);
 		bool update_spec = false;
 		if (rig.length()) {
 			if (used_rigs_.find(rig) == used_rigs_.end()) {
@@ -1113,7 +1876,7 @@ void book::add_use_data(record* use_record) {
 				update_spec = true;
 			}
 		}
-		std::string antenna = use_record->item("MY_ANTENNA");
+		std::string antenna = use_record->item(FI_MY_ANTENNA);
 		if (antenna.length()) {
 			if (used_antennas_.find(antenna) == used_antennas_.end()) {
 				used_antennas_.insert(antenna);
@@ -1121,7 +1884,7 @@ void book::add_use_data(record* use_record) {
 				update_spec = true;
 			}
 		}
-		std::string callsign = use_record->item("STATION_CALLSIGN");
+		std::string callsign = use_record->item(FI_STATION_CALLSIGN);
 		if (callsign.length()) {
 			if (used_callsigns_.find(callsign) == used_callsigns_.end()) {
 				used_callsigns_.insert(callsign);
@@ -1139,6 +1902,8 @@ void book::add_use_data(record* use_record) {
 }
 
 void book::deprecate_macros(record* use_record) {
+	// No station data - e.g. the headless benchmark
+	if (stn_data_ == nullptr) return;
 	char msg[128];
 	// If APP_ZZA_QTH is present - take its values and send to stn_data
 	std::string qth_id = use_record->item("APP_ZZA_QTH");
@@ -1226,13 +1991,10 @@ band_set* book::used_bands(worked_t category = WK_ANY, int32_t entity = 0, std::
 }
 
 band_set* book::used_bands(worked_t category = WK_ANY, std::string entity = "", std::string call = "") {
-	band_set* result = nullptr;
 	if (category == WK_ANY) return &used_bands_;
-	else if (bands_.find(call) == bands_.end());
-	else if (bands_.at(call).find(category) == bands_.at(call).end());
-	else if (bands_.at(call).at(category).find(entity) == bands_.at(call).at(category).end() || entity == "-1");
-	else return &bands_.at(call).at(category).at(entity);
-	return result;
+	use_cell_t* cell = entity == "-1" ? nullptr : find_use_cell(category, entity, call);
+	if (cell == nullptr || cell->bands.empty()) return nullptr;
+	return &cell->bands;
 }
 
 // get used modes
@@ -1245,13 +2007,10 @@ std::set<std::string>* book::used_modes(worked_t category = WK_ANY, int32_t enti
 }
 
 std::set<std::string>* book::used_modes(worked_t category = WK_ANY, std::string entity = "", std::string call = "") {
-	std::set<std::string>* result = nullptr;
 	if (category == WK_ANY) return &used_modes_;
-	else if (modes_.find(call) == modes_.end());
-	else if (modes_.at(call).find(category) == modes_.at(call).end());
-	else if (modes_.at(call).at(category).find(entity) == modes_.at(call).at(category).end() || entity == "-1");
-	else return &modes_.at(call).at(category).at(entity);
-	return result;
+	use_cell_t* cell = entity == "-1" ? nullptr : find_use_cell(category, entity, call);
+	if (cell == nullptr || cell->modes.empty()) return nullptr;
+	return &cell->modes;
 }
 
 // get used submodes
@@ -1264,13 +2023,67 @@ std::set<std::string>* book::used_submodes(worked_t category = WK_ANY, int32_t e
 }
 
 std::set<std::string>* book::used_submodes(worked_t category = WK_ANY, std::string entity = "", std::string call = "") {
-	std::set<std::string>* result = nullptr;
 	if (category == WK_ANY) return &used_submodes_;
-	else if (submodes_.find(call) == submodes_.end());
-	else if (submodes_.at(call).find(category) == submodes_.at(call).end());
-	else if (submodes_.at(call).at(category).find(entity) == submodes_.at(call).at(category).end() || entity == "-1");
-	else return &submodes_.at(call).at(category).at(entity);
-	return result;
+	use_cell_t* cell = entity == "-1" ? nullptr : find_use_cell(category, entity, call);
+	if (cell == nullptr || cell->submodes.empty()) return nullptr;
+	return &cell->submodes;
+}
+
+// Get the identifier of the name - adding it if new
+uint32_t book::use_id(std::unordered_map<std::string, uint32_t>& ids, std::vector<std::string>& names, const std::string& name) {
+	auto it = ids.find(name);
+	if (it != ids.end()) return it->second;
+	uint32_t id = (uint32_t)names.size();
+	ids[name] = id;
+	names.push_back(name);
+	return id;
+}
+
+// Key of the cell: station callsign in the top 24 bits, then the category and then the entity
+uint64_t book::use_key(uint32_t call, worked_t category, uint32_t entity) {
+	return ((uint64_t)call << 40) | ((uint64_t)category << 32) | entity;
+}
+
+// Get the worked-before cell - adding it if new
+book::use_cell_t& book::use_cell(worked_t category, const std::string& entity, const std::string& call) {
+	uint32_t call_id = use_id(use_key_ids_, use_keys_, call);
+	uint32_t entity_id = use_id(use_key_ids_, use_keys_, entity);
+	return use_cells_[use_key(call_id, category, entity_id)];
+}
+
+// Find the worked-before cell without adding it
+book::use_cell_t* book::find_use_cell(worked_t category, const std::string& entity, const std::string& call) {
+	auto it_call = use_key_ids_.find(call);
+	auto it_entity = use_key_ids_.find(entity);
+	if (it_call == use_key_ids_.end() || it_entity == use_key_ids_.end()) return nullptr;
+	auto it = use_cells_.find(use_key(it_call->second, category, it_entity->second));
+	if (it == use_cells_.end()) return nullptr;
+	return &it->second;
+}
+
+// Add the band, mode and submode to the cell - the sets only change the first time each is seen
+void book::add_use(use_cell_t& cell, uint32_t band, uint32_t mode, uint32_t submode) {
+	if (mark_use(cell.band_bits, band)) cell.bands.insert(use_values_[band]);
+	if (mark_use(cell.mode_bits, mode)) cell.modes.insert(use_values_[mode]);
+	if (mark_use(cell.submode_bits, submode)) cell.submodes.insert(use_values_[submode]);
+}
+
+// Set the bit for the value - returns true if it was not already set
+bool book::mark_use(std::vector<bool>& bits, uint32_t id) {
+	if (use_values_[id].empty()) return false;
+	if (bits.size() <= id) bits.resize(id + 1);
+	if (bits[id]) return false;
+	bits[id] = true;
+	return true;
+}
+
+// Remove the worked-before tables
+void book::clear_use() {
+	use_cells_.clear();
+	use_key_ids_.clear();
+	use_keys_.clear();
+	use_value_ids_.clear();
+	use_values_.clear();
 }
 
 // Returns true if a new record being entered
@@ -1293,7 +2106,7 @@ void book::enable_save(bool enable, const char* reason) {
 	snprintf(msg, sizeof(msg), "LOG: Setting save enable level %d - %s", save_level_, reason);
 	status_->misc_status(ST_LOG, msg);
 	if (AUTO_SAVE && save_level_ == 0 && !READ_ONLY && is_dirty()) {
-		store_data();
+		journal_data();
 	}
 }
 
@@ -1302,108 +2115,299 @@ bool book::enable_save() {
 	return save_level_ == 0;
 }
 
-// Check duplicates - restart std::set after a query to confirm it's a duplicate
-void book::check_dupes(bool restart) {
-	if (!restart) {
-		test_item_ = 0;
-		// Only check N - 1 entries against the next entry
-		status_->misc_status(ST_NOTE, "LOG: Duplicate checking started");
-		status_->progress(size() - 1, book_type(), "Checking log for duplicates", "duplicates");
-		inhibit_view_update_ = true;
-		number_dupes_kept_ = 0;
-		number_dupes_removed_ = 0;
-		enable_save(false, "Checking dupes");
-	}
-	bool possible_dupe = false;
-	for (; test_item_ < size() - 1 && !possible_dupe;) {
-		// Get adjacent records
-		record* record_1 = get_record(test_item_, true);
-		record* record_2;
-		match_result_t match = MT_OVERLAP;
-		// MT_OVERLAP indicates it overlaps but not same call.
-		for (dupe_item_ = test_item_ + 1; 
-			dupe_item_ < size() && match == MT_OVERLAP;
-		    ) {
-			record_2 = get_record(dupe_item_, false);
-			match = record_1->match_records(record_2);
-			if (match == MT_OVERLAP) dupe_item_++;
+// Check for duplicates - find the overlapping QSOs in a separate std::thread
+void book::check_dupes() {
+	if (th_dupes_) {
+		status_->misc_status(ST_WARNING, "LOG: Duplicate check already in progress");
+		return;
+	}
+	status_->misc_status(ST_NOTE, "LOG: Duplicate checking started");
+	snapshot_dupes();
+	if (DEBUG_THREADS) printf("BOOK MAIN: Starting duplicate check std::thread\n");
+	th_dupes_ = new std::thread(thread_dupes, this);
+}
+
+// Find the pairs of QSOs that may be duplicates without a separate std::thread
+void book::find_dupes() {
+	snapshot_dupes();
+	dupe_pairs_ = find_overlaps(dupe_qsos_);
+	dupe_qsos_.clear();
+	char message[128];
+	snprintf(message, sizeof(message), "LOG: %zu pairs of QSOs overlap with the same call, band and mode", dupe_pairs_.size());
+	status_->misc_status(ST_NOTE, message);
+}
+
+// Copy the QSOs for the duplicate check - records are only changed in this std::thread
+void book::snapshot_dupes() {
+	dupe_pairs_.clear();
+	dupe_qsos_.clear();
+	dupe_qsos_.reserve(size());
+	for (auto it = begin(); it != end(); it++) {
+		dupe_qsos_.push_back((*it)->snapshot());
+	}
+}
+
+// Find the pairs of QSOs with the same call, band and mode whose times overlap
+std::vector<std::pair<qso_id_t, qso_id_t> > book::find_overlaps(const std::vector<std::unique_ptr<record> >& qsos) {
+	// QSOs are hashed by the 30 minute period they start in
+	const time_t PERIOD = 1800;
+	// A QSO with a wrong end date would otherwise make every QSO look back that far
+	const time_t LONGEST = 24 * 60 * 60;
+	struct entry_t {
+		qso_id_t id;
+		std::string call;
+		std::string band;
+		std::string mode;
+		time_t time_on;
+		time_t time_off;
+	};
+	std::vector<entry_t> entries;
+	entries.reserve(qsos.size());
+	for (auto& qso : qsos) {
+		std::string call = to_upper(qso->item(FI_CALL));
+		if (call.empty()) continue;
+		// As in record::match_records a QSO is taken to last at least 30 minutes
+		time_t time_on = qso->timestamp();
+		time_t time_off = std::min(std::max(qso->timestamp(true), time_on + PERIOD), time_on + LONGEST);
+		entries.push_back({ qso->id(), call, to_upper(qso->item(FI_BAND)), to_upper(qso->item(FI_MODE)), time_on, time_off });
+	}
+	// An extract may have been sorted by another field
+	std::stable_sort(entries.begin(), entries.end(), [](const entry_t& lhs, const entry_t& rhs) {
+		return lhs.time_on < rhs.time_on;
+	});
+	// Each QSO is hashed as call + band + mode, call + mode (any band), call + band (any mode) 
+	// and call (any band or mode) so that a QSO with a blank band or mode can find every QSO
+	// it may match - each earlier QSO is found at most once whichever of these is searched
+	auto hash_key = [](char kind, const std::string& call, const std::string& band, const std::string& mode, time_t period) {
+		return std::string(1, kind) + call + '\t' + band + '\t' + mode + '\t' + std::to_string(period);
+	};
+	std::unordered_map<std::string, std::vector<size_t> > hashed;
+	std::vector<std::pair<qso_id_t, qso_id_t> > pairs;
+	// The longest QSO so far - an earlier QSO still in progress started no earlier than this before
+	time_t longest = PERIOD;
+	for (size_t ix = 0; ix < entries.size(); ix++) {
+		const entry_t& entry = entries[ix];
+		// The (band, mode) combinations of earlier QSOs that this QSO may match
+		std::vector<std::pair<char, std::pair<std::string, std::string> > > searches;
+		if (entry.band.length() && entry.mode.length()) {
+			searches.push_back({ 'E', { entry.band, entry.mode } });
+			searches.push_back({ 'E', { "", entry.mode } });
+			searches.push_back({ 'E', { entry.band, "" } });
+			searches.push_back({ 'E', { "", "" } });
+		}
+		else if (entry.mode.length()) {
+			searches.push_back({ 'M', { "", entry.mode } });
+			searches.push_back({ 'M', { "", "" } });
+		}
+		else if (entry.band.length()) {
+			searches.push_back({ 'B', { entry.band, "" } });
+			searches.push_back({ 'B', { "", "" } });
+		}
+		else {
+			searches.push_back({ 'A', { "", "" } });
+		}
+		// Look in this period and the neighbouring earlier ones
+		for (time_t period = (entry.time_on - longest) / PERIOD; period <= entry.time_on / PERIOD; period++) {
+			for (auto& search : searches) {
+				auto it = hashed.find(hash_key(search.first, entry.call, search.second.first, search.second.second, period));
+				if (it == hashed.end()) continue;
+				for (size_t earlier : it->second) {
+					// Sorted by start time so only check that it has not ended
+					if (entries[earlier].time_off >= entry.time_on) {
+						pairs.push_back({ entries[earlier].id, entry.id });
+					}
+				}
+			}
+		}
+		time_t period = entry.time_on / PERIOD;
+		hashed[hash_key('E', entry.call, entry.band, entry.mode, period)].push_back(ix);
+		hashed[hash_key('M', entry.call, "", entry.mode, period)].push_back(ix);
+		hashed[hash_key('B', entry.call, entry.band, "", period)].push_back(ix);
+		hashed[hash_key('A', entry.call, "", "", period)].push_back(ix);
+		longest = std::max(longest, entry.time_off - entry.time_on);
+	}
+	return pairs;
+}
+
+// Duplicate check std::thread - only reads the copies of the QSOs
+void book::thread_dupes(book* that) {
+	if (DEBUG_THREADS) printf("BOOK THREAD: Checking %zu records for duplicates\n", that->dupe_qsos_.size());
+	that->dupe_pairs_ = find_overlaps(that->dupe_qsos_);
+	if (DEBUG_THREADS) printf("BOOK THREAD: Calling std::thread callback - %zu pairs\n", that->dupe_pairs_.size());
+	Fl::awake(cb_dupes_found, (void*)that);
+}
+
+// Callback from the duplicate check std::thread
+void book::cb_dupes_found(void* v) {
+	if (DEBUG_THREADS) printf("BOOK MAIN: Entered duplicate check callback handler\n");
+	((book*)v)->dupes_found();
+}
+
+// Duplicate check std::thread has finished - called in the main std::thread
+void book::dupes_found() {
+	if (!th_dupes_) return;
+	th_dupes_->join();
+	delete th_dupes_;
+	th_dupes_ = nullptr;
+	dupe_qsos_.clear();
+	char message[256];
+	snprintf(message, sizeof(message), "LOG: %zu pairs of QSOs overlap with the same call, band and mode", dupe_pairs_.size());
+	status_->misc_status(ST_NOTE, message);
+	// Compare the pairs still in the book - they may have been changed or deleted since the copy
+	std::map<qso_id_t, qso_id_t> parents;
+	std::map<qso_id_t, match_result_t> weakest;
+	auto root = [&parents](qso_id_t id) {
+		while (parents[id] != id) {
+			parents[id] = parents[parents[id]];
+			id = parents[id];
 		}
+		return id;
+	};
+	std::vector<std::pair<qso_id_t, match_result_t> > matches;
+	for (auto& dupe_pair : dupe_pairs_) {
+		item_num_t item_1 = position(dupe_pair.first);
+		item_num_t item_2 = position(dupe_pair.second);
+		if (item_1 == (item_num_t)-1 || item_2 == (item_num_t)-1) continue;
+		match_result_t match = get_record(item_1, false)->match_records(get_record(item_2, false));
 		switch (match) {
-		case MT_NOMATCH:
-		case MT_SWL_NOMATCH:
-		case MT_SWL_MATCH:
-		case MT_2XSWL_MATCH:
-		case MT_UNLIKELY:    // Time out by > 30mins: treat as no match for dupe check
-		case MT_OVERLAP:     // Still in the net at the end of the file
-			// Do nothing
-			break;
 		case MT_EXACT:
 		case MT_PROBABLE:
-			// Delete second occurence after query
-			match_question_ = "These appear to be duplicates - select one to delete";
-			selection(test_item_, HT_DUPE_QUERY, nullptr, dupe_item_);
-			possible_dupe = true;
-			break;
 		case MT_POSSIBLE:
 		case MT_LOC_MISMATCH:
-			// Open QSO query 
-			match_question_ = "Possible duplicate record found";
-			selection(test_item_, HT_DUPE_QUERY, nullptr, dupe_item_);
-			possible_dupe = true;
+			// Join the groups the two QSOs are in
+			if (parents.find(dupe_pair.first) == parents.end()) parents[dupe_pair.first] = dupe_pair.first;
+			if (parents.find(dupe_pair.second) == parents.end()) parents[dupe_pair.second] = dupe_pair.second;
+			parents[root(dupe_pair.second)] = root(dupe_pair.first);
+			matches.push_back({ dupe_pair.first, match });
+			break;
+		default:
+			// Overlap, SWL or no match - do nothing
 			break;
 		}
-		if (!possible_dupe) test_item_++;
-		status_->progress(test_item_, book_type());
 	}
-	if (!possible_dupe) {
-		char message[256];
-		snprintf(message, 256, "LOG: Dupe check complete. %zu checked, %d kept, %d removed", test_item_, number_dupes_kept_, number_dupes_removed_);
-		status_->misc_status(ST_OK, message);
-		if (number_dupes_removed_ > 0) {
-			// Progress will not be complete 
-			status_->progress("Check found duplicates", book_type());
+	dupe_pairs_.clear();
+	// Keep the weakest match in each group: exact, then probable, then any other
+	for (auto& match : matches) {
+		qso_id_t group = root(match.first);
+		auto it = weakest.find(group);
+		if (it == weakest.end() || it->second == MT_EXACT || (it->second == MT_PROBABLE && match.second != MT_EXACT)) {
+			weakest[group] = match.second;
 		}
-		inhibit_view_update_ = false;
-		selection(size() - 1, HT_ALL);
-		enable_save(true, "Checked dupes");
 	}
-}
-
-// Handle duplicate action - KEEP_LOG or KEEP_DUPE - delete it
-void book::reject_dupe(bool use_dupe) {
-	if (use_dupe) {
-		selection(dupe_item_, HT_DUPE_DELETED);
+	// Collect the QSOs in each group in book order
+	std::map<qso_id_t, std::vector<std::pair<item_num_t, qso_id_t> > > members;
+	for (auto& parent : parents) {
+		members[root(parent.first)].push_back({ position(parent.first), parent.first });
+	}
+	std::vector<std::vector<std::pair<item_num_t, qso_id_t> > > ordered;
+	for (auto& member : members) {
+		std::sort(member.second.begin(), member.second.end());
+		ordered.push_back(member.second);
+	}
+	std::sort(ordered.begin(), ordered.end());
+	std::vector<dupe_group_t> groups;
+	for (auto& qsos : ordered) {
+		dupe_group_t group;
+		for (auto& qso : qsos) group.qsos.push_back(qso.second);
+		record* first = get_record(qsos.front().first, false);
+		group.description = first->item("QSO_DATE", true) + '\t' + first->item("TIME_ON", true) + '\t' +
+			first->item("CALL") + '\t' + first->item("BAND") + '\t' + first->item("MODE");
+		// Merging is safe for close matches - leave the user to decide the others
+		switch (weakest[root(qsos.front().second)]) {
+		case MT_EXACT:
+			group.match = "Exact";
+			group.action = DA_MERGE;
+			break;
+		case MT_PROBABLE:
+			group.match = "Probable";
+			group.action = DA_MERGE;
+			break;
+		case MT_LOC_MISMATCH:
+			group.match = "Location differs";
+			group.action = DA_KEEP;
+			break;
+		default:
+			group.match = "Possible";
+			group.action = DA_KEEP;
+			break;
+		}
+		groups.push_back(group);
 	}
-	else {
-		selection(test_item_, HT_DUPE_DELETED);
+	if (groups.empty()) {
+		status_->misc_status(ST_OK, "LOG: Dupe check complete. No duplicates found");
+		return;
 	}
-	char message[128];
-	snprintf(message, 128, "LOG: Duplicate record %s deleted", get_record()->item("CALL").c_str());
+	snprintf(message, sizeof(message), "LOG: %zu groups of possible duplicates found", groups.size());
 	status_->misc_status(ST_WARNING, message);
-	delete_record(true);
-	number_dupes_removed_++;
-}
-
-// Handle duplicate action - MERGE_DUPE - merge and delete it
-void book::merge_dupe() {
-	get_record(test_item_, false)->merge_records(get_record(dupe_item_, false));
-	selection(dupe_item_, HT_DUPE_DELETED);
-	char message[128];
-	snprintf(message, 128, "LOG: Duplicate record %s merged & deleted", get_record()->item("CALL").c_str());
-	status_->misc_status(ST_WARNING, message);
-	delete_record(true);
-	number_dupes_removed_++;
+	enable_save(false, "Checking dupes");
+	dupe_dialog* dialog = new dupe_dialog(groups);
+	if (dialog->display() == BN_OK) {
+		resolve_dupes(groups);
+	}
+	else {
+		status_->misc_status(ST_NOTE, "LOG: Dupe check cancelled - no QSOs changed");
+	}
+	Fl::delete_widget(dialog);
+	enable_save(true, "Checked dupes");
 }
 
-// Handle duplicate action - KEEP_BOTH - ignore and restart check
-void book::accept_dupe() {
-	char message[128];
-	snprintf(message, 128, "LOG: Checked record %s & %s are not duplicates", 
-		get_record(test_item_, false)->item("CALL").c_str(),
-		get_record(dupe_item_, false)->item("CALL").c_str());
-	status_->misc_status(ST_WARNING, message);
-	number_dupes_kept_++;
-	test_item_++;
+// Apply the actions chosen for the groups of possible duplicates
+void book::resolve_dupes(const std::vector<dupe_group_t>& groups) {
+	int number_kept = 0;
+	int number_removed = 0;
+	for (auto& group : groups) {
+		item_num_t item_num = position(group.qsos.front());
+		if (group.action == DA_KEEP || item_num == (item_num_t)-1) {
+			number_kept += (int)group.qsos.size();
+			continue;
+		}
+		record* keep = get_record(item_num, false);
+		for (size_t ix = 1; ix < group.qsos.size(); ix++) {
+			item_num_t other = position(group.qsos[ix]);
+			if (other == (item_num_t)-1) continue;
+			if (group.action == DA_MERGE) {
+				keep->merge_records(get_record(other, false));
+			}
+			remove_dupe(other);
+			number_removed++;
+		}
+		number_kept++;
+	}
+	// If current record no longer exists select the last one
+	if (current_item_ >= size() && size() > 0) {
+		current_item_ = size() - 1;
+	}
+	char message[256];
+	snprintf(message, sizeof(message), "LOG: Dupe check complete. %zu groups checked, %d QSOs kept, %d removed", groups.size(), number_kept, number_removed);
+	status_->misc_status(number_removed ? ST_WARNING : ST_OK, message);
+	// Tell the views once that the book has changed
+	selection(current_item_, HT_ALL);
+}
+
+// Remove a duplicate QSO from this book - and from the main book if this is an extract
+void book::remove_dupe(item_num_t item_num) {
+	record* del_record = get_record(item_num, false);
+	char text[128];
+	snprintf(text, sizeof(text), "LOG: Duplicate record %s %s %s deleted",
+		del_record->item("QSO_DATE").c_str(),
+		del_record->item("TIME_ON").c_str(),
+		del_record->item("CALL").c_str());
+	status_->misc_status(ST_LOG, text);
+	delete_dirty_record(del_record);
+	if (book_type_ == OT_EXTRACT) {
+		qso_num_t record_num = record_number(item_num);
+		book_->delete_dirty_record(del_record);
+		book_->journal_remove(del_record);
+		book_->call_changes_.erase(del_record);
+		book_->erase(book_->begin() + record_num);
+		book_->deleted_record_ = true;
+		if (book_->save_running_) book_->deleted_during_save_ = true;
+	}
+	journal_remove(del_record);
+	call_changes_.erase(del_record);
+	erase(begin() + item_num);
+	deleted_record_ = true;
+	if (save_running_) deleted_during_save_ = true;
 }
 
 // Returns the reason record view has been activated - used by record view to prompt the user
@@ -1622,7 +2626,7 @@ bool book::loading() {
 
 // The book is being stored (on of the writers is active)
 bool book::storing() {
-	return (adi_writer_ != nullptr || (adx_handler_ && adx_handler_->storing()));
+	return (save_running_ || adi_writer_ != nullptr || (adx_handler_ && adx_handler_->storing()));
 }
 
 // Used to temporarily disable the upload of QSLs
@@ -1666,12 +2670,23 @@ void book::add_dirty_record(record* qso, std::string reason) {
 				qso->item("TIME_ON").c_str(),
 				qso->item("CALL").c_str(),
 				reason.c_str());
+		// Remember how the journal identifies the record before it is changed
+		if (journal_ && !main_loading_ && journal_keys_.find(qso) == journal_keys_.end()) {
+			journal_keys_[qso] = journal::key(qso);
+		}
+		// Remember its CALL so that the callsign index can be updated when it is next used
+		if (book_type_ == OT_MAIN && calls_indexed_ && std::this_thread::get_id() == main_thread_id_ &&
+			call_changes_.find(qso) == call_changes_.end()) {
+			call_changes_[qso] = qso->item(FI_CALL);
+		}
 		dirty_qsos_.insert(qso);
+		if (save_running_) dirty_during_save_.insert(qso);
 	}
 	else if (qso == header_) {
 		if (!main_loading_)
 			printf("%s Marking header dirty - %s", OBJECT_NAMES.at(book_type_), reason.c_str());
 		dirty_qsos_.insert(qso);
+		if (save_running_) dirty_during_save_.insert(qso);
 	}
 	if (!main_loading_) been_modified_ = true;
 }
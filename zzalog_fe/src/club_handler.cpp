@@ -205,7 +205,7 @@ bool club_handler::upload_single_qso(qso_num_t record_num) {
 		record* this_record = book_->get_record(record_num, false);
 		if (DEBUG_THREADS) printf("CLUBLOG MAIN: Queueing request %s\n", this_record->item("CALL").c_str());
 		upload_lock_.lock();
-		upload_queue_.push(this_record);
+		upload_queue_.push(this_record->snapshot());
 		upload_done_queue_.push(this_record);
 		upload_lock_.unlock();
 	}
@@ -290,11 +290,11 @@ void club_handler::thread_run(club_handler* that) {
 		// Process it
 		that->upload_lock_.lock();
 		if (!that->upload_queue_.empty()) {
-			record* qso = that->upload_queue_.front();
+			std::unique_ptr<record> qso = std::move(that->upload_queue_.front());
 			that->upload_queue_.pop();
 			if (DEBUG_THREADS) printf("CLUBLOG THREAD: Received request %s\n", qso->item("CALL").c_str());
 			that->upload_lock_.unlock();
-			that->th_upload(qso);
+			that->th_upload(qso.get());
 		}
 		else {
 			that->upload_lock_.unlock();
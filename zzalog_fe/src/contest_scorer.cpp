@@ -427,7 +427,6 @@ void contest_scorer::add_qso(record* qso, qso_num_t qso_number) {
 	}
 	if (qsos_) {
 		qsos_->push_back(qso);
-		qsos_->map_record(qso_number);
 		score_qso(qso, false);
 	}
 	if (algorithm_->uses_serno()) next_serial_++;
@@ -448,20 +447,20 @@ void contest_scorer::check_qso(record* qso, qso_num_t qso_number) {
 
 // Load QSOs - after restarting zzalog
 void contest_scorer::resume_contest() {
-	int ix = book_->size() - 1;
 	std::chrono::system_clock::time_point start = contest_->date.start;
 	std::chrono::system_clock::time_point finish = contest_->date.finish;
-	record* qso = book_->get_record(ix, false);
-	std::chrono::system_clock::time_point ts = qso->ctimestamp();
+	// Only the QSOs within the timeframe - latest first
+	std::pair<item_num_t, item_num_t> window = book_->time_range(
+		std::chrono::system_clock::to_time_t(start), std::chrono::system_clock::to_time_t(finish));
 	qsos_ = new extract_data();
-	while (ts > start) {
+	for (item_num_t ix = window.second; ix > window.first; ) {
+		ix--;
+		record* qso = book_->get_record(ix, false);
+		std::chrono::system_clock::time_point ts = qso->ctimestamp();
 		// Add all QSOs it this contest (ID equivalent and timestamp within timeframe
 		if (qso->item("CONTEST_ID") == contest_id_ && start < ts && finish > ts) {
 			add_qso(qso, ix);
 		}
-		ix--;
-		qso = book_->get_record(ix, false);
-		ts = qso->ctimestamp();
 	}
 }
 
@@ -0,0 +1,160 @@
+#include "dupe_dialog.h"
+
+#include "callback.h"
+#include "drawing.h"
+#include "utils.h"
+
+#include <FL/Fl.H>
+#include <FL/Fl_Widget.H>
+#include <FL/Fl_Window.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Check_Button.H>
+#include <FL/Fl_Hold_Browser.H>
+
+
+
+
+// Constructor - dialog constructor called with place holder size
+dupe_dialog::dupe_dialog(std::vector<dupe_group_t>& groups) :
+	win_dialog(10, 10, "Review possible duplicate QSOs")
+	, groups_(groups)
+	, all_groups_(false)
+	, br_groups_(nullptr)
+{
+	for (auto& group : groups_) {
+		actions_.push_back(group.action);
+	}
+
+	// Columns: date, time, call, band, mode, number of QSOs, match and action
+	static const int COLUMNS[] = { WBUTTON + GAP, WBUTTON, WBUTTON + GAP, WBUTTON, WBUTTON, WBUTTON, WSMEDIT, WBUTTON, 0 };
+	const int WBROWSER = 7 * WBUTTON + 2 * GAP + WSMEDIT + WBUTTON;
+	const int HBROWSER = 10 * HTEXT;
+	const int WDLG = EDGE + WBROWSER + EDGE;
+	const int XCANCEL = WDLG - EDGE - WBUTTON;
+	const int XOK = XCANCEL - GAP - WBUTTON;
+	const int ROW1 = EDGE + HTEXT;
+	const int ROW2 = ROW1 + HBROWSER + GAP;
+	const int ROW3 = ROW2 + HBUTTON + GAP;
+	const int HDLG = ROW3 + HBUTTON + EDGE;
+
+	// Resize the window to fit all buttons
+	size(WDLG, HDLG);
+
+	// Browser - a line for each group
+	br_groups_ = new Fl_Hold_Browser(EDGE, ROW1, WBROWSER, HBROWSER, "Groups of QSOs that may be duplicates");
+	br_groups_->align(FL_ALIGN_TOP | FL_ALIGN_LEFT);
+	br_groups_->column_widths(COLUMNS);
+	br_groups_->tooltip("Select a group to choose what to do with it");
+	// Action buttons
+	int curr_x = EDGE;
+	Fl_Button* bn_keep = new Fl_Button(curr_x, ROW2, WBUTTON, HBUTTON, "Keep");
+	bn_keep->callback(cb_bn_action, (void*)(intptr_t)DA_KEEP);
+	bn_keep->when(FL_WHEN_RELEASE);
+	bn_keep->tooltip("Keep all the QSOs in the group - they are not duplicates");
+	curr_x += WBUTTON + GAP;
+	Fl_Button* bn_merge = new Fl_Button(curr_x, ROW2, WBUTTON, HBUTTON, "Merge");
+	bn_merge->callback(cb_bn_action, (void*)(intptr_t)DA_MERGE);
+	bn_merge->when(FL_WHEN_RELEASE);
+	bn_merge->tooltip("Merge the other QSOs in the group into the first and delete them");
+	curr_x += WBUTTON + GAP;
+	Fl_Button* bn_delete = new Fl_Button(curr_x, ROW2, WBUTTON, HBUTTON, "Delete");
+	bn_delete->callback(cb_bn_action, (void*)(intptr_t)DA_DELETE);
+	bn_delete->when(FL_WHEN_RELEASE);
+	bn_delete->tooltip("Keep the first QSO in the group and delete the others");
+	curr_x += WBUTTON + GAP;
+	// Apply the action to every group
+	Fl_Check_Button* ck_all = new Fl_Check_Button(curr_x, ROW2, WLLABEL, HBUTTON, "All groups");
+	ck_all->align(FL_ALIGN_RIGHT | FL_ALIGN_INSIDE);
+	ck_all->callback(cb_value<Fl_Check_Button, bool>, (void*)&all_groups_);
+	ck_all->when(FL_WHEN_CHANGED);
+	ck_all->value(all_groups_);
+	ck_all->tooltip("Keep, merge or delete every group rather than the selected one");
+	// OK Button
+	Fl_Button* bn_ok = new Fl_Button(XOK, ROW3, WBUTTON, HBUTTON, "Apply");
+	bn_ok->callback(cb_bn_ok);
+	bn_ok->when(FL_WHEN_RELEASE);
+	bn_ok->tooltip("Keep, merge or delete the QSOs as shown");
+	// Cancel button
+	Fl_Button* bn_cancel = new Fl_Button(XCANCEL, ROW3, WBUTTON, HBUTTON, "Cancel");
+	bn_cancel->callback(cb_bn_cancel);
+	bn_cancel->when(FL_WHEN_RELEASE);
+	bn_cancel->tooltip("Leave all the QSOs unchanged");
+
+	end();
+	populate();
+	// Do not show yet
+
+	callback(cb_bn_cancel);
+}
+
+// Destructor
+dupe_dialog::~dupe_dialog()
+{
+	clear();
+}
+
+// call backs
+
+// Apply button - copy the actions chosen to the groups
+void dupe_dialog::cb_bn_ok(Fl_Widget* w, void* v) {
+	dupe_dialog* that = ancestor_view<dupe_dialog>(w);
+	for (size_t ix = 0; ix < that->groups_.size(); ix++) {
+		that->groups_[ix].action = that->actions_[ix];
+	}
+	that->do_button(BN_OK);
+}
+
+// Cancel button - do nothing except report cancel
+void dupe_dialog::cb_bn_cancel(Fl_Widget* w, void* v) {
+	dupe_dialog* that = ancestor_view<dupe_dialog>(w);
+	that->do_button(BN_CANCEL);
+}
+
+// Keep, Merge or Delete button - v has the action
+void dupe_dialog::cb_bn_action(Fl_Widget* w, void* v) {
+	dupe_dialog* that = ancestor_view<dupe_dialog>(w);
+	dupe_action_t action = (dupe_action_t)(intptr_t)v;
+	if (that->all_groups_) {
+		for (auto& group_action : that->actions_) {
+			group_action = action;
+		}
+		that->populate();
+	}
+	else {
+		// Line 1 is the heading
+		int line_num = that->br_groups_->value();
+		if (line_num > 1) {
+			that->actions_[line_num - 2] = action;
+			that->br_groups_->text(line_num, that->line(line_num - 2).c_str());
+		}
+	}
+}
+
+// Fill the browser with the groups - keeping the selection
+void dupe_dialog::populate() {
+	int line_num = br_groups_->value();
+	br_groups_->clear();
+	br_groups_->add("@bDate\t@bTime\t@bCall\t@bBand\t@bMode\t@bQSOs\t@bMatch\t@bAction");
+	for (size_t ix = 0; ix < groups_.size(); ix++) {
+		br_groups_->add(line(ix).c_str());
+	}
+	if (line_num > 1) br_groups_->value(line_num);
+	br_groups_->redraw();
+}
+
+// Returns the browser text for the group
+std::string dupe_dialog::line(size_t ix) {
+	std::string text = groups_[ix].description + '\t' + std::to_string(groups_[ix].qsos.size()) + '\t' + groups_[ix].match + '\t';
+	switch (actions_[ix]) {
+	case DA_KEEP:
+		text += "Keep all";
+		break;
+	case DA_MERGE:
+		text += "@C1Merge";
+		break;
+	case DA_DELETE:
+		text += "@C1Delete";
+		break;
+	}
+	return text;
+}
@@ -71,12 +71,12 @@ eqsl_handler::~eqsl_handler()
 */
 
 // Put the image request on to the std::queue 
-void eqsl_handler::enqueue_request(qso_num_t record_num, bool force /*=false*/) {
+void eqsl_handler::enqueue_request(qso_id_t qso_id, bool force /*=false*/) {
 	// eQSL requests can be disabled when compiled with _DEBUG
 	// Inhibit saving log
 	book_->enable_save(false, "Enqueuing eQSL image request");
 	// Enqueue request
-	request_queue_.push(request_t(record_num, force));
+	request_queue_.push(request_t(qso_id, force));
 	// Update status
 	char message[512];
 	sprintf(message, "EQSL: %zu Card requests pending", request_queue_.size());
@@ -120,12 +120,17 @@ void eqsl_handler::progress_download() {
 // Reomve a request from the std::queue
 void eqsl_handler::dequeue_request() {
 	char message[512];
+	// Drop the requests for QSOs deleted since they were queued
+	while (!request_queue_.empty() && book_->position(request_queue_.front().qso_id) == -1) {
+		request_queue_.pop();
+		book_->enable_save(true, "Dropped eQSL image request");
+	}
 	// Do not send any requests if we have reached the limit in a session
 	if (!request_queue_.empty() && empty_queue_enable_) {
 		// send the next eQSL request in the std::queue - but leave it in the std::queue until we've seen the response
 		request_t request = request_queue_.front();
 		// Let user know what we are doing
-		sprintf(message, "EQSL: Downloading card %s", book_->get_record(request.record_num, false)->item("CALL").c_str());
+		sprintf(message, "EQSL: Downloading card %s", book_->get_record(book_->position(request.qso_id), false)->item("CALL").c_str());
 		status_->misc_status(ST_NOTE, message);
 		// Request the eQSL card
 		response_t response = request_eqsl(request);
@@ -149,7 +154,7 @@ void eqsl_handler::dequeue_request() {
 			case 2:
 				// Request failed and repeat not wanted - remove request from std::queue
 				if (fl_choice("Do you want to remove eQSL received flag?", fl_yes, fl_no, nullptr) == 0) {
-					record* qso = book_->get_record(request.record_num, false);
+					record* qso = book_->get_record(book_->position(request.qso_id), false);
 					qso->item("EQSL_QSL_RCVD", std::string(""));
 					qso->item("EQSL_QSLRDATE", std::string(""));
 				}
@@ -204,9 +209,12 @@ void eqsl_handler::dequeue_request() {
 			// Let user know
 			request = request_queue_.front();
 			// Now peek the std::queue and select the front request so user sees the QSO being requested
-			book_->selection(request.record_num);
-			sprintf(message, "EQSL: %zu card requests pending - next request %s", request_queue_.size(), book_->get_record()->item("CALL").c_str());
-			status_->misc_status(ST_NOTE, message);
+			item_num_t record_num = book_->position(request.qso_id);
+			if (record_num != -1) {
+				book_->selection(record_num);
+				sprintf(message, "EQSL: %zu card requests pending - next request %s", request_queue_.size(), book_->get_record()->item("CALL").c_str());
+				status_->misc_status(ST_NOTE, message);
+			}
 
 			switch (response) {
 			case ER_SKIPPED:
@@ -234,8 +242,8 @@ void eqsl_handler::dequeue_request() {
 
 // Make the eQSL card image request
 eqsl_handler::response_t eqsl_handler::request_eqsl(request_t request) {
-	// Get the record
-	record* record = book_->get_record(request.record_num, false);
+	// Get the record - it is still in the log as dequeue_request() dropped any deleted
+	record* record = book_->get_record(book_->position(request.qso_id), false);
 	// get where to store the card locally
 	std::string local_filename = card_filename_l(record);
 	if (card_file_valid(local_filename) && !request.force) {
@@ -1005,7 +1013,7 @@ bool eqsl_handler::upload_single_qso(qso_num_t record_num) {
 			// Now send to upload std::thread to process
 			upload_lock_.lock();
 			if (DEBUG_THREADS) printf("EQSL MAIN: Enqueueing eQSL request %s\n", this_record->item("CALL").c_str());
-			upload_queue_.push(this_record);
+			upload_queue_.emplace(this_record, this_record->snapshot());
 			upload_lock_.unlock();
 		}
 	}
@@ -1013,7 +1021,7 @@ bool eqsl_handler::upload_single_qso(qso_num_t record_num) {
 }
 
 // Upload the QSO. This is running in a separate std::thread
-bool eqsl_handler::th_upload_qso(record* this_record) {
+bool eqsl_handler::th_upload_qso(record* qso, record* this_record) {
 	if (DEBUG_THREADS) printf("EQSL THREAD: Uploading eQSL %s\n", this_record->item("CALL").c_str());
 	// Generate URL parameters for QSL
 	char qsl_data[2048];
@@ -1032,7 +1040,7 @@ bool eqsl_handler::th_upload_qso(record* this_record) {
 	upload_response_t* response = new upload_response_t;
 	response->status = ER_OK;
 	response->error_message = "";
-	response->qso = this_record;
+	response->qso = qso;
 	if (!user_details(&username, &password, nullptr, nullptr, nullptr, nullptr)) {
 		char* message = new char[50 + username.length() + password.length()];
 		sprintf(message, "EQSL: User or password is missing: U=%s, P=%s", username.c_str(), password.c_str());
@@ -1219,11 +1227,11 @@ void eqsl_handler::thread_run(eqsl_handler* that) {
 		// Process it
 		that->upload_lock_.lock();
 		if (!that->upload_queue_.empty()) {
-			record* qso = that->upload_queue_.front();
+			std::pair<record*, std::unique_ptr<record> > request = std::move(that->upload_queue_.front());
 			that->upload_queue_.pop();
-			if (DEBUG_THREADS) printf("EQSL THREAD: Received request %s\n", qso->item("CALL").c_str());
+			if (DEBUG_THREADS) printf("EQSL THREAD: Received request %s\n", request.second->item("CALL").c_str());
 			that->upload_lock_.unlock();
-			that->th_upload_qso(qso);
+			that->th_upload_qso(request.first, request.second.get());
 		}
 		else {
 			that->upload_lock_.unlock();
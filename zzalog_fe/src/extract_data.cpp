@@ -26,8 +26,6 @@ extract_data::extract_data() :
 {
 	// This book contains extract data
 	extract_criteria_.clear();
-	mapping_.clear();
-	rev_mapping_.clear();
 }
 
 // Destructor
@@ -71,14 +69,14 @@ int extract_data::criteria(search_criteria_t criteria, extract_data::extract_mod
 void extract_data::extract_records() {
 	item_num_t count = 0;
 	char message[100];
+	// The QSOs that can match when searching by callsign
+	std::vector<item_num_t> found;
 	status_->misc_status(ST_NOTE, "EXTRACT: Started");
 	status_->misc_status(ST_NOTE, short_comment().c_str());
 	switch (criteria_->combi_mode) {
 	case XM_NEW:
 		// new results - remove existing results
 		this->clear();
-		mapping_.clear();
-		rev_mapping_.clear();
 		// copy header across and append reason for search
 		if (book_->header()) {
 			header_ = new record(*book_->header());
@@ -88,6 +86,18 @@ void extract_data::extract_records() {
 			header_ = new record;
 			header_->header(comment());
 		}
+		if (book_->call_candidates(criteria_, found)) {
+			// Only look at the QSOs with a matching call - using the log's callsign index
+			for (auto ixb : found) {
+				record* ext_record = book_->get_record(ixb, false);
+				if (match_record(ext_record)) {
+					push_back(ext_record);
+					count += 1;
+				}
+			}
+			snprintf(message, 100, "EXTRACT: %zu records extracted, %zu total", count, size());
+			break;
+		}
 		status_->progress(book_->get_count(), OT_EXTRACT, "Extracting New", "records");
 		// For all records in main log book
 		for (item_num_t ixb = 0; ixb < book_->get_count(); ixb++) {
@@ -96,10 +106,6 @@ void extract_data::extract_records() {
 			if (match_record(ext_record)) {
 				// It matches, copy reference to this book
 				push_back(ext_record);
-				int ixe = size() - 1;
-				// Add to both ways mappings
-				mapping_.insert(mapping_.begin() + ixe, ixb);
-				rev_mapping_[ixb] = ixe;
 				count += 1;
 			}
 			status_->progress(ixb + 1, OT_EXTRACT);
@@ -118,14 +124,9 @@ void extract_data::extract_records() {
 			if (!match_record(get_record(ixe, false))) {
 				// If it doesn't match, remove the record pointer from this book
 				erase(begin() + ixe);
-				int ixb = mapping_[ixe];
-				mapping_.erase(mapping_.begin() + ixe);
-				rev_mapping_.erase(ixb);
 				count += 1;
 			}
 			else {
-				// Remap reverse mapping to the new index in this book.
-				rev_mapping_[mapping_[ixe]] = ixe;
 				ixe++;
 			}
 			status_->progress(++ixb, OT_EXTRACT);
@@ -149,8 +150,6 @@ void extract_data::extract_records() {
 				if (get_record(ixe, false) != book_->get_record(ixb, false)) {
 					// Add the record to this book
 					insert_record_at(ixe, test_record);
-					mapping_.insert(mapping_.begin() + ixe, ixb);
-					rev_mapping_[ixb] = ixe;
 					count += 1;
 				}
 			}
@@ -189,9 +188,6 @@ void extract_data::clear_criteria(bool redraw) {
 	clear();
 	// Clear all the sets of criteria
 	extract_criteria_.clear();
-	// Clear the mappings
-	mapping_.clear();
-	rev_mapping_.clear();
 	// now tidy up this book, records have already been removed so will not be deleted
 	delete_contents(true);
 	use_mode_ = NONE;
@@ -206,9 +202,9 @@ void extract_data::clear_criteria(bool redraw) {
 
 // Convert item index in this book to the record index in the main log book
 inline qso_num_t extract_data::record_number(item_num_t item_number) {
-	if (size() > 0) 
-		// Return the mapping from this book to the main book
-		return mapping_[item_number];
+	if (item_number < size()) 
+		// Find the same QSO in the main book
+		return book_->position(at(item_number)->id());
 	else return -1;
 }
 
@@ -227,18 +223,19 @@ inline item_num_t extract_data::item_number(qso_num_t record_number, bool neares
 		}
 	}
 	else {
-		// Try and find the mapping
-		auto it = rev_mapping_.find(record_number);
-		if (nearest && it == rev_mapping_.end()) {
+		// Try and find the same QSO in this book
+		record* qso = book_->get_record(record_number, false);
+		item_num_t item = qso ? position(qso->id()) : -1;
+		if (nearest && item == (item_num_t)-1) {
 			// Need to find nearest mapping
 			// Get the bounds of the search (initially first and last items)
 			item_num_t lbound = 0;
-			item_num_t ubound = mapping_.size() - 1;
-			if (mapping_[lbound] > record_number) {
+			item_num_t ubound = size() - 1;
+			if (this->record_number(lbound) > record_number) {
 				// Record is before first item - return the first item
 				return 0;
 			}
-			if (mapping_[ubound] < record_number) {
+			if (this->record_number(ubound) < record_number) {
 				// Record is above the last item - return the last item
 				return ubound;
 			}
@@ -249,7 +246,7 @@ inline item_num_t extract_data::item_number(qso_num_t record_number, bool neares
 			while (ubound - 1 != lbound) {
 				// Compare with the half-way point 
 				test = (lbound + ubound) / 2;
-				if (record_number > mapping_[test]) {
+				if (record_number > this->record_number(test)) {
 					// It's between half-way and upper-bound, move lower-bound to half-way
 					lbound = test;
 				}
@@ -259,7 +256,7 @@ inline item_num_t extract_data::item_number(qso_num_t record_number, bool neares
 				}
 			}
 			// Return the closer of the two - use the higher if they are equidisstant
-			if (mapping_[ubound] - record_number <= record_number - mapping_[lbound]) {
+			if (this->record_number(ubound) - record_number <= record_number - this->record_number(lbound)) {
 				return ubound;
 			}
 			else {
@@ -268,12 +265,7 @@ inline item_num_t extract_data::item_number(qso_num_t record_number, bool neares
 		}
 		else {
 			// Return the exact mapping if it exists of -1 if it doesn't
-			if (it != rev_mapping_.end()) {
-				return it->second;
-			}
-			else {
-				return -1;
-			}
+			return item;
 		}
 	}
 }
@@ -686,14 +678,9 @@ void extract_data::extract_no_image() {
 			if (eqsl_handler_->card_file_valid(filename)) {
 				// If it exists, remove the record pointer from this book
 				erase(begin() + ixe);
-				int ixb = mapping_[ixe];
-				mapping_.erase(mapping_.begin() + ixe);
-				rev_mapping_.erase(ixb);
 				count += 1;
 			}
 			else {
-				// Remap reverse mapping to the new index in this book.
-				rev_mapping_[mapping_[ixe]] = ixe;
 				ixe++;
 			}
 			checked++;
@@ -938,8 +925,6 @@ void extract_data::add_record(qso_num_t record_num) {
 	record* record = book_->get_record(record_num, false);
 	item_num_t insert_point = get_insert_point(record);
 	insert_record_at(insert_point, record);
-	mapping_.insert(mapping_.begin() + insert_point, record_num);
-	rev_mapping_[record_num] = insert_point;
 	add_use_data(record);
 	qso_manager_->enable_widgets();
 }
@@ -1007,9 +992,6 @@ void extract_data::sort_records(std::string field_name, bool reversed) {
 	// Now unravel the tree
 	status_->progress(size(), book_type(), "Picking log", "Records");
 	clear();
-	// Clear the mappings
-	mapping_.clear();
-	rev_mapping_.clear();
 	// now tidy up this book, records have already been removed so will not be deleted
 	delete_contents(true);
 
@@ -1032,8 +1014,6 @@ int extract_data::pick_node(sort_node* n) {
 	// We have none remaining in the left, so this node is next
 	item_num_t item = size();
 	push_back(book_->at(n->qso_num));
-	mapping_.push_back(n->qso_num);
-	rev_mapping_[n->qso_num] = item;
 	result++;
 	status_->progress(item + 1, book_type());
 	// Add all the nodes on the right
@@ -1102,14 +1082,8 @@ void extract_data::use_mode(extract_data::extract_mode_t mode) {
 void extract_data::check_add_record(qso_num_t record_num) {
 	record* qso = book_->get_record(book_->item_number(record_num), false);
 	if (meets_criteria(qso)) {
-		if (record_num == book_->size() - 1) {
-		// It's the last in the book so we can simply add it
-			add_record(record_num);
-		}
-		else {
-		// Else we have to re-extract
-			reextract();
-		}
+		// The records are matched by identifier so it can be added wherever it is in the book
+		add_record(record_num);
 	} 
 }
 
@@ -1141,13 +1115,4 @@ bool extract_data::meets_criteria(record* qso) {
 		}
 	}
 	return match;
-}
-
-// Map records
-void extract_data::map_record(qso_num_t record_num) {
-	int ixe = size() - 1;
-	// Add to both ways mappings
-	mapping_.insert(mapping_.begin() + ixe, record_num);
-	rev_mapping_[record_num] = ixe;
-
 }
\ No newline at end of file
@@ -0,0 +1,342 @@
+#include "field_map.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// The fields with fixed identifiers - in the order of field_id_t
+static const std::vector<std::string> FIXED_FIELDS = {
+	"CALL", "QSO_DATE", "TIME_ON", "BAND", "FREQ", "MODE", "SUBMODE", "DXCC",
+	"STATION_CALLSIGN", "OPERATOR", "SWL", "QSO_COMPLETE", "GRIDSQUARE", "CQZ", "ITUZ", "CONT",
+	"MY_RIG", "MY_ANTENNA", "MY_NAME", "MY_STREET", "MY_CITY", "MY_POSTAL_CODE", "MY_GRIDSQUARE",
+	"MY_COUNTRY", "MY_DXCC", "MY_STATE", "MY_CNTY", "MY_CQ_ZONE", "MY_ITU_ZONE", "MY_IOTA",
+	"QSO_DATE_OFF", "TIME_OFF", "NAME", "QTH", "RST_SENT", "RST_RCVD", "QSL_RCVD", "QSL_SENT",
+	"EQSL_QSL_RCVD", "EQSL_QSL_SENT", "LOTW_QSL_RCVD", "LOTW_QSL_SENT"
+};
+
+// Fields known to have few different values - their values are pooled as are all enumerated fields
+static const std::set<std::string> LOW_CARDINALITY = {
+	"BAND", "MODE", "SUBMODE", "DXCC", "STATION_CALLSIGN", "OPERATOR", "SWL", "QSO_COMPLETE",
+	"CQZ", "ITUZ", "CONT", "MY_RIG", "MY_ANTENNA", "MY_NAME", "MY_STREET", "MY_CITY", "MY_POSTAL_CODE",
+	"MY_GRIDSQUARE", "MY_COUNTRY", "MY_DXCC", "MY_STATE", "MY_CNTY", "MY_CQ_ZONE", "MY_ITU_ZONE",
+	"MY_IOTA", "QSL_RCVD", "QSL_SENT", "EQSL_QSL_RCVD", "EQSL_QSL_SENT", "LOTW_QSL_RCVD", "LOTW_QSL_SENT"
+};
+
+// initialise the static variables
+std::atomic<const field_registry::table_t*> field_registry::current_(nullptr);
+std::mutex field_registry::mutex_;
+std::deque<std::string> field_registry::names_;
+std::vector<std::unique_ptr<field_registry::table_t> > field_registry::versions_;
+std::shared_mutex value_pool::mutex_;
+std::unordered_set<std::string> value_pool::values_;
+
+// Get the current tables - the first use creates them with the fixed fields
+const field_registry::table_t* field_registry::tables() {
+	const table_t* tables = current_.load(std::memory_order_acquire);
+	if (tables == nullptr) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		tables = current_.load(std::memory_order_acquire);
+		if (tables == nullptr) {
+			table_t* fixed = new table_t;
+			versions_.emplace_back(fixed);
+			for (auto& name : FIXED_FIELDS) {
+				fixed->ids[name] = (field_id_t)fixed->names.size();
+				names_.push_back(name);
+				fixed->names.push_back(&names_.back());
+				fixed->pooled.push_back(LOW_CARDINALITY.find(name) != LOW_CARDINALITY.end());
+			}
+			current_.store(fixed, std::memory_order_release);
+			tables = fixed;
+		}
+	}
+	return tables;
+}
+
+// Add the new names in a new copy of the tables
+const field_registry::table_t* field_registry::add_names(const std::vector<std::string>& names, bool pool /*= false*/) {
+	const table_t* current = current_.load(std::memory_order_acquire);
+	table_t* tables = nullptr;
+	for (auto& name : names) {
+		auto it = current->ids.find(name);
+		// Already known and pooled if needed
+		if (it != current->ids.end() && (!pool || current->pooled[it->second])) continue;
+		if (tables == nullptr) {
+			tables = new table_t(*current);
+			versions_.emplace_back(tables);
+		}
+		it = tables->ids.find(name);
+		if (it != tables->ids.end()) {
+			if (pool) tables->pooled[it->second] = true;
+			continue;
+		}
+		if (tables->names.size() >= FI_NONE) break;
+		tables->ids[name] = (field_id_t)tables->names.size();
+		names_.push_back(name);
+		tables->names.push_back(&names_.back());
+		tables->pooled.push_back(pool || LOW_CARDINALITY.find(name) != LOW_CARDINALITY.end());
+	}
+	if (tables == nullptr) return current;
+	current_.store(tables, std::memory_order_release);
+	return tables;
+}
+
+// Get the identifier of the field - adding it if it is new
+field_id_t field_registry::id(const std::string& name) {
+	const table_t* current = tables();
+	auto it = current->ids.find(name);
+	if (it != current->ids.end()) return it->second;
+	std::lock_guard<std::mutex> lock(mutex_);
+	current = add_names({ name });
+	it = current->ids.find(name);
+	return it == current->ids.end() ? FI_NONE : it->second;
+}
+
+// Get the identifier of the field if it is known
+field_id_t field_registry::find(const std::string& name) {
+	const table_t* current = tables();
+	auto it = current->ids.find(name);
+	return it == current->ids.end() ? FI_NONE : it->second;
+}
+
+// Get the name of the field
+const std::string& field_registry::name(field_id_t id) {
+	return *tables()->names[id];
+}
+
+// Get the number of fields
+size_t field_registry::count() {
+	return tables()->names.size();
+}
+
+// Add the fields
+void field_registry::add(const std::set<std::string>& names) {
+	tables();
+	std::lock_guard<std::mutex> lock(mutex_);
+	add_names(std::vector<std::string>(names.begin(), names.end()));
+}
+
+// The values of the field are pooled
+bool field_registry::pooled(field_id_t id) {
+	const table_t* current = tables();
+	return id < current->pooled.size() && current->pooled[id];
+}
+
+// Pool the values of the fields
+void field_registry::pool(const std::set<std::string>& names) {
+	tables();
+	std::lock_guard<std::mutex> lock(mutex_);
+	add_names(std::vector<std::string>(names.begin(), names.end()), true);
+}
+
+// Get the pooled copy of the value - adding it if it is new
+const std::string* value_pool::intern(const std::string& value) {
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex_);
+		auto it = values_.find(value);
+		if (it != values_.end()) return &(*it);
+	}
+	std::unique_lock<std::shared_mutex> lock(mutex_);
+	return &(*values_.insert(value).first);
+}
+
+// Get the pooled copy of the value if there is one
+const std::string* value_pool::find(const std::string& value) {
+	std::shared_lock<std::shared_mutex> lock(mutex_);
+	auto it = values_.find(value);
+	return it == values_.end() ? nullptr : &(*it);
+}
+
+// Create the item - pooling the value if the field is pooled
+field_item::field_item(field_id_t id, const std::string& value) :
+	first(id),
+	pooled_(false),
+	value_(nullptr)
+{
+	assign(value);
+}
+
+// Copy the item - a pooled value is shared
+field_item::field_item(const field_item& rhs) :
+	first(rhs.first),
+	pooled_(rhs.pooled_),
+	value_(rhs.pooled_ ? rhs.value_ : new std::string(*rhs.value_))
+{
+}
+
+// Move the item - taking over an owned value
+field_item::field_item(field_item&& rhs) noexcept :
+	first(rhs.first),
+	pooled_(rhs.pooled_),
+	value_(rhs.value_)
+{
+	rhs.value_ = nullptr;
+	rhs.pooled_ = true;
+}
+
+// Copy the item
+field_item& field_item::operator=(const field_item& rhs) {
+	if (this != &rhs) {
+		release();
+		first = rhs.first;
+		value_ = rhs.pooled_ ? rhs.value_ : new std::string(*rhs.value_);
+		pooled_ = rhs.pooled_;
+	}
+	return *this;
+}
+
+// Move the item
+field_item& field_item::operator=(field_item&& rhs) noexcept {
+	if (this != &rhs) {
+		release();
+		first = rhs.first;
+		value_ = rhs.value_;
+		pooled_ = rhs.pooled_;
+		rhs.value_ = nullptr;
+		rhs.pooled_ = true;
+	}
+	return *this;
+}
+
+// Delete the item
+field_item::~field_item() {
+	release();
+}
+
+// Change the value
+void field_item::value(const std::string& value) {
+	if (!pooled_) {
+		// Reuse the owned string
+		*const_cast<std::string*>(value_) = value;
+	}
+	else {
+		assign(value);
+	}
+}
+
+// Point at the pooled value or a new owned copy
+void field_item::assign(const std::string& value) {
+	pooled_ = field_registry::pooled(first);
+	value_ = pooled_ ? value_pool::intern(value) : new std::string(value);
+}
+
+// Delete an owned value
+void field_item::release() {
+	if (!pooled_) delete value_;
+	value_ = nullptr;
+	pooled_ = true;
+}
+
+// Find the item for the field
+field_map::const_iterator field_map::find(field_id_t field) const {
+	const items_t& all = items();
+	for (auto it = all.begin(); it != all.end(); it++) {
+		if (it->first == field) return const_iterator(it);
+	}
+	return end();
+}
+
+// Get the value of the field - which must be present
+const std::string& field_map::at(const std::string& field) const {
+	auto it = find(field);
+	if (it == end()) throw std::out_of_range("field_map::at " + field);
+	return it->second;
+}
+
+// Set the value of the field - adding it if not present
+void field_map::set(field_id_t field, const std::string& value) {
+	items_t& all = writable();
+	for (auto it = all.begin(); it != all.end(); it++) {
+		if (it->first == field) {
+			it->value(value);
+			return;
+		}
+	}
+	all.emplace(insert_point(field), field, value);
+}
+
+// Compare the value of the field in the two maps
+bool field_map::same_value(field_id_t field, const field_map& other) const {
+	auto it = find(field);
+	auto it_other = other.find(field);
+	bool present = it != end() && !it->second.empty();
+	bool other_present = it_other != other.end() && !it_other->second.empty();
+	if (!present || !other_present) return present == other_present;
+	// Equal pooled values are the same copy
+	if (it.base()->pooled() && it_other.base()->pooled()) {
+		return it.base()->value_ptr() == it_other.base()->value_ptr();
+	}
+	return it->second == it_other->second;
+}
+
+// Compare the value of the pooled field with the pooled copy of a value
+bool field_map::value_is(field_id_t field, const std::string* value) const {
+	auto it = find(field);
+	if (value == nullptr || it == end()) return false;
+	// A value set before the field was pooled is owned
+	if (!it.base()->pooled()) return it->second == *value;
+	return it.base()->value_ptr() == value;
+}
+
+// Add the field if not present
+std::pair<field_map::iterator, bool> field_map::emplace(field_id_t field, const std::string& value) {
+	auto it = find(field);
+	if (it != end()) return { it, false };
+	writable();
+	return { iterator(items_->emplace(insert_point(field), field, value)), true };
+}
+
+// Add the field if not present - appending it if it follows the last field
+field_map::iterator field_map::emplace_hint(const_iterator hint, field_id_t field, const std::string& value) {
+	if (hint == end() && (empty() || field_registry::name(items().back().first) < field_registry::name(field))) {
+		items_t& all = writable();
+		all.emplace_back(field, value);
+		return iterator(all.end() - 1);
+	}
+	return emplace(field, value).first;
+}
+
+// Remove the field
+size_t field_map::erase(field_id_t field) {
+	auto it = find(field);
+	if (it == end()) return 0;
+	erase(it);
+	return 1;
+}
+
+// Remove the item - by position as the items may be copied first
+field_map::iterator field_map::erase(const_iterator pos) {
+	auto index = pos.base() - items().begin();
+	items_t& all = writable();
+	return iterator(all.erase(all.begin() + index));
+}
+
+// Get the items to change
+field_map::items_t& field_map::writable() {
+	if (!items_) {
+		items_ = std::make_shared<items_t>();
+	}
+	else if (items_.use_count() > 1) {
+		// A copy of the map is still reading them
+		items_ = std::make_shared<items_t>(*items_);
+	}
+	else {
+		// Another thread may have just released the last copy: its reads come before these writes
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+	return *items_;
+}
+
+// Where the field goes in field name order
+field_map::items_t::iterator field_map::insert_point(field_id_t field) {
+	const std::string& name = field_registry::name(field);
+	items_t& all = *items_;
+	// Usually the fields are added in order
+	if (all.empty() || field_registry::name(all.back().first) < name) return all.end();
+	return std::lower_bound(all.begin(), all.end(), name,
+		[](const item_t& item, const std::string& name) { return field_registry::name(item.first) < name; });
+}
+
+// There are no items
+const field_map::items_t& field_map::no_items() {
+	static const items_t none;
+	return none;
+}
@@ -0,0 +1,227 @@
+#include "gz_stream.h"
+
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "FL/images/zlib.h"
+#include <FL/fl_utf8.h>
+
+// Size of the buffer between the stream and zlib
+const size_t GZ_BUFFER_SIZE = 1 << 16;
+// Size of the buffers zlib uses for the compressed data
+const unsigned int GZ_FILE_BUFFER_SIZE = 1 << 18;
+
+// Constructor
+gz_streambuf::gz_streambuf()
+	: file_(nullptr)
+	, writing_(false)
+{
+}
+
+// Destructor
+gz_streambuf::~gz_streambuf() {
+	close();
+}
+
+// Open the file for reading or writing
+bool gz_streambuf::open(const std::string& filename, std::ios::openmode mode) {
+	close();
+	writing_ = !(mode & std::ios::in);
+	file_ = gzopen(filename.c_str(), writing_ ? "wb" : "rb");
+	if (file_ == nullptr) return false;
+	gzbuffer(file_, GZ_FILE_BUFFER_SIZE);
+	buffer_.resize(GZ_BUFFER_SIZE);
+	if (writing_) {
+		setp(buffer_.data(), buffer_.data() + buffer_.size());
+	}
+	else {
+		setg(buffer_.data(), buffer_.data(), buffer_.data());
+	}
+	return true;
+}
+
+// Close the file - write any remaining data first
+bool gz_streambuf::close() {
+	if (file_ == nullptr) return true;
+	bool ok = true;
+	if (writing_) {
+		ok = flush_buffer();
+	}
+	ok = (gzclose(file_) == Z_OK) && ok;
+	file_ = nullptr;
+	setg(nullptr, nullptr, nullptr);
+	setp(nullptr, nullptr);
+	return ok;
+}
+
+// The file is open
+bool gz_streambuf::is_open() {
+	return file_ != nullptr;
+}
+
+// Refill the read buffer
+gz_streambuf::int_type gz_streambuf::underflow() {
+	if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+	if (file_ == nullptr || writing_) return traits_type::eof();
+	int count = gzread(file_, buffer_.data(), (unsigned int)buffer_.size());
+	if (count <= 0) return traits_type::eof();
+	setg(buffer_.data(), buffer_.data(), buffer_.data() + count);
+	return traits_type::to_int_type(*gptr());
+}
+
+// Read into the caller's buffer - large reads bypass the stream buffer
+std::streamsize gz_streambuf::xsgetn(char* s, std::streamsize count) {
+	std::streamsize done = 0;
+	// First use what is already in the buffer
+	std::streamsize available = egptr() - gptr();
+	if (available > 0) {
+		done = std::min(available, count);
+		memcpy(s, gptr(), (size_t)done);
+		gbump((int)done);
+	}
+	if (file_ == nullptr || writing_) return done;
+	while (done < count) {
+		std::streamsize wanted = count - done;
+		if (wanted < (std::streamsize)buffer_.size()) {
+			// Small read - go through the buffer
+			if (underflow() == traits_type::eof()) break;
+			std::streamsize n = std::min<std::streamsize>(egptr() - gptr(), wanted);
+			memcpy(s + done, gptr(), (size_t)n);
+			gbump((int)n);
+			done += n;
+		}
+		else {
+			int n = gzread(file_, s + done, (unsigned int)std::min<std::streamsize>(wanted, 1 << 30));
+			if (n <= 0) break;
+			done += n;
+		}
+	}
+	return done;
+}
+
+// Write buffer is full - compress it and then add c
+gz_streambuf::int_type gz_streambuf::overflow(int_type c) {
+	if (file_ == nullptr || !writing_ || !flush_buffer()) return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+// Compress the buffered data
+int gz_streambuf::sync() {
+	if (file_ == nullptr || !writing_) return 0;
+	return flush_buffer() ? 0 : -1;
+}
+
+// Pass the buffered data to zlib
+bool gz_streambuf::flush_buffer() {
+	int count = (int)(pptr() - pbase());
+	if (count > 0 && gzwrite(file_, pbase(), (unsigned int)count) != count) {
+		return false;
+	}
+	setp(buffer_.data(), buffer_.data() + buffer_.size());
+	return true;
+}
+
+// The file is compressed
+bool gz_streambuf::is_compressed(const std::string& filename) {
+	return filename.length() > 3 && to_lower(filename.substr(filename.length() - 3)) == ".gz";
+}
+
+// Get the file type - ignoring any .gz
+std::string gz_streambuf::file_type(const std::string& filename) {
+	std::string name = filename;
+	if (is_compressed(name)) {
+		name = name.substr(0, name.length() - 3);
+	}
+	size_t last_period = name.find_last_of('.');
+	if (last_period == std::string::npos) {
+		return "";
+	}
+	return to_lower(name.substr(last_period));
+}
+
+// Write a compressed copy of the file
+bool gz_streambuf::compress_file(const std::string& from, const std::string& to) {
+	std::ifstream in(from.c_str(), std::ios::in | std::ios::binary);
+	if (!in.good()) return false;
+	gz_ofstream out(to);
+	std::vector<char> block(GZ_BUFFER_SIZE);
+	while (out.good() && in.read(block.data(), block.size()).gcount() > 0) {
+		out.write(block.data(), in.gcount());
+	}
+	bool ok = in.eof() && out.good();
+	out.close();
+	if (!ok || out.fail()) {
+		fl_unlink(to.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Constructor
+gz_ifstream::gz_ifstream()
+	: std::istream(nullptr)
+{
+	init(&buf_);
+}
+
+// Constructor - open the file
+gz_ifstream::gz_ifstream(const std::string& filename)
+	: std::istream(nullptr)
+{
+	init(&buf_);
+	open(filename);
+}
+
+// Open the file
+void gz_ifstream::open(const std::string& filename) {
+	if (buf_.open(filename, std::ios::in)) {
+		clear();
+	}
+	else {
+		setstate(std::ios::failbit);
+	}
+}
+
+// Close the file
+void gz_ifstream::close() {
+	buf_.close();
+}
+
+// Constructor
+gz_ofstream::gz_ofstream()
+	: std::ostream(nullptr)
+{
+	init(&buf_);
+}
+
+// Constructor - open the file
+gz_ofstream::gz_ofstream(const std::string& filename)
+	: std::ostream(nullptr)
+{
+	init(&buf_);
+	open(filename);
+}
+
+// Open the file
+void gz_ofstream::open(const std::string& filename) {
+	if (buf_.open(filename, std::ios::out)) {
+		clear();
+	}
+	else {
+		setstate(std::ios::failbit);
+	}
+}
+
+// Close the file
+void gz_ofstream::close() {
+	if (!buf_.close()) {
+		setstate(std::ios::failbit);
+	}
+}
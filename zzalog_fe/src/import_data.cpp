@@ -16,6 +16,7 @@
 
 #include "utils.h"
 
+#include <algorithm>
 #include <sstream>
 #include <ctime>
 #include <chrono>
@@ -52,6 +53,7 @@ import_data::import_data() :
 	match_question_ = "";
 	close_pending_ = false;
 	last_added_number_ = 0;
+	bulk_checked_ = false;
 }
 
 // Destructor
@@ -112,7 +114,7 @@ void import_data::save_update() {
 	}
 	// This may result in the card being fetched twice
 	if (update_mode_ == EQSL_UPDATE) {
-		eqsl_handler_->enqueue_request(record_number);
+		eqsl_handler_->enqueue_request(import_record->id());
 	}
 }
 
@@ -164,7 +166,7 @@ void import_data::update_book() {
 				qso_timestamp += "59";
 			}
 			// Some fields may require conversion (e.g. eQSL uses RST_SENT from contact's perspective
-			convert_update(import_record);
+			if (!bulk_checked_) convert_update(import_record);
 			bool found_match = false;
 			// Find the position of the record either equal in time or just after
 			item_num_t datum_pos = book_->get_insert_point(import_record);
@@ -179,23 +181,13 @@ void import_data::update_book() {
 			if (datum_pos < book_->size()) {
 				// Start looking for an exact match only from 2 before until no longer overlap
 
-				// Start N minutes before the time 
-				const std::chrono::seconds MINUTES_30(1800);
-				std::chrono::system_clock::time_point datum = import_record->ctimestamp();
-				item_num_t start_pos = datum_pos;
-				std::chrono::system_clock::time_point start = book_->get_record(start_pos, false)->ctimestamp();
-				while (datum - start < MINUTES_30 && start_pos > 0) {
-					start_pos--;
-					start = book_->get_record(start_pos, false)->ctimestamp();
-				}
-				item_num_t end_pos = datum_pos;
-				datum = import_record->ctimestamp(true);
-				std::chrono::system_clock::time_point end_pt = book_->get_record(end_pos, false)->ctimestamp(true);
-				while (end_pt - datum < MINUTES_30 && end_pos < book_->size() - 1) {
-					end_pos++;
-					end_pt = book_->get_record(end_pos, false)->ctimestamp();
-				}
-				for (item_num_t test_record = start_pos; test_record <= end_pos && !found_match; test_record++) {
+				// From 30 minutes before it starts to 30 minutes after it ends - and one QSO either side
+				const time_t MINUTES_30 = 1800;
+				std::pair<item_num_t, item_num_t> window = book_->time_range(
+					import_record->timestamp() - MINUTES_30, import_record->timestamp(true) + MINUTES_30);
+				item_num_t start_pos = window.first > 0 ? window.first - 1 : 0;
+				item_num_t end_pos = std::min(window.second + 1, book_->size());
+				for (item_num_t test_record = start_pos; test_record < end_pos && !found_match; test_record++) {
 					// If the test record is outwith the book skip the check
 					if (test_record < 0 || test_record >= book_->size()) continue;
 					// Get potential match QSO
@@ -222,7 +214,7 @@ void import_data::update_book() {
 						number_matched_++;
 						// For eQSL.cc request the eQSL e-card. These are queued not to overwhelm eQSL.cc
 						if (update_mode_ == EQSL_UPDATE) {
-							eqsl_handler_->enqueue_request(test_record);
+							eqsl_handler_->enqueue_request(test_qso->id());
 						}
 						// Accepted - discard this record
 						discard_update(false);
@@ -234,7 +226,7 @@ void import_data::update_book() {
 					}
 				}
 				// Now look for near misses.
-				for (item_num_t test_record = start_pos; test_record <= end_pos && !found_match; test_record++) {
+				for (item_num_t test_record = start_pos; test_record < end_pos && !found_match; test_record++) {
 					// If the test record is outwith the book skip the check
 					if (test_record < 0 || test_record >= book_->size()) continue;
 					// Get potential match QSO
@@ -280,7 +272,7 @@ void import_data::update_book() {
 						number_matched_++;
 						// Fetch e-card from eQSL.cc
 						if (update_mode_ == EQSL_UPDATE) {
-							eqsl_handler_->enqueue_request(test_record);
+							eqsl_handler_->enqueue_request(test_qso->id());
 						}
 						discard_update(false);
 						break;
@@ -464,10 +456,107 @@ void import_data::finish_update(bool merged /*= true*/) {
 	close_pending_ = false;
 	number_modified_ = 0;
 	update_mode_ = NONE;
+	bulk_checked_ = false;
 	// Restore state of save_enabled
 	book_->enable_save(true, "Finished update from import");
 }
 
+// Match the update records against the log in one pass - both in time order
+void import_data::bulk_update() {
+	char message[256];
+	match_flags_t match_flags = MR_NONE;
+	if (update_mode_ == LOTW_UPDATE) (uchar&)match_flags |= MR_ALLOW_LOC;
+	// Sort the update records by time, call and band
+	std::vector<record*> updates(begin(), end());
+	for (auto import_record : updates) {
+		convert_update(import_record);
+	}
+	std::stable_sort(updates.begin(), updates.end(), [](record* lhs, record* rhs) {
+		if (lhs->timestamp() != rhs->timestamp()) return lhs->timestamp() < rhs->timestamp();
+		if (lhs->item(FI_CALL) != rhs->item(FI_CALL)) return lhs->item(FI_CALL) < rhs->item(FI_CALL);
+		return lhs->item(FI_BAND) < rhs->item(FI_BAND);
+	});
+	// The records that update_book() needs to check
+	std::vector<record*> remaining;
+	int number_bulk = 0;
+	const time_t MINUTES_30 = 1800;
+	// The first QSO in the log that starts less than 30 minutes before the update record
+	item_num_t first_pos = 0;
+	for (auto import_record : updates) {
+		// Those after the end of the log are new
+		if (book_->get_insert_point(import_record) >= book_->size()) {
+			remaining.push_back(import_record);
+			continue;
+		}
+		// The same QSOs that update_book() looks at: from 30 minutes before the record starts 
+		// to 30 minutes after it ends - and one QSO either side
+		while (first_pos < book_->size() && book_->get_record(first_pos, false)->timestamp() < import_record->timestamp() - MINUTES_30) {
+			first_pos++;
+		}
+		item_num_t end_pos = first_pos;
+		while (end_pos < book_->size() && book_->get_record(end_pos, false)->timestamp() <= import_record->timestamp(true) + MINUTES_30) {
+			end_pos++;
+		}
+		item_num_t start_pos = first_pos > 0 ? first_pos - 1 : 0;
+		end_pos = std::min(end_pos + 1, book_->size());
+		// Look for an exact match
+		item_num_t match_pos = -1;
+		for (item_num_t test_record = start_pos; test_record < end_pos && match_pos == -1; test_record++) {
+			match_result_t match_result = import_record->match_records(book_->get_record(test_record, false));
+			if (match_result == MT_EXACT || match_result == MT_LOC_MISMATCH) {
+				match_pos = test_record;
+			}
+		}
+		// Otherwise accept a probable match if it is the first near miss - the rest need a query
+		bool decided = false;
+		for (item_num_t test_record = start_pos; test_record < end_pos && match_pos == -1 && !decided; test_record++) {
+			switch (import_record->match_records(book_->get_record(test_record, false))) {
+			case MT_PROBABLE:
+				match_pos = test_record;
+				break;
+			case MT_2XSWL_MATCH:
+			case MT_SWL_MATCH:
+			case MT_POSSIBLE:
+			case MT_UNLIKELY:
+				decided = true;
+				break;
+			default:
+				break;
+			}
+		}
+		if (match_pos == -1) {
+			remaining.push_back(import_record);
+			continue;
+		}
+		record* test_qso = book_->get_record(match_pos, false);
+		number_checked_++;
+		if (test_qso->merge_records(import_record, match_flags)) {
+			snprintf(message, 256, "IMPORT: Updated record. %s %s %s %s %s",
+				test_qso->item("QSO_DATE").c_str(), test_qso->item("TIME_ON").c_str(),
+				test_qso->item("CALL").c_str(),
+				test_qso->item("BAND").c_str(), test_qso->item("MODE").c_str());
+			status_->misc_status(ST_LOG, message);
+			number_modified_++;
+			if (test_qso->item("CLUBLOG_QSO_UPLOAD_STATUS") == "M") {
+				number_clublog_++;
+			}
+		}
+		number_matched_++;
+		number_bulk++;
+		// For eQSL.cc request the eQSL e-card. These are queued not to overwhelm eQSL.cc
+		if (update_mode_ == EQSL_UPDATE) {
+			eqsl_handler_->enqueue_request(test_qso->id());
+		}
+		delete import_record;
+	}
+	// Keep the rest in time order for update_book()
+	swap(remaining);
+	bulk_checked_ = true;
+	snprintf(message, sizeof(message), "IMPORT: %d records matched in one pass, %zu to check", number_bulk, size());
+	status_->misc_status(ST_NOTE, message);
+	status_->progress(number_to_import_ - size(), book_type());
+}
+
 // Where an update has come from a QSL server, some ADIF fields are renamed to the viewpoiint of this 
 // log not the server
 void import_data::convert_update(record* qso) {
@@ -710,6 +799,10 @@ void import_data::merge_data(import_data::update_mode_t mode) {
 	number_clublog_ = 0;
 	number_swl_ = 0;
 	last_added_number_ = 0;
+	// Downloads from QSL servers are mostly confirmations of QSOs in the log
+	if (!bulk_checked_ && (update_mode_ == EQSL_UPDATE || update_mode_ == LOTW_UPDATE || update_mode_ == QRZCOM_UPDATE)) {
+		bulk_update();
+	}
 	// Merge this book into main log book
 	update_book();
 	// If we have no user query - switch to main log view
@@ -0,0 +1,203 @@
+#include "journal.h"
+
+#include "adi_reader.h"
+#include "adi_writer.h"
+#include "gz_stream.h"
+#include "record.h"
+
+#include "utils.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <FL/fl_utf8.h>
+
+// Constructor
+journal::journal()
+	: filename_("")
+	, num_pending_(0)
+	, entries_(0)
+	, size_(0)
+{
+}
+
+// Destructor
+journal::~journal()
+{
+}
+
+// Set the journal for the log file
+void journal::log_filename(const std::string& log_filename) {
+	pending_.str("");
+	num_pending_ = 0;
+	entries_ = 0;
+	size_ = 0;
+	// Only .adi logs have a journal - the journal of a compressed log is not compressed
+	std::string filetype = gz_streambuf::file_type(log_filename);
+	if (filetype == ".adi" || filetype == ".adif") {
+		filename_ = log_filename + ".jnl";
+		std::ifstream in(filename_.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+		if (in.good()) size_ = in.tellg();
+	}
+	else {
+		filename_ = "";
+	}
+}
+
+// The log has a journal
+bool journal::active() {
+	return filename_.length() > 0;
+}
+
+// Add the contents of the record - key is as last saved or empty if it is new
+void journal::put(record* qso, const std::string& key) {
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_OP", "PUT");
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_KEY", key);
+	adi_writer::to_adif(qso, pending_, nullptr, false);
+	num_pending_++;
+}
+
+// Add the deletion of a record
+void journal::remove(const std::string& key) {
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_OP", "DEL");
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_KEY", key);
+	pending_ << "<EOR>" << std::endl << std::endl;
+	num_pending_++;
+}
+
+// Add a mark
+void journal::mark(const std::string& token) {
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_OP", "MARK");
+	pending_ << adi_writer::item_to_adif("APP_ZZA_JNL_MARK", token);
+	pending_ << "<EOR>" << std::endl << std::endl;
+}
+
+// Append the pending entries to the journal file and flush it to disk
+bool journal::flush() {
+	if (!active()) return false;
+	std::string data = pending_.str();
+	int num_entries = num_pending_;
+	pending_.str("");
+	num_pending_ = 0;
+	if (data.empty()) return true;
+	std::ofstream out(filename_.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+	out << data;
+	out.close();
+	if (out.fail() || !sync_file(filename_)) {
+		return false;
+	}
+	size_ += data.length();
+	entries_ += num_entries;
+	return true;
+}
+
+// Read the entries after the base mark
+void journal::read(const std::string& base_mark, std::vector<record*>& entries) {
+	entries.clear();
+	entries_ = 0;
+	if (!active()) return;
+	std::ifstream in(filename_.c_str(), std::ios::in | std::ios::binary);
+	if (!in.good()) return;
+	std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+	size_ = buffer.length();
+	adi_reader reader;
+	const char* start = buffer.data();
+	const char* pos = start;
+	const char* end = start + buffer.length();
+	// Position after the last complete entry
+	const char* good = start;
+	while (pos < end) {
+		record* entry = new record;
+		adi_reader::load_result_t result;
+		reader.load_record(entry, pos, end, result);
+		if (result != adi_reader::LR_GOOD) {
+			// Only whitespace or an entry being written when the program stopped
+			delete entry;
+			break;
+		}
+		good = pos;
+		if (entry->item("APP_ZZA_JNL_OP") == "MARK") {
+			if (base_mark.length() && entry->item("APP_ZZA_JNL_MARK") == base_mark) {
+				// The log includes all the entries so far
+				for (auto it : entries) delete it;
+				entries.clear();
+			}
+			delete entry;
+		}
+		else {
+			entries.push_back(entry);
+		}
+	}
+	entries_ = (int)entries.size();
+	// Remove an incomplete entry so that further entries are not appended after it
+	if (memchr(good, '<', end - good)) {
+		buffer.resize(good - start);
+		rewrite(filename_, buffer);
+		size_ = buffer.length();
+	}
+}
+
+// Keep the entries after offset in the journal for the (new) log file
+bool journal::compact(std::streamoff offset, const std::string& log_file) {
+	std::string tail = "";
+	if (active() && offset < size_) {
+		std::ifstream in(filename_.c_str(), std::ios::in | std::ios::binary);
+		in.seekg(offset);
+		tail.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	}
+	log_filename(log_file);
+	if (!active()) return true;
+	if (!rewrite(filename_, tail)) {
+		return false;
+	}
+	size_ = tail.length();
+	// Count the entries
+	entries_ = 0;
+	for (size_t pos = tail.find("<EOR>"); pos != std::string::npos; pos = tail.find("<EOR>", pos + 5)) {
+		entries_++;
+	}
+	return true;
+}
+
+// Size of the journal file
+std::streamoff journal::size() {
+	return size_;
+}
+
+// Number of entries not in the log
+int journal::entries() {
+	return entries_;
+}
+
+// The key identifying the record
+std::string journal::key(record* qso) {
+	return qso->item("QSO_DATE") + " " + qso->item("TIME_ON") + " #" + qso->item("APP_ZZA_JNL_ID");
+}
+
+// A new identifier - the time this run of the program started and the record's identifier within it
+std::string journal::new_id(record* qso) {
+	static const time_t started = time(nullptr);
+	return std::to_string((long long)started) + "." + std::to_string(qso->id());
+}
+
+// Replace the journal file in a single step - remove it if there is no data
+bool journal::rewrite(const std::string& filename, const std::string& data) {
+	if (data.empty()) {
+		fl_unlink(filename.c_str());
+		return true;
+	}
+	std::string temp_file = filename + ".tmp";
+	std::ofstream out(temp_file.c_str(), std::ios::out | std::ios::binary);
+	out << data;
+	out.close();
+	if (out.fail() || !sync_file(temp_file)) {
+		fl_unlink(temp_file.c_str());
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(std::filesystem::u8path(temp_file), std::filesystem::u8path(filename), ec);
+	return !ec;
+}
@@ -0,0 +1,416 @@
+#include "log_bench.h"
+
+#include "adi_reader.h"
+#include "adi_writer.h"
+#include "adx_handler.h"
+#include "book.h"
+#include "main.h"
+#include "record.h"
+#include "spec_data.h"
+#include "status.h"
+#include "utils.h"
+
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+using json = nlohmann::json;
+
+extern bool closing_;
+
+// The seed of the random number generator - every benchmark generates the same logs
+const uint32_t BENCH_SEED = 3141592;
+// Date of the first generated QSO - 2000-01-01 00:00 UTC
+const time_t BENCH_START = 946684800;
+// A callsign is not reused within this time - so that the log has no duplicates
+const time_t BENCH_REUSE = 2 * 24 * 3600;
+
+//! Callsign prefixes and how often they appear.
+struct bench_prefix {
+	const char* prefix;   //!< The prefix.
+	uint32_t weight;      //!< Relative frequency.
+};
+
+//! Bands and how often they are used.
+struct bench_band {
+	const char* band;     //!< The ADIF band.
+	double lower;         //!< Lower edge (MHz).
+	double upper;         //!< Upper edge (MHz).
+	uint32_t weight;      //!< Relative frequency.
+};
+
+//! Modes and how often they are used.
+struct bench_mode {
+	const char* mode;     //!< The ADIF mode.
+	const char* submode;  //!< The ADIF submode.
+	bool digital;         //!< Reports are in dB.
+	uint32_t weight;      //!< Relative frequency.
+};
+
+const std::vector<bench_prefix> BENCH_PREFIXES = {
+	{ "G", 8 }, { "M", 6 }, { "2E", 2 }, { "GM", 3 }, { "GW", 1 }, { "EI", 2 },
+	{ "DL", 12 }, { "DK", 4 }, { "F", 6 }, { "ON", 3 }, { "PA", 4 }, { "I", 6 },
+	{ "EA", 7 }, { "CT", 2 }, { "OH", 2 }, { "SM", 3 }, { "LA", 2 }, { "OZ", 2 },
+	{ "SP", 5 }, { "OK", 3 }, { "HA", 2 }, { "YU", 1 }, { "UA", 8 }, { "UR", 3 },
+	{ "K", 10 }, { "W", 10 }, { "N", 6 }, { "VE", 3 }, { "JA", 8 }, { "VK", 3 },
+	{ "ZL", 1 }, { "PY", 3 }, { "LU", 2 }, { "ZS", 1 }, { "BY", 1 }, { "HL", 1 },
+	{ "4X", 1 }, { "VU", 1 }
+};
+
+const std::vector<bench_band> BENCH_BANDS = {
+	{ "160M", 1.810, 2.000, 2 }, { "80M", 3.500, 3.800, 6 }, { "60M", 5.3515, 5.3665, 1 },
+	{ "40M", 7.000, 7.200, 12 }, { "30M", 10.100, 10.150, 5 }, { "20M", 14.000, 14.350, 20 },
+	{ "17M", 18.068, 18.168, 6 }, { "15M", 21.000, 21.450, 9 }, { "12M", 24.890, 24.990, 4 },
+	{ "10M", 28.000, 29.700, 8 }, { "6M", 50.000, 52.000, 4 }, { "2M", 144.000, 146.000, 3 },
+	{ "70CM", 430.000, 440.000, 1 }
+};
+
+// Index in BENCH_BANDS of the first band where FM is used
+const size_t BENCH_FM_BAND = 9;
+
+const std::vector<bench_mode> BENCH_MODES = {
+	{ "FT8", "", true, 40 }, { "SSB", "USB", false, 25 }, { "CW", "", false, 20 },
+	{ "MFSK", "FT4", true, 5 }, { "RTTY", "", false, 4 }, { "FM", "", false, 3 },
+	{ "JT65", "", true, 3 }
+};
+
+const std::vector<std::string> BENCH_NAMES = {
+	"John", "Dave", "Peter", "Hans", "Jean", "Mario", "Taro", "Ivan",
+	"Bob", "Jim", "Anna", "Mike", "Paul", "Klaus", "Jose", "Sue"
+};
+
+const std::vector<uint32_t> BENCH_POWERS = { 5, 10, 50, 100, 400 };
+
+// Constructor
+log_bench::log_bench(const std::vector<size_t>& sizes, int runs)
+	: sizes_(sizes)
+	, runs_(runs)
+	, book_(nullptr)
+	, rng_(BENCH_SEED)
+	, dupes_(0)
+{
+}
+
+// Destructor
+log_bench::~log_bench() {
+}
+
+// Returns the timing statistics of one operation
+static json statistics(std::vector<double> times, size_t count) {
+	json j;
+	if (times.empty()) return j;
+	std::sort(times.begin(), times.end());
+	size_t n = times.size();
+	double median = (n % 2) ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2.0;
+	double mean = 0.0;
+	for (double t : times) mean += t;
+	mean /= n;
+	double variance = 0.0;
+	for (double t : times) variance += (t - mean) * (t - mean);
+	if (n > 1) variance /= (n - 1);
+	j["runs"] = n;
+	j["min_ms"] = times.front();
+	j["median_ms"] = median;
+	j["mean_ms"] = mean;
+	j["max_ms"] = times.back();
+	j["stddev_ms"] = std::sqrt(variance);
+	j["qsos_per_s"] = median > 0.0 ? count * 1000.0 / median : 0.0;
+	return j;
+}
+
+// Run all the benchmarks
+bool log_bench::run(book* b, const std::string& filename) {
+	book_ = b;
+	bool ok = true;
+	char msg[128];
+	json jlogs = json::array();
+	for (size_t count : sizes_) {
+		if (!ok || closing_) break;
+		// Every log starts with the same sequence - so a smaller log is the start of a larger one
+		rng_.seed(BENCH_SEED);
+		calls_.clear();
+		snprintf(msg, sizeof(msg), "BENCH: Generating log of %zu QSOs", count);
+		status_->misc_status(ST_NOTE, msg);
+		std::vector<record*> qsos;
+		generate(count, qsos);
+		operations_.clear();
+		times_.clear();
+		for (int run = 0; run < runs_ && ok && !closing_; run++) {
+			snprintf(msg, sizeof(msg), "BENCH: Log of %zu QSOs - run %d of %d", count, run + 1, runs_);
+			status_->misc_status(ST_NOTE, msg);
+			ok = time_operations(qsos);
+		}
+		for (auto qso : qsos) {
+			delete qso;
+		}
+		if (!ok) {
+			snprintf(msg, sizeof(msg), "BENCH: Log of %zu QSOs - an operation failed", count);
+			status_->misc_status(ST_ERROR, msg);
+			break;
+		}
+		json jlog;
+		jlog["qsos"] = count;
+		jlog["adi_bytes"] = adi_text_.length();
+		jlog["adx_bytes"] = adx_text_.length();
+		jlog["possible_dupes"] = dupes_;
+		json jops;
+		for (size_t ix = 0; ix < operations_.size(); ix++) {
+			json jop = statistics(times_[ix], count);
+			jops[operations_[ix]] = jop;
+			snprintf(msg, sizeof(msg), "BENCH: Log of %zu QSOs - %s median %.1f ms",
+				count, operations_[ix].c_str(), jop.value("median_ms", 0.0));
+			status_->misc_status(ST_OK, msg);
+		}
+		jlog["operations"] = jops;
+		jlogs.push_back(jlog);
+	}
+	adi_text_.clear();
+	adx_text_.clear();
+	// Write the results
+	json jall;
+	jall["program"] = PROGRAM_ID;
+	jall["version"] = PROGRAM_VERSION;
+	jall["date"] = now(false, "%Y-%m-%dT%H:%M:%SZ");
+	jall["seed"] = BENCH_SEED;
+	jall["runs"] = runs_;
+	jall["threads"] = std::thread::hardware_concurrency();
+	jall["logs"] = jlogs;
+	std::ofstream os(filename);
+	os << std::setw(2) << jall << '\n';
+	os.close();
+	if (os.fail()) {
+		snprintf(msg, sizeof(msg), "BENCH: Failed to write results to %s", filename.c_str());
+		status_->misc_status(ST_ERROR, msg);
+		return false;
+	}
+	snprintf(msg, sizeof(msg), "BENCH: Results written to %s", filename.c_str());
+	status_->misc_status(ok ? ST_OK : ST_WARNING, msg);
+	return ok;
+}
+
+// Returns a random number less than limit - the same on all platforms
+uint32_t log_bench::random(uint32_t limit) {
+	return (uint32_t)(rng_() % limit);
+}
+
+// Choose an entry according to its relative weight
+size_t log_bench::weighted(const std::vector<uint32_t>& weights) {
+	uint32_t total = 0;
+	for (uint32_t w : weights) total += w;
+	uint32_t r = random(total);
+	for (size_t ix = 0; ix < weights.size(); ix++) {
+		if (r < weights[ix]) return ix;
+		r -= weights[ix];
+	}
+	return weights.size() - 1;
+}
+
+// Generate a callsign - prefix, digit and 1 to 3 letter suffix
+std::string log_bench::callsign() {
+	static std::vector<uint32_t> weights;
+	if (weights.empty()) {
+		for (auto& p : BENCH_PREFIXES) weights.push_back(p.weight);
+	}
+	std::string call = BENCH_PREFIXES[weighted(weights)].prefix;
+	call += (char)('0' + random(10));
+	// Mostly 2 or 3 letter suffixes
+	size_t letters = 1 + weighted({ 1, 4, 6 });
+	for (size_t ix = 0; ix < letters; ix++) {
+		call += (char)('A' + random(26));
+	}
+	return call;
+}
+
+// Generate the log
+void log_bench::generate(size_t count, std::vector<record*>& qsos) {
+	std::vector<uint32_t> band_weights;
+	for (auto& b : BENCH_BANDS) band_weights.push_back(b.weight);
+	std::vector<uint32_t> mode_weights;
+	for (auto& m : BENCH_MODES) mode_weights.push_back(m.weight);
+	// When each callsign was last worked
+	std::vector<time_t> last_worked;
+	qsos.reserve(count);
+	time_t t = BENCH_START;
+	size_t session_left = 0;
+	size_t band_ix = 0;
+	size_t mode_ix = 0;
+	char text[32];
+	for (size_t num = 0; num < count; num++) {
+		if (session_left == 0) {
+			// Operating sessions of 5 to 150 QSOs, 1 hour to 2 days apart, on one band and mostly one mode
+			session_left = 5 + random(146);
+			t += 3600 + random(2 * 24 * 3600);
+			band_ix = weighted(band_weights);
+			mode_ix = weighted(mode_weights);
+		}
+		session_left--;
+		t += 60 + random(540);
+		// Change mode sometimes during a session
+		if (random(10) == 0) mode_ix = weighted(mode_weights);
+		const bench_mode& mode = (strcmp(BENCH_MODES[mode_ix].mode, "FM") == 0 && band_ix < BENCH_FM_BAND) ?
+			BENCH_MODES[1] : BENCH_MODES[mode_ix];
+		const bench_band& band = BENCH_BANDS[band_ix];
+		// Work a regular more than half the time - earlier contacts are more likely
+		size_t call_ix = calls_.size();
+		if (calls_.size() && random(100) < 55) {
+			uint32_t a = random((uint32_t)calls_.size());
+			uint32_t b = random((uint32_t)calls_.size());
+			call_ix = std::min(a, b);
+			if (t - last_worked[call_ix] < BENCH_REUSE) call_ix = calls_.size();
+		}
+		if (call_ix == calls_.size()) {
+			calls_.push_back(callsign());
+			last_worked.push_back(t);
+		}
+		last_worked[call_ix] = t;
+
+		record* qso = new record;
+		qso->item("CALL", calls_[call_ix], false, false);
+		strftime(text, sizeof(text), "%Y%m%d", gmtime(&t));
+		qso->item("QSO_DATE", std::string(text), false, false);
+		strftime(text, sizeof(text), "%H%M%S", gmtime(&t));
+		qso->item("TIME_ON", std::string(text), false, false);
+		time_t t_off = t + 30 + random(150);
+		strftime(text, sizeof(text), "%Y%m%d", gmtime(&t_off));
+		qso->item("QSO_DATE_OFF", std::string(text), false, false);
+		strftime(text, sizeof(text), "%H%M%S", gmtime(&t_off));
+		qso->item("TIME_OFF", std::string(text), false, false);
+		qso->item("BAND", std::string(band.band), false, false);
+		double freq = band.lower + (band.upper - band.lower) * random(10000) / 10000.0;
+		snprintf(text, sizeof(text), "%.6f", freq);
+		qso->item("FREQ", std::string(text), false, false);
+		qso->item("MODE", std::string(mode.mode), false, false);
+		if (*mode.submode) qso->item("SUBMODE", std::string(mode.submode), false, false);
+		for (const char* field : { "RST_SENT", "RST_RCVD" }) {
+			if (mode.digital) snprintf(text, sizeof(text), "%+03d", (int)random(34) - 24);
+			else if (strcmp(mode.mode, "CW") == 0 || strcmp(mode.mode, "RTTY") == 0) snprintf(text, sizeof(text), "5%u9", 5 + random(5));
+			else snprintf(text, sizeof(text), "5%u", 5 + random(5));
+			qso->item(field, std::string(text), false, false);
+		}
+		if (mode.digital || random(10) < 3) {
+			snprintf(text, sizeof(text), "%c%c%u%u", 'A' + random(18), 'A' + random(18), random(10), random(10));
+			qso->item("GRIDSQUARE", std::string(text), false, false);
+		}
+		if (!mode.digital && random(10) < 4) {
+			qso->item("NAME", BENCH_NAMES[random((uint32_t)BENCH_NAMES.size())], false, false);
+		}
+		qso->item("TX_PWR", std::to_string(BENCH_POWERS[random((uint32_t)BENCH_POWERS.size())]), false, false);
+		qso->item("STATION_CALLSIGN", "GM3ZZA", false, false);
+		qso->item("MY_GRIDSQUARE", "IO85", false, false);
+		// QSL status
+		if (random(10) < 7) {
+			qso->item("LOTW_QSL_SENT", "Y", false, false);
+			if (random(10) < 4) {
+				time_t t_qsl = t + 24 * 3600 * (1 + random(90));
+				strftime(text, sizeof(text), "%Y%m%d", gmtime(&t_qsl));
+				qso->item("LOTW_QSL_RCVD", "Y", false, false);
+				qso->item("LOTW_QSLRDATE", std::string(text), false, false);
+			}
+		}
+		if (random(10) < 5) qso->item("EQSL_QSL_SENT", "Y", false, false);
+		qsos.push_back(qso);
+	}
+}
+
+// Empty the book and give it a header
+void log_bench::empty_book(size_t count) {
+	book_->delete_contents(false);
+	record* header = new record;
+	header->header("Synthetic log generated by the ZZALOG benchmark");
+	header->item("PROGRAMID", PROGRAM_ID, false, false);
+	header->item("PROGRAMVERSION", PROGRAM_VERSION, false, false);
+	header->item("ADIF_VER", spec_data_->adif_version(), false, false);
+	header->item("APP_ZZA_NUMRECORDS", std::to_string(count), false, false);
+	book_->header(header);
+}
+
+// Record the time taken by the operation
+void log_bench::add_time(const std::string& operation, std::chrono::steady_clock::time_point start) {
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	auto it = std::find(operations_.begin(), operations_.end(), operation);
+	size_t ix = it - operations_.begin();
+	if (it == operations_.end()) {
+		operations_.push_back(operation);
+		times_.emplace_back();
+	}
+	times_[ix].push_back(ms);
+}
+
+// Time each operation once - the book is accessed as book::load_data does
+bool log_bench::time_operations(const std::vector<record*>& qsos) {
+	bool ok = true;
+	size_t count = qsos.size();
+	// Insert a copy of each QSO
+	std::vector<record*> copies;
+	copies.reserve(count);
+	for (auto qso : qsos) {
+		copies.push_back(new record(*qso));
+	}
+	empty_book(count);
+	book_->main_loading_ = true;
+	auto start = std::chrono::steady_clock::now();
+	for (auto qso : copies) {
+		book_->insert_record(qso);
+	}
+	add_time("insert", start);
+	book_->main_loading_ = false;
+	copies.clear();
+
+	// Save the book in both formats
+	std::ostringstream adi_out;
+	adi_writer* writer = new adi_writer;
+	start = std::chrono::steady_clock::now();
+	ok &= writer->store_book(book_, adi_out, false);
+	add_time("save_adi", start);
+	delete writer;
+	adi_text_ = adi_out.str();
+	std::ostringstream adx_out;
+	adx_handler* adx = new adx_handler;
+	start = std::chrono::steady_clock::now();
+	ok &= adx->store_book(book_, adx_out, false);
+	add_time("save_adx", start);
+	delete adx;
+	adx_text_ = adx_out.str();
+
+	// Load the .adi text
+	empty_book(count);
+	std::istringstream adi_in(adi_text_);
+	book_->main_loading_ = true;
+	book_->adi_reader_ = new adi_reader;
+	start = std::chrono::steady_clock::now();
+	ok &= book_->adi_reader_->load_book(book_, adi_in);
+	add_time("load_adi", start);
+	delete book_->adi_reader_;
+	book_->adi_reader_ = nullptr;
+	book_->main_loading_ = false;
+	ok &= book_->size() == count;
+
+	// Find the possible duplicates in the loaded log - without asking about them
+	start = std::chrono::steady_clock::now();
+	book_->find_dupes();
+	add_time("find_dupes", start);
+	dupes_ = (int)book_->dupe_pairs_.size();
+
+	// Load the .adx text
+	empty_book(count);
+	std::istringstream adx_in(adx_text_);
+	book_->main_loading_ = true;
+	book_->adx_handler_ = new adx_handler;
+	start = std::chrono::steady_clock::now();
+	ok &= book_->adx_handler_->load_book(book_, adx_in);
+	add_time("load_adx", start);
+	delete book_->adx_handler_;
+	book_->adx_handler_ = nullptr;
+	book_->main_loading_ = false;
+	ok &= book_->size() == count;
+
+	book_->delete_contents(false);
+	return ok;
+}
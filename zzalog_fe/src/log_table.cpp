@@ -605,7 +605,7 @@ void log_table::draw_cell(TableContext context, int R, int C, int X, int Y, int
 				Fl_Font font = font_;
 				if (direct == text) font = font;
 				else font ^= FL_ITALIC;
-				bool swl = this_record->item("SWL") == "Y";
+				bool swl = this_record->item(FI_SWL) == "Y";
 				if (swl) { 
 					font ^= FL_ITALIC;
 					fl_color(fl_color_average(fl_color(), bg_colour, 2.F/3.F));
@@ -28,10 +28,12 @@ main.cpp - application entry point
 #include "fields.h"
 #include "file_holder.h"
 #include "fllog_emul.h"
+#include "gz_stream.h"
 #include "import_data.h"
 #include "init_dialog.h"
 #include "intl_dialog.h"
 #include "logo.h"
+#include "log_bench.h"
 #include "lotw_handler.h"
 #include "main_window.h"
 #include "menu.h"
@@ -132,6 +134,8 @@ bool AUTO_SAVE_S = false;
 bool DARK = false;
 //! Version of \p DARK read from settings.
 bool DARK_S = false;
+//! Time the log handling on synthetic logs instead of running ZZALOG - by "-b"
+bool BENCHMARK = false;
 //! Print version details instead of running ZZALOG -  by "-v"
 bool DISPLAY_VERSION = false;
 //! Print command-line interface instead of running ZZALOG -  by "-h"
@@ -203,6 +207,12 @@ double prev_freq_ = 0.0;
 //! Filename in arguments.
 char* filename_ = nullptr;
 
+//! Numbers of QSOs in the benchmark logs - by "-b N..."
+std::vector<size_t> bench_sizes_;
+
+//! Number of times each benchmark operation is timed - by "-b r=N"
+int bench_runs_ = 5;
+
 //! File is new (neither in argument or settings.
 bool new_file_ = false;
 
@@ -259,6 +269,11 @@ std::string backup_filename(std::string source) {
 	}
 	// Create backup filename - use back-up directory and current file-name plus timestamp
 	size_t last_period = source.find_last_of('.');
+	// Keep the file type of a compressed file with its .gz
+	if (gz_streambuf::is_compressed(source) && last_period != std::string::npos && last_period > 0) {
+		size_t type_period = source.find_last_of('.', last_period - 1);
+		if (type_period != std::string::npos) last_period = type_period;
+	}
 	size_t last_slash = source.find_last_of("/\\");
 	std::string suffix = source.substr(last_period);
 	std::string base_name;
@@ -390,6 +405,9 @@ void cb_bn_close(Fl_Widget* w, void*v) {
 			}
 		}
 
+		// Let any background save finish before backing up its file
+		if (book_) book_->wait_for_save();
+
 		// Back up the book
 		if (book_ && book_->been_modified()) {
 			if (using_backup_) {
@@ -436,6 +454,28 @@ int cb_args(int argc, char** argv, int& i) {
 		AUTO_SAVE_S = true;
 		i += 1;
 	}
+	// Benchmark
+	else if (strcmp("-b", argv[i]) == 0 || strcmp("--bench", argv[i]) == 0) {
+		BENCHMARK = true;
+		// Do not save or upload anything
+		AUTO_SAVE = false;
+		AUTO_UPLOAD = false;
+		AUTO_SAVE_S = true;
+		AUTO_UPLOAD_S = true;
+		i += 1;
+		while (i < argc && argv[i][0] != '-') {
+			if (strncmp("r=", argv[i], 2) == 0) {
+				bench_runs_ = std::max(1, atoi(argv[i] + 2));
+			}
+			else if (atoi(argv[i]) > 0) {
+				bench_sizes_.push_back((size_t)atoi(argv[i]));
+			}
+			else {
+				break;
+			}
+			i += 1;
+		}
+	}
 	// Debug
 	else if (strcmp("-d", argv[i]) == 0 || strcmp("--debug", argv[i]) == 0) {
 		i += 1;
@@ -637,6 +677,9 @@ void show_help() {
 	"\n"
 	"switches:\n"
 	"\t-a|--auto_save\tDo automatically save each change (sticky)\n"
+	"\t-b|--bench [N...] [r=N]\tTime log handling on synthetic logs of N QSOs\n"
+	"\t\t\t(default 10000 100000 1000000) N times each (default 5),\n"
+	"\t\t\tresults written to zzalog_bench.json\n"
   	"\t-d|--debug [mode...]\n"
 	"\t\tc|curl\tincrease verbosity from libcurl\n"
 	"\t\t\tnoc|nocurl\n"
@@ -1224,6 +1267,12 @@ int main(int argc, char** argv)
 
 	// Ctreate status to handle status messages
 	status_ = new status();
+	if (BENCHMARK) {
+		// Time the log handling instead of opening the log - no window is created
+		int code = run_bench() ? 0 : 1;
+		tidy();
+		return code;
+	}
 	// Create banner
 	banner_ = new banner(400, 200);
 	std::string title = PROGRAM_ID + " " + PROGRAM_VERSION;
@@ -1252,6 +1301,8 @@ int main(int argc, char** argv)
 	Fl::check();
 	// Read in log book data - uses progress - use supplied argument for filename
 	add_book(filename_);
+	// From now on ask the user before a field identifying a QSO is deleted in the main thread
+	record::policy(record::ask_user());
 	printf("%s\n", main_window_->label());
 	Fl::check();
 	// Connect to the rig - load all hamlib backends once only here
@@ -1293,6 +1344,28 @@ int main(int argc, char** argv)
 	return code;
 }
 
+// Time the log handling on synthetic logs - the benchmark uses an empty main book
+// It runs headless, so only the reference data the log handling uses is loaded
+bool run_bench() {
+	spec_data_ = new spec_data;
+	if (!spec_data_->valid()) {
+		status_->misc_status(ST_FATAL, "Do not have a valid ADIF reference - check installation");
+		return false;
+	}
+	spec_data_->process_bands();
+	cty_data_ = new cty_data;
+	if (closing_) return false;
+	book_ = new book;
+	navigation_book_ = book_;
+	import_data_ = new import_data;
+	extract_records_ = new extract_data;
+	if (bench_sizes_.empty()) {
+		bench_sizes_ = { 10000, 100000, 1000000 };
+	}
+	log_bench bench(bench_sizes_, bench_runs_);
+	return bench.run(book_, "zzalog_bench.json");
+}
+
 // Copy existing data to back up file. force = true used by menu command, 
 void backup_file() {
 	std::string source = book_->filename();
@@ -12,6 +12,7 @@
 #include "cty_data.h"
 #include "eqsl_handler.h"
 #include "extract_data.h"
+#include "gz_stream.h"
 #include "import_data.h"
 #include "intl_dialog.h"
 #include "main.h"
@@ -339,7 +340,7 @@ void menu::cb_mi_file_open(Fl_Widget* w, void* v) {
 		Fl_Native_File_Chooser* chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
 		chooser->title("Select file name to load");
 		chooser->directory(directory.c_str());
-		chooser->filter("ADI Files\t*.adi\nADX Files\t*.adx");
+		chooser->filter("ADI Files\t*.{adi,adi.gz}\nADX Files\t*.{adx,adx.gz}");
 		if (chooser->show() == 0) {
 			filename = chooser->filename();
 		}
@@ -395,12 +396,12 @@ void menu::cb_mi_file_saveas(Fl_Widget* w, void* v) {
 	std::string filename = book_->filename();
 	Fl_Native_File_Chooser* chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_SAVE_FILE);
 	chooser->title("Select file name to save");
-	chooser->filter("ADI Files\t*.adi\nADX Files\t*.adx\nTSV Files\t*.{tsv,tab}");
+	chooser->filter("ADI Files\t*.{adi,adi.gz}\nADX Files\t*.{adx,adx.gz}\nTSV Files\t*.{tsv,tab}");
 	chooser->preset_file(filename.c_str());
 	if (chooser->show() == 0) {
 		filename = chooser->filename();
-		// No file type - force it to .adi
-		std::string suffix = filename.substr(filename.length() - 4);
+		// No file type - force it to .adi. A .gz suffix compresses the file
+		std::string suffix = gz_streambuf::file_type(filename);
 		if (suffix != ".adi" && suffix != ".adx" && suffix != ".tsv" && suffix != ".tab") {
 			filename += ".adi";
 		}
@@ -879,7 +880,7 @@ void menu::cb_mi_log_bulk(Fl_Widget* w, void* v) {
 // Log->Check Duplicates - call book's check duplicates
 // v is not used
 void menu::cb_mi_log_dupes(Fl_Widget* w, void* v) {
-	navigation_book_->check_dupes(false);
+	navigation_book_->check_dupes();
 }
 
 // Log->Edit Header - open editor on header comment
@@ -955,7 +956,7 @@ void menu::cb_mi_imp_file(Fl_Widget* w, void* v) {
 	Fl_Native_File_Chooser* chooser = new Fl_Native_File_Chooser(Fl_Native_File_Chooser::BROWSE_FILE);
 	chooser->title("Select file name");
 	chooser->directory(directory.c_str());
-	chooser->filter("ADI files\t*.adi\nADX Files\t*.adx");
+	chooser->filter("ADI files\t*.{adi,adi.gz}\nADX Files\t*.{adx,adx.gz}");
 	import_data::update_mode_t mode = (import_data::update_mode_t)(intptr_t)v;
 	if (chooser->show() == 0) {
 		filename = chooser->filename();
@@ -1115,8 +1116,7 @@ void menu::cb_mi_ext_mark(Fl_Widget* w, void* v) {
 // v is not used
 void menu::cb_mi_ext_dl_images(Fl_Widget* w, void* v) {
 	for (item_num_t ix = 0; ix < extract_records_->size(); ix++) {
-		qso_num_t qn = extract_records_->record_number(ix);
-		eqsl_handler_->enqueue_request(qn, true);
+		eqsl_handler_->enqueue_request(extract_records_->get_record(ix, false)->id(), true);
 	}
 	eqsl_handler_->enable_fetch(eqsl_handler::EQ_START);
 }
@@ -575,7 +575,7 @@ bool qrz_handler::upload_single_qso(qso_num_t qso_number) {
 	// Now send to upload std::thread to process
 	upload_lock_.lock();
 	if (DEBUG_THREADS) printf("EQSL MAIN: Enqueueing eQSL request %s\n", qso->item("CALL").c_str());
-	upload_queue_.push(qso);
+	upload_queue_.emplace(qso, qso->snapshot());
 	upload_lock_.unlock();
 	return true;
 }
@@ -602,11 +602,11 @@ void qrz_handler::thread_run(qrz_handler* that) {
 		// Process it
 		that->upload_lock_.lock();
 		if (!that->upload_queue_.empty()) {
-			record* qso = that->upload_queue_.front();
+			std::pair<record*, std::unique_ptr<record> > request = std::move(that->upload_queue_.front());
 			that->upload_queue_.pop();
-			if (DEBUG_THREADS) printf("QRZ THREAD: Received request %s\n", qso->item("CALL").c_str());
+			if (DEBUG_THREADS) printf("QRZ THREAD: Received request %s\n", request.second->item("CALL").c_str());
 			that->upload_lock_.unlock();
-			that->th_upload_qso(qso);
+			that->th_upload_qso(request.first, request.second.get());
 		}
 		else {
 			that->upload_lock_.unlock();
@@ -616,13 +616,13 @@ void qrz_handler::thread_run(qrz_handler* that) {
 }
 
 // Upload a single QSO in th ethead
-void qrz_handler::th_upload_qso(record* qso) {
+void qrz_handler::th_upload_qso(record* qso, record* snapshot) {
 	std::stringstream request;
 	std::stringstream response;
-	std::string callsign = qso->item("STATION_CALLSIGN");
+	std::string callsign = snapshot->item("STATION_CALLSIGN");
 	qsl_call_data* call_data = api_data_->at(callsign);
 	std::string fail_message;
-	insert_request(call_data, request, qso);
+	insert_request(call_data, request, snapshot);
 	url_handler_->post_url("https://logbook.qrz.com/api", "", &request, &response);
 	response.seekg(0, std::ios::beg);
 	upload_resp_t* resp = new upload_resp_t;
@@ -49,8 +49,6 @@ std::map<qso_data::logging_state_t, std::list<qso_buttons::button_type> > button
 	{ qso_data::QUERY_NEW, { qso_buttons::ADD_QUERY, qso_buttons::REJECT_QUERY, qso_buttons::FIND_QSO, 
 		qso_buttons::LOOK_ALL_TXT, qso_buttons::QRZ_COM }},
 	{ qso_data::QUERY_WSJTX, { qso_buttons::ADD_QUERY, qso_buttons::REJECT_QUERY } },
-	{ qso_data::QUERY_DUPE, { qso_buttons::KEEP_DUPE_1, qso_buttons::MERGE_DUPE, qso_buttons::KEEP_DUPE_2,
-		qso_buttons::KEEP_BOTH_DUPES }},
 	{ qso_data::QUERY_SWL, { qso_buttons::ADD_QUERY, qso_buttons::REJECT_QUERY } },
 	{ qso_data::QRZ_MERGE, { qso_buttons::MERGE_DONE }},
 	{ qso_data::QRZ_COPY, { qso_buttons::MERGE_DONE }},
@@ -99,10 +97,6 @@ std::map<qso_buttons::button_type, qso_buttons::button_action> action_map_ =
 	{ qso_buttons::REJECT_QUERY, {"Reject QSO", "Do not add queried QSO to log", qso_buttons::cb_bn_reject_query, 0} },
 	{ qso_buttons::MERGE_QUERY, {"Merge QSO", "Merge query with logged QSO", qso_buttons::cb_bn_merge_query, 0 } },
 	{ qso_buttons::FIND_QSO, { "@search", "Display possible match", qso_buttons::cb_bn_find_match, 0}},
-	{ qso_buttons::KEEP_DUPE_1, { "Keep 1", "Keep first QSO and delete second", qso_buttons::cb_bn_dupe, (void*)qso_data::DF_1}},
-	{ qso_buttons::KEEP_DUPE_2, { "Keep 2", "Keep second QSO and delete first", qso_buttons::cb_bn_dupe, (void*)qso_data::DF_2}},
-	{ qso_buttons::MERGE_DUPE, { "Merge", "Merge the two records", qso_buttons::cb_bn_dupe, (void*)qso_data::DF_MERGE}},
-	{ qso_buttons::KEEP_BOTH_DUPES, { "Keep 1 && 2", "Keep both records", qso_buttons::cb_bn_dupe, (void*)qso_data::DF_BOTH}},
 	{ qso_buttons::MERGE_DONE, { "Done", "Save changes", qso_buttons::cb_bn_save_merge, 0} },
 	{ qso_buttons::LOOK_ALL_TXT, { "@search ALL.TXT", "Look in WSJT-X ALL.TXT file for possible contact", qso_buttons::cb_bn_all_txt, 0 } },
 	{ qso_buttons::START_NET, { "Start Net", "Start a QSO with more than one other station", qso_buttons::cb_bn_start_net, 0 } },
@@ -577,22 +571,6 @@ void qso_buttons::cb_bn_find_match(Fl_Widget* w, void* v) {
 	that->enable_widgets();
 }
 
-// Callback - dupe action
-// v is not used
-void qso_buttons::cb_bn_dupe(Fl_Widget* w, void* v) {
-	qso_buttons* that = ancestor_view<qso_buttons>(w);
-	that->disable_widgets();
-	qso_data::dupe_flags action = (qso_data::dupe_flags)(intptr_t)v;
-	switch (that->qso_data_->logging_state()) {
-	case qso_data::QUERY_DUPE:
-		that->qso_data_->action_handle_dupe(action);
-		break;
-	default:
-		break;
-	}
-	that->enable_widgets();
-}
-
 // Callback QRZ merge action
 // v is not used
 void qso_buttons::cb_bn_save_merge(Fl_Widget* w, void* v) {
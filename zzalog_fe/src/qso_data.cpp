@@ -313,8 +313,6 @@ void qso_data::enable_widgets() {
 			g_misc_->qso(current_qso(), current_number());
 			g_misc_->enable_widgets();
 			break;
-		case QUERY_DUPE:
-			// Show two logged QSOs in query form to check for duplicate
 		case QUERY_MATCH:
 			// Show an imported QSO and possible match in log check if matcehd
 		case QRZ_MERGE:
@@ -571,7 +569,6 @@ void qso_data::update_query(logging_state_t query, qso_num_t match_num, qso_num_
 	case QSO_VIEW:
 	case QUERY_NEW:
 	case QUERY_WSJTX:
-	case QUERY_DUPE:
 	case QUERY_SWL:
 	case MANUAL_ENTRY:
 		action_query(query, match_num, query_num);
@@ -713,7 +710,6 @@ qso_num_t qso_data::get_default_number() {
 	case TEST_ACTIVE:
 		return g_entry_->qso_number();
 	case QSO_BROWSE:
-	case QUERY_DUPE:
 	case QUERY_MATCH:
 		return g_query_->qso_number();
 	case NET_EDIT:
@@ -1044,7 +1040,6 @@ void qso_data::action_deactivate() {
 	case QUERY_MATCH:
 	case QUERY_NEW:
 	case QUERY_WSJTX:
-	case QUERY_DUPE:
 		g_query_->clear_query();
 		break;
 	case MANUAL_ENTRY:
@@ -1216,10 +1211,6 @@ void qso_data::action_query(logging_state_t query, qso_num_t match_number, qso_n
 	case QUERY_SWL:
 		g_query_->set_query(import_data_->match_question(), match_number, import_data_->get_record(query_number, false));
 		break;
-	case QUERY_DUPE:
-		// Note record numbers relate to book even if it is extracted data that refered the dupe check
-		g_query_->set_query(navigation_book_->match_question(), match_number, book_->get_record(query_number, false), false);
-		break;
 	case QRZ_MERGE: {
 		// We are using selected record and merge data accordingly
 		bool ok = true;
@@ -1315,34 +1306,6 @@ void qso_data::action_find_match() {
 	update_query(QUERY_MATCH, potential_match_, query_number_);
 }
 
-// Action handle dupe
-void qso_data::action_handle_dupe(dupe_flags action) {
-	switch (action) {
-	case DF_1:
-		// Discard the queried possible duplicate
-		navigation_book_->reject_dupe(false);
-		break;
-	case DF_2:
-		// Keep the queried possible duplicate record and discard the original record
-		navigation_book_->reject_dupe(true);
-		break;
-	case DF_MERGE:
-		// Discard the queried duplicate record after merging the two records
-		navigation_book_->merge_dupe();
-		break;
-	case DF_BOTH:
-		// Queried duplicate record is not a duplicate, keep both it and the original record
-		navigation_book_->accept_dupe();
-		break;
-	}
-	g_query_->clear_query();
-	action_deactivate();;
-	enable_widgets();
-	// Restart the duplicate check process
-	navigation_book_->check_dupes(true);
-
-}
-
 // Action save as a result of a merge
 void qso_data::action_save_merge() {
 	// We no longer need to maintain the copy of the original QSO
@@ -1898,7 +1861,6 @@ record* qso_data::current_qso() {
 	case TEST_PENDING:
 		return g_entry_->qso();
 	case QSO_BROWSE:
-	case QUERY_DUPE:
 	case QUERY_MATCH:
 	case QUERY_NEW:
 	case QUERY_WSJTX:
@@ -1933,7 +1895,6 @@ record* qso_data::query_qso() {
 	case MANUAL_ENTRY:
 		return nullptr;
 	case QSO_BROWSE:
-	case QUERY_DUPE:
 	case QUERY_MATCH:
 	case QUERY_NEW:
 	case QUERY_WSJTX:
@@ -1960,7 +1921,6 @@ qso_num_t qso_data::current_number() {
 	case TEST_ACTIVE:
 		return g_entry_->qso_number();
 	case QSO_BROWSE:
-	case QUERY_DUPE:
 	case QUERY_MATCH:
 	case QUERY_NEW:
 	case QUERY_WSJTX:
@@ -153,8 +153,12 @@ void qso_details::get_qsos() {
 		}
 	}
 
-	// Scan the book for all records with this callsign
-	for (qso_num_t ix = 0; qso_ && ix < book_->size(); ix++) {
+	// Look at all the records that may be with this callsign
+	std::vector<qso_num_t> candidates;
+	if (qso_ && call.length()) {
+		candidates = book_->qsos_like_call(call);
+	}
+	for (qso_num_t ix : candidates) {
 		record* it = book_->get_record(ix, false);
 		if (it->item("CALL") == call) {
 			// Get all NAME fields
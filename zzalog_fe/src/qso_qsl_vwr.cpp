@@ -467,7 +467,7 @@ void qso_qsl_vwr::cb_rad_card(Fl_Widget* w, void* v) {
 void qso_qsl_vwr::cb_bn_fetch(Fl_Widget* w, void* v) {
 	qso_qsl_vwr* that = ancestor_view<qso_qsl_vwr>(w);
 	// Put the card request onto the eQSL request std::queue - so that requests are made
-	eqsl_handler_->enqueue_request(that->current_qso_num_, true);
+	eqsl_handler_->enqueue_request(book_->get_record(that->current_qso_num_, false)->id(), true);
 	eqsl_handler_->enable_fetch(eqsl_handler::EQ_START);
 	// Wait until donwload complete
 	while (eqsl_handler_->requests_queued()) Fl::check();
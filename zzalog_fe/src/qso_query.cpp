@@ -83,7 +83,6 @@ void qso_query::enable_widgets() {
 		tab_query_->set_records(log_qso_, query_qso_, original_qso_);
 		tab_query_->redraw();
 		break;
-	case qso_data::QUERY_DUPE:
 	case qso_data::QUERY_MATCH:
 	case qso_data::QUERY_NEW:
 	case qso_data::QUERY_WSJTX:
@@ -191,7 +190,6 @@ void qso_query::clear_query() {
 void qso_query::action_handle_dclick(int col, std::string field) {
 	switch (qso_data_->logging_state()) {
 	case qso_data::QUERY_MATCH:
-	case qso_data::QUERY_DUPE:
 	case qso_data::QRZ_MERGE:
 	case qso_data::QRZ_COPY:
 		switch (col) {
@@ -7,6 +7,7 @@ record.cpp - Individual record data item: implementation file
 */
 #include "record.h"
 
+#include "adi_reader.h"
 #include "book.h"
 #include "cty_data.h"
 #include "main.h"
@@ -20,6 +21,7 @@ record.cpp - Individual record data item: implementation file
 #include <chrono>
 #include <ratio>
 #include <cmath>
+#include <set>
 
 #include <FL/fl_ask.H>
 #include <FL/fl_utf8.h>
@@ -27,6 +29,108 @@ record.cpp - Individual record data item: implementation file
 // initialise the static variables
 bool record::expecting_header_ = true;
 bool record::inhibit_error_reporting_ = false;
+std::mutex record::write_mutex_;
+std::atomic<bool> record::lock_writes_(false);
+std::atomic<qso_id_t> record::last_id_(0);
+std::shared_ptr<const std::vector<field_desc_t> > record::descriptors_;
+thread_local item_policy* record::policy_ = nullptr;
+
+// Fields always logged in upper case
+static const std::set<std::string> UPPER_CASE_FIELDS = {
+	"CALL", "CONT", "MY_CALL", "GRIDSQUARE", "MY_GRIDSQUARE", "OPERATOR", "OWNER_CALLSIGN",
+	"STATION_CALLSIGN", "IOTA", "MY_IOTA", "COUNTRY", "MY_COUNTRY", "APP_ZZA_PFX"
+};
+
+// Fields that identify the QSO - deleting one needs the user's agreement
+static const std::set<std::string> CONFIRM_DELETE_FIELDS = {
+	"CALL", "QSO_DATE", "QSO_DATE_OFF", "TIME_ON", "TIME_OFF"
+};
+
+// Use the value as it is
+static std::string normalise_none(const std::string& value) {
+	return value;
+}
+
+// Convert the value to upper case
+static std::string normalise_upper(const std::string& value) {
+	return to_upper(value);
+}
+
+// Strip leading zeros from an integer
+static std::string normalise_positive_integer(const std::string& value) {
+	size_t dummy;
+	try {
+		int int_value = std::stoi(value, &dummy);
+		if (dummy == value.length()) {
+			// The whole std::string is an integer - convert it back to std::string
+			return std::to_string(int_value);
+		}
+	}
+	catch (std::invalid_argument&) {
+		// Empty std::string, so use that
+	}
+	catch (std::out_of_range&) {
+		// Too many digits - use it as it is
+	}
+	// Use the original std::string
+	return value;
+}
+
+// Records are allocated in blocks of slots and the slots of deleted records are kept for reuse.
+// Loading, extracting and deleting large books then only rarely go to the general allocator.
+// The blocks are never released: the program re-uses them for the next book it loads.
+class record_pool {
+public:
+	// Returns a free slot, allocating a new block if there are none
+	void* allocate() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (free_ == nullptr) {
+			slot_t* block = new slot_t[BLOCK_SLOTS];
+			for (size_t ix = 0; ix < BLOCK_SLOTS; ix++) {
+				block[ix].next = free_;
+				free_ = &block[ix];
+			}
+		}
+		slot_t* slot = free_;
+		free_ = slot->next;
+		return slot;
+	}
+	// Put the slot back on the free list
+	void release(void* p) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		slot_t* slot = static_cast<slot_t*>(p);
+		slot->next = free_;
+		free_ = slot;
+	}
+	// The pool - created on first use and never destroyed, so records may be deleted at any time
+	static record_pool& pool() {
+		static record_pool* pool = new record_pool;
+		return *pool;
+	}
+
+protected:
+	// A slot holds a record or, when free, the next free slot
+	union slot_t {
+		slot_t* next;
+		alignas(record) char data[sizeof(record)];
+	};
+	// Number of slots allocated together
+	static const size_t BLOCK_SLOTS = 1024;
+	// Held while the free list is used - records are created and deleted on several threads
+	std::mutex mutex_;
+	// The free slots
+	slot_t* free_{ nullptr };
+};
+
+// Asks the user before a field that identifies the QSO is deleted
+class ask_user_policy : public item_policy {
+public:
+	bool allow_delete(record* qso, const std::string& field) override {
+		char message[256];
+		snprintf(message, 256, "You are deleting %s, are you sure", field.c_str());
+		return fl_choice(message, "Yes", "No", nullptr) != 1;
+	}
+};
 
 // Comparison operator - compares QSO_DATE and TIME_ON - orders the records by time.
 bool record::operator > (record& them) {
@@ -34,7 +138,7 @@ bool record::operator > (record& them) {
 	if (timestamp_ > them.timestamp_) {
 		return true;
 	}
-	else if (timestamp_ == them.timestamp_ && item("CALL") > them.item("CALL")) {
+	else if (timestamp_ == them.timestamp_ && item(FI_CALL) > them.item(FI_CALL)) {
 		// If times are equal then sort on call
 		return true;
 	} else {
@@ -63,12 +167,17 @@ record& record::operator= (const record& rhs) {
 		// copy over member variables
 		this->is_header_ = rhs.is_header_;
 		this->header_comment_ = rhs.header_comment_;
+		this->cached_ = 0;
 		// Copy over the mapped items
 		for (auto iter = rhs.begin(); iter != rhs.end(); iter++) {
 			std::string field = iter->first;
 			std::string value = iter->second;
 			item(field, value, false, false);
 		}
+		// Any fields not yet decoded are copied as ADIF text
+		raw_buffer_ = rhs.raw_buffer_;
+		raw_text_ = rhs.raw_text_;
+		raw_length_ = rhs.raw_length_;
 	}
 	return *this;
 }
@@ -78,6 +187,22 @@ record::~record() {
 	delete_contents();
 }
 
+// Allocate from the pool - anything other than a record uses the general allocator
+void* record::operator new(size_t size) {
+	if (size != sizeof(record)) return ::operator new(size);
+	return record_pool::pool().allocate();
+}
+
+// Return to the pool
+void record::operator delete(void* p, size_t size) {
+	if (p == nullptr) return;
+	if (size != sizeof(record)) {
+		::operator delete(p);
+		return;
+	}
+	record_pool::pool().release(p);
+}
+
 // Delete all the contents
 void record::delete_contents() {
 	is_header_ = false;
@@ -89,25 +214,29 @@ void record::delete_contents() {
 
 // Set an item pair.
 void record::item(std::string field, std::string value, bool formatted/* = false*/, bool dirty /*=true*/) {
+	// Decode any remaining fields so that they are not later overwritten by the original values
+	if (raw_text_) expand();
+	// Look the field up once
+	field_id_t id = field_registry::id(field);
+	field_desc_t desc = descriptor(id, field);
 	// Check we are not deleting an important field - crash the program if this was unintentional
-	char message[256];
-	snprintf(message, 256, "You are deleting %s, are you sure", field.c_str());
-	if (!value.length() && 
-		(field == "CALL" || field == "QSO_DATE" || field == "QSO_DATE_OFF" || field == "TIME_ON" ||
-		field == "TIME_OFF") &&
-		item(field).length() && item("QSO_COMPLETE") == "" &&
-		fl_choice(message, "Yes", "No", nullptr) == 1) {
+	if (!value.length() && (desc.flags & FD_CONFIRM_DELETE) && policy_ != nullptr &&
+		item(id).length() && item(FI_QSO_COMPLETE) == "" &&
+		!policy_->allow_delete(this, field)) {
+		char message[256];
 		snprintf(message, 256, "Unexpected deletion of the field, %s", field.c_str());
 		status_->misc_status(ST_FATAL, message);
 		return;
 	}
+	invalidate(id);
 	// Otherwise if writing to "", erase the item
 	if (!value.length()) {
 		// SEt dirty flag if contents are changing
 		if (dirty) {
 			std::string orig_value;
-			if (find(field) != end()) {
-				orig_value = at(field);
+			auto it = find(id);
+			if (it != end()) {
+				orig_value = it->second;
 			}
 			else {
 				orig_value = "";
@@ -118,69 +247,16 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 				book_->add_dirty_record(this, msg);
 			}
 		}
-		erase(field);
+		{
+			std::unique_lock<std::mutex> lock(write_mutex_, std::defer_lock);
+			if (lock_writes_) lock.lock();
+			erase(id);
+		}
 		if (field == "QSO_DATE" || field == "TIME_ON") 
 		return;
 	}
-	// Certain fields - always log in upper case
-	std::string upper_value;
-	if (field == "CALL" ||
-		field == "CONT" ||
-		field == "MY_CALL" ||
-		field == "GRIDSQUARE" ||
-		field == "MY_GRIDSQUARE" ||
-		field == "OPERATOR" ||
-		field == "OWNER_CALLSIGN" ||
-		field == "STATION_CALLSIGN" ||
-		field == "IOTA" ||
-		field == "MY_IOTA" ||
-		field == "COUNTRY" ||
-		field == "MY_COUNTRY" ||
-		field == "APP_ZZA_PFX") {
-		// Force upper case for these fields
-		upper_value = to_upper(value);
-	}
-	else {
-		if (field[0] == '!') {
-			// Special field names used for temporary values
-			upper_value = value;
-		}
-		else {
-			// Get the type of data. Different processing for different types
-			std::string datatype = spec_data_->datatype(field);
-			if (datatype == "PositiveInteger") {
-				// Always strip off leading zeros
-				size_t dummy;
-				int int_value;
-				try {
-					int_value = std::stoi(value, &dummy);
-					if (dummy == value.length()) {
-						// The whole std::string is an integer - convert it back to std::string
-						upper_value = std::to_string(int_value);
-					}
-					else {
-						// Use the original std::string
-						upper_value = value;
-					}
-				}
-				catch (std::invalid_argument&) {
-					// Empty std::string, so use that
-					upper_value = value;
-				}
-			}
-			else if (datatype == "Enumeration" && field != "BAND" && field != "BAND_RX") {
-				// Treat all enumerations as upper case. ADIF can accept either
-				upper_value = to_upper(value);
-			}
-			else if (datatype == "Date") {
-				// Do not convert to upper case to preserve lower-case month names
-				upper_value = value;
-			} else {
-				// Default leave as is
-				upper_value = value;
-			}
-		}
-	}
+	// Convert the value as the field needs - e.g. some fields are always logged in upper case
+	std::string upper_value = desc.normalise(value);
 	std::string formatted_value;
 	if (formatted) {
 		// Convert from the displayed format to ADIF format
@@ -189,23 +265,20 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 			formatted_value = "";
 		}
 		else {
-			char type_indicator = spec_data_->datatype_indicator(field);
 			double as_d = 0.0;
 			int as_i = 0;
 			char c;
-			switch (type_indicator) {
+			switch (desc.type_indicator) {
 			case 'N':
 			case 'S':
 			case 'I':
 			case 'M': 
 			case 'G':
 			case 'B':
-				if (field == "GRIDSQUARE" || field == "MY_GRIDSQUARE") {
-					if (upper_value.length() > 8) {
-						// GRIDSQUARE limited to first 8 characters
-						item(field + "_EXT", upper_value.substr(8), formatted);
-						formatted_value = upper_value.substr(0, 8);
-					}
+				if ((desc.flags & FD_GRIDSQUARE) && upper_value.length() > 8) {
+					// GRIDSQUARE limited to first 8 characters
+					item(field + "_EXT", upper_value.substr(8), formatted);
+					formatted_value = upper_value.substr(0, 8);
 				}
 				else {
 					// No formatting
@@ -215,7 +288,7 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 			case 'E':
 				// Enumeration: convert to uppercase
 				formatted_value = to_upper(upper_value);
-				if (field == "MODE") {
+				if (desc.flags & FD_MODE) {
 					if (spec_data_->is_submode(formatted_value)) {
 						// Set submode to this value and the mode to its parent mode
 						item("SUBMODE", formatted_value, formatted);
@@ -233,7 +306,7 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 				if (as_d < 0.0) {
 					// Negative - West for LON, South for LAT. Covert degrees to positive number
 					as_d = -as_d;
-					if (field == "LON" || field == "MY_LON") {
+					if (desc.flags & FD_LONGITUDE) {
 						c = 'W';
 					}
 					else {
@@ -242,7 +315,7 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 				}
 				else {
 					// Positive - East for LON, North for LAT
-					if (field == "LON" || field == "MY_LON") {
+					if (desc.flags & FD_LONGITUDE) {
 						c = 'E';
 					}
 					else {
@@ -258,6 +331,7 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 				char as_s[12];
 				snprintf(as_s, 12, "%c%03d %2.3f", c, as_i, as_d);
 				formatted_value = as_s;
+				break;
 			default:
 				formatted_value = upper_value;
 				break;
@@ -271,8 +345,9 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 	// SEt dirty flag if contents are changing
 	if (dirty) {
 		std::string orig_value;
-		if (find(field) != end()) {
-			orig_value = at(field);
+		auto it = find(id);
+		if (it != end()) {
+			orig_value = it->second;
 		}
 		else {
 			orig_value = "";
@@ -283,10 +358,14 @@ void record::item(std::string field, std::string value, bool formatted/* = false
 			book_->add_dirty_record(this, msg);
 		}
 	}
-	// Set in item
-	(*this)[field] = formatted_value;
-	if (field == "TIME_ON" || field == "QSO_DATE")
-		set_timestamp();
+	// Set in item - and the timestamp with it so that a save never sees one without the other
+	{
+		std::unique_lock<std::mutex> lock(write_mutex_, std::defer_lock);
+		if (lock_writes_) lock.lock();
+		set(id, formatted_value);
+		if (id == FI_TIME_ON || id == FI_QSO_DATE)
+			set_timestamp();
+	}
 }
 
 // Get an item - as std::string
@@ -357,22 +436,42 @@ std::string record::item(std::string field, bool formatted/* = false*/) {
 		}
 	}
 	else {
-		// Use the field directly
-		auto it = find(field);
-		if (it == end()) {
-			// Field not present return empty std::string
+		// Use the field directly - a field not yet seen can only be in the text not yet decoded
+		field_id_t id = field_registry::find(field);
+		if (id == FI_NONE && raw_text_) {
+			expand();
+			id = field_registry::find(field);
+		}
+		if (id == FI_NONE) {
 			result = "";
 		}
 		else {
-			// Return field value
-			result = it->second;
+			result = item(id);
 		}
 	}
 	return result;
 }
 
+// Get an item by its identifier - as std::string
+std::string record::item(field_id_t field, bool formatted/* = false*/) {
+	if (formatted) {
+		return item(field_registry::name(field), true);
+	}
+	if (raw_text_ && !decoded_on_load(field)) expand();
+	auto it = find(field);
+	if (it == end()) {
+		return "";
+	}
+	return it->second;
+}
+
 // get an item - as an integer, default 0
 void record::item(std::string field, int& value) {
+	// DXCC is cached
+	if (field == "DXCC") {
+		value = dxcc();
+		return;
+	}
 	if (item_exists(field)) {
 		try {
 			// Return integer value
@@ -409,6 +508,11 @@ void record::item(std::string field, unsigned long long& value) {
 
 // get an item - as a double, default "not-a-number"
 void record::item(std::string field, double& value) {
+	// FREQ and FREQ_RX are cached
+	if (field == "FREQ" || field == "FREQ_RX") {
+		value = freq(field == "FREQ_RX");
+		return;
+	}
 	if (item_exists(field)) {
 		try {
 			// return double value
@@ -454,7 +558,16 @@ bool record::is_valid() {
 
 // does the item exist - in the std::map and not an empty std::string
 bool record::item_exists(std::string field) {
-	return find(field) != end() && at(field) != "";
+	if (raw_text_ && !decoded_on_load(field)) expand();
+	auto it = find(field);
+	return it != end() && it->second != "";
+}
+
+// does the item exist - by its identifier
+bool record::item_exists(field_id_t field) {
+	if (raw_text_ && !decoded_on_load(field)) expand();
+	auto it = find(field);
+	return it != end() && it->second != "";
 }
 
 // std::set the header information
@@ -503,6 +616,12 @@ lat_long_t record::location(bool my_station) {
 
 // Return longitude and latitude from the record
 lat_long_t record::location(bool my_station, location_t& source) {
+	// Use the location worked out before if the fields have not changed since
+	uchar cache = my_station ? CV_MY_LOCATION : CV_LOCATION;
+	if (cached_ & cache) {
+		source = location_source_[my_station];
+		return location_[my_station];
+	}
 	// Set a bad coordinate
 	lat_long_t lat_long = { nan(""), nan("") };
 
@@ -581,6 +700,10 @@ lat_long_t record::location(bool my_station, location_t& source) {
 	else {
 		source = LOC_LATLONG;
 	}
+	// Keep it - the prefix location was returned above as it depends on more than this record
+	location_[my_station] = lat_long;
+	location_source_[my_station] = source;
+	cached_ |= cache;
 	return lat_long;
 }
 
@@ -631,6 +754,7 @@ bool record::merge_records(record* merge_record, match_flags_t flags, hint_t* re
 	bool merged = false;
 	bool bearing_change = false;
 	// For each field in other merge_record
+	merge_record->expand();
 	for (auto it = merge_record->begin(); it != merge_record->end(); it++) {
 		std::string field_name = it->first;
 		std::string merge_data = it->second;
@@ -827,6 +951,7 @@ match_result_t record::match_records(record* record) {
 	bool swl_match = true;
 	bool call_match = true;
 	// For each field in this record
+	expand();
 	for (auto it = begin(); it != end(); it++) {
 		std::string field_name = it->first;
 		std::string value = it->second;
@@ -911,8 +1036,8 @@ match_result_t record::match_records(record* record) {
 			(that_off >= this_on && that_off <= this_off) ||			
 			(this_on >= that_on && this_on <= that_off) ||
 			(this_off >= that_on && this_off <= that_off);
-		bool is_swl = (item("SWL") == "Y");
-		bool other_swl = (record->item("SWL") == "Y");
+		bool is_swl = (item(FI_SWL) == "Y");
+		bool other_swl = (record->item(FI_SWL) == "Y");
 		// Both records are SWL and match
 		if (is_swl && other_swl && swl_match && overlap) {
 			return MT_2XSWL_MATCH;
@@ -952,6 +1077,15 @@ match_result_t record::match_records(record* record) {
 
 // compare the item between this record and supplied record
 bool record::items_match(record* record, std::string field_name) {
+	// Equal values of a pooled field are the same copy - so compare the copies first
+	field_id_t id = field_registry::find(field_name);
+	if (id != FI_NONE && field_registry::pooled(id)) {
+		if (!decoded_on_load(id)) {
+			expand();
+			record->expand();
+		}
+		if (same_value(id, *record)) return true;
+	}
 	std::string lhs = item(field_name);
 	std::string rhs = record->item(field_name);
 	// Convert both fields to upper case
@@ -1053,86 +1187,42 @@ std::chrono::system_clock::time_point record::ctimestamp(bool time_off) {
 
 // get the date and time as a time_t object
 time_t record::timestamp(bool time_off /*= false*/, bool force /*=false*/) {
-	try {
-		// Convert date and time to a tm struct
-		tm qso_time;
-		if (time_off) {
-			if (item("TIME_OFF").length()) {
-				// Get end timestamp
-				if (item_exists("QSO_DATE_OFF")) {
-					// Use QSO_DATE_OFF if it exists
-					qso_time.tm_year = std::stoi(item("QSO_DATE_OFF").substr(0, 4)) - 1900;
-					qso_time.tm_mon = std::stoi(item("QSO_DATE_OFF").substr(4, 2)) - 1;
-					qso_time.tm_mday = std::stoi(item("QSO_DATE_OFF").substr(6, 2));
-				}
-				else {
-					// Use QSO_DATE if it doesn't
-					qso_time.tm_year = std::stoi(item("QSO_DATE").substr(0, 4)) - 1900;
-					qso_time.tm_mon = std::stoi(item("QSO_DATE").substr(4, 2)) - 1;
-					qso_time.tm_mday = std::stoi(item("QSO_DATE").substr(6, 2));
-					if (item("TIME_ON") > item("TIME_OFF")) {
-						// QSO_DATE_OFF show be inferred to be the day after - increment date
-						if (qso_time.tm_mday > days_in_month(&qso_time)) {
-							qso_time.tm_mday = 1;
-							if (qso_time.tm_mon == 11) {
-								qso_time.tm_mon = 0;
-								qso_time.tm_year += 1;
-							}
-							else {
-								qso_time.tm_mon += 1;
-							}
-						}
-						else {
-							qso_time.tm_mday += 1;
-						}
-					}
-				}
+	if (time_off) {
+		// Use the end timestamp worked out before if the fields have not changed since
+		if (!force && (cached_ & CV_TIME_OFF)) {
+			return timestamp_off_;
+		}
+		std::string off_time = item(FI_TIME_OFF);
+		if (off_time.length()) {
+			// Get end timestamp
+			if (item_exists(FI_QSO_DATE_OFF)) {
+				// Use QSO_DATE_OFF if it exists
+				timestamp_off_ = adif_to_time(item(FI_QSO_DATE_OFF), off_time);
 			}
 			else {
-				// Assume QSO is 10 minutes long
-				// Check this is 10 mins
-				std::chrono::system_clock::time_point time_on = std::chrono::system_clock::from_time_t(timestamp());
-				std::chrono::seconds ten_minutes(600);
-				time_t time_off = std::chrono::system_clock::to_time_t(time_on + ten_minutes);
-				return time_off;
-			}
-			// Add time on
-			qso_time.tm_hour = std::stoi(item("TIME_OFF").substr(0, 2));
-			qso_time.tm_min = std::stoi(item("TIME_OFF").substr(2, 2));
-			qso_time.tm_sec = 0;
-			if (item("TIME_OFF").length() == 6) {
-				qso_time.tm_sec = std::stoi(item("TIME_OFF").substr(4, 2));
-			}
-			qso_time.tm_isdst = false;
-
-			return mktime(&qso_time);
-		}
-		else { 
-			if (force) {
-				// Get start timestamp
-				qso_time.tm_year = std::stoi(item("QSO_DATE").substr(0, 4)) - 1900;
-				qso_time.tm_mon = std::stoi(item("QSO_DATE").substr(4, 2)) - 1;
-				qso_time.tm_mday = std::stoi(item("QSO_DATE").substr(6, 2));
-				qso_time.tm_hour = std::stoi(item("TIME_ON").substr(0, 2));
-				qso_time.tm_min = std::stoi(item("TIME_ON").substr(2, 2));
-				qso_time.tm_sec = 0;
-				if (item("TIME_ON").length() == 6) {
-					qso_time.tm_sec = std::stoi(item("TIME_ON").substr(4, 2));
+				// Use QSO_DATE if it doesn't
+				timestamp_off_ = adif_to_time(item(FI_QSO_DATE), off_time);
+				if (timestamp_off_ != -1 && item(FI_TIME_ON) > off_time) {
+					// QSO_DATE_OFF should be inferred to be the day after
+					timestamp_off_ += 24 * 60 * 60;
 				}
-				// To stop it getting randomly std::set in implementations that do not consistently initialise structures
-				qso_time.tm_isdst = false;
-
-				return mktime(&qso_time);
 			}
-			else {
-
-				return timestamp_;
-			}
-		} 
+		}
+		else {
+			// Assume QSO is 10 minutes long
+			std::chrono::system_clock::time_point time_on = std::chrono::system_clock::from_time_t(timestamp());
+			std::chrono::seconds ten_minutes(600);
+			timestamp_off_ = std::chrono::system_clock::to_time_t(time_on + ten_minutes);
+		}
+		cached_ |= CV_TIME_OFF;
+		return timestamp_off_;
 	}
-	catch (std::invalid_argument&) {
-		// Return an invalid time
-		return time_t(-1);
+	else if (force) {
+		// Get start timestamp - the fields are UTC
+		return adif_to_time(item(FI_QSO_DATE), item(FI_TIME_ON));
+	}
+	else {
+		return timestamp_;
 	}
 }
 
@@ -1141,6 +1231,73 @@ void record::set_timestamp() {
 	timestamp_ = timestamp(false, true);
 }
 
+// Get FREQ or FREQ_RX as a number - worked out when first asked for
+double record::freq(bool rx /*= false*/) {
+	uchar cache = rx ? CV_FREQ_RX : CV_FREQ;
+	double& value = rx ? freq_rx_ : freq_;
+	if (!(cached_ & cache)) {
+		std::string text = rx ? item("FREQ_RX") : item(FI_FREQ);
+		try {
+			value = text.length() ? std::stod(text) : nan("");
+		}
+		catch (std::invalid_argument&) {
+			value = nan("");
+		}
+		cached_ |= cache;
+	}
+	return value;
+}
+
+// Get DXCC as a number - worked out when first asked for
+int record::dxcc() {
+	if (!(cached_ & CV_DXCC)) {
+		std::string text = item(FI_DXCC);
+		try {
+			dxcc_ = text.length() ? std::stoi(text) : 0;
+		}
+		catch (std::invalid_argument&) {
+			dxcc_ = 0;
+		}
+		cached_ |= CV_DXCC;
+	}
+	return dxcc_;
+}
+
+// Forget the values derived from the field
+void record::invalidate(field_id_t field) {
+	static const field_id_t FREQ_RX = field_registry::id("FREQ_RX");
+	static const field_id_t LAT = field_registry::id("LAT");
+	static const field_id_t LON = field_registry::id("LON");
+	static const field_id_t MY_LAT = field_registry::id("MY_LAT");
+	static const field_id_t MY_LON = field_registry::id("MY_LON");
+	if (cached_ == 0) return;
+	switch (field) {
+	case FI_QSO_DATE:
+	case FI_TIME_ON:
+	case FI_QSO_DATE_OFF:
+	case FI_TIME_OFF:
+		cached_ &= ~CV_TIME_OFF;
+		break;
+	case FI_FREQ:
+		cached_ &= ~CV_FREQ;
+		break;
+	case FI_GRIDSQUARE:
+		cached_ &= ~CV_LOCATION;
+		break;
+	case FI_MY_GRIDSQUARE:
+		cached_ &= ~CV_MY_LOCATION;
+		break;
+	case FI_DXCC:
+		cached_ &= ~CV_DXCC;
+		break;
+	default:
+		if (field == FREQ_RX) cached_ &= ~CV_FREQ_RX;
+		else if (field == LAT || field == LON) cached_ &= ~CV_LOCATION;
+		else if (field == MY_LAT || field == MY_LON) cached_ &= ~CV_MY_LOCATION;
+		break;
+	}
+}
+
 // Update the time the QSO finishes
 void record::update_timeoff() {
 	if (!is_header_ && item("TIME_OFF").length() == 0) {
@@ -1149,12 +1306,9 @@ void record::update_timeoff() {
 		std::chrono::system_clock::time_point time_on = std::chrono::system_clock::from_time_t(timestamp());
 		std::chrono::seconds ten_seconds(10);
 		time_t time_off = std::chrono::system_clock::to_time_t(time_on + ten_seconds);
-		char temp[10];
 		// Convert to date YYYYMMDD and time HHMMSS and update record
-		strftime(temp, sizeof(temp), "%Y%m%d", gmtime(&time_off));
-		item("QSO_DATE_OFF", std::string(temp));
-		strftime(temp, sizeof(temp), "%H%M%S", gmtime(&time_off));
-		item("TIME_OFF", std::string(temp));
+		item("QSO_DATE_OFF", adif_date(time_off));
+		item("TIME_OFF", adif_time(time_off));
 	}
 }
 
@@ -1197,4 +1351,163 @@ void record::invalidate_qsl_status() {
 	if (item("CLUBLOG_QSO_UPLOAD_STATUS") == "Y") {
 		item("CLUBLOG_QSO_UPLOAD_STATUS", std::string("M"));
 	}
-}
\ No newline at end of file
+}
+
+// Keep the ADIF text for the fields not yet decoded
+void record::raw_text(std::shared_ptr<const std::string> buffer, const char* text, size_t length) {
+	raw_buffer_ = buffer;
+	raw_text_ = text;
+	raw_length_ = length;
+}
+
+// Some fields have not yet been decoded
+bool record::is_lazy() const {
+	return raw_text_ != nullptr;
+}
+
+// Decode the remaining fields from the ADIF text
+void record::expand(bool report /*= true*/) {
+	if (raw_text_ == nullptr) return;
+	// Decode the whole record into a separate record and add those fields not already decoded
+	record full;
+	adi_reader reader;
+	reader.expand_record(&full, raw_text_, raw_length_, report);
+	std::unique_lock<std::mutex> lock(write_mutex_, std::defer_lock);
+	if (lock_writes_) lock.lock();
+	for (auto it = full.begin(); it != full.end(); it++) {
+		emplace(it->id, it->second);
+	}
+	raw_text_ = nullptr;
+	raw_length_ = 0;
+	raw_buffer_.reset();
+}
+
+// Convert the values stored as read to the form item() holds them in
+void record::normalise() {
+	std::vector<std::pair<field_id_t, std::string> > changes;
+	for (auto it = begin(); it != end(); it++) {
+		std::string value = descriptor(it->id, it->first).normalise(it->second);
+		if (value != it->second) changes.emplace_back(it->id, value);
+	}
+	std::unique_lock<std::mutex> lock(write_mutex_, std::defer_lock);
+	if (lock_writes_) lock.lock();
+	for (auto& change : changes) {
+		invalidate(change.first);
+		set(change.first, change.second);
+	}
+	set_timestamp();
+}
+
+// Copy the record without decoding any fields
+void record::lazy_copy(record& copy) const {
+	static_cast<field_map&>(copy) = *this;
+	copy.is_header_ = is_header_;
+	copy.header_comment_ = header_comment_;
+	copy.timestamp_ = timestamp_;
+	copy.id_ = id_;
+	copy.raw_buffer_ = raw_buffer_;
+	copy.raw_text_ = raw_text_;
+	copy.raw_length_ = raw_length_;
+}
+
+// Return the record with all fields decoded - decoding into a copy if necessary
+record* record::decoded(record& copy) {
+	if (raw_text_ == nullptr) return this;
+	lazy_copy(copy);
+	copy.expand(false);
+	return &copy;
+}
+
+// Copy the record for another thread to read
+std::unique_ptr<record> record::snapshot() const {
+	std::unique_ptr<record> copy(new record);
+	lazy_copy(*copy);
+	copy->expand(false);
+	return copy;
+}
+
+// The field is decoded when the main log is read
+bool record::decoded_on_load(const std::string& field) {
+	// All application-defined fields are decoded so that those ignored are reported once on load
+	return field_registry::find(field) <= FI_MY_IOTA || field.compare(0, 4, "APP_") == 0;
+}
+
+// The field is decoded when the main log is read
+bool record::decoded_on_load(field_id_t field) {
+	return field <= FI_MY_IOTA || (field != FI_NONE && field_registry::name(field).compare(0, 4, "APP_") == 0);
+}
+
+// Get the descriptor of the field - working it out if it is not in the table
+field_desc_t record::descriptor(field_id_t id, const std::string& field) {
+	std::shared_ptr<const std::vector<field_desc_t> > table = std::atomic_load(&descriptors_);
+	if (table && id < table->size() && (*table)[id].normalise != nullptr) {
+		return (*table)[id];
+	}
+	return describe(field);
+}
+
+// Work out how the field is treated
+field_desc_t record::describe(const std::string& field) {
+	field_desc_t desc = { normalise_none, '\0', FD_NONE };
+	if (field.empty() || field[0] == '!') {
+		// Special field names used for temporary values
+		return desc;
+	}
+	std::string name = field;
+	desc.type_indicator = spec_data_ ? spec_data_->datatype_indicator(name) : '\0';
+	if (UPPER_CASE_FIELDS.find(field) != UPPER_CASE_FIELDS.end()) {
+		// Force upper case for these fields
+		desc.normalise = normalise_upper;
+	}
+	else if (desc.type_indicator != '\0') {
+		// Get the type of data. Different processing for different types
+		std::string datatype = spec_data_->datatype(field);
+		if (datatype == "PositiveInteger") {
+			// Always strip off leading zeros
+			desc.normalise = normalise_positive_integer;
+		}
+		else if (datatype == "Enumeration" && field != "BAND" && field != "BAND_RX") {
+			// Treat all enumerations as upper case. ADIF can accept either
+			desc.normalise = normalise_upper;
+		}
+	}
+	if (CONFIRM_DELETE_FIELDS.find(field) != CONFIRM_DELETE_FIELDS.end()) desc.flags |= FD_CONFIRM_DELETE;
+	if (field == "GRIDSQUARE" || field == "MY_GRIDSQUARE") desc.flags |= FD_GRIDSQUARE;
+	if (field == "LON" || field == "MY_LON") desc.flags |= FD_LONGITUDE;
+	if (field == "MODE") desc.flags |= FD_MODE;
+	return desc;
+}
+
+// Work out the descriptors of all the fields in the specification
+void record::describe_fields() {
+	std::vector<field_desc_t>* table = new std::vector<field_desc_t>;
+	auto add = [&](const std::string& field) {
+		field_id_t id = field_registry::id(field);
+		if (id == FI_NONE) return;
+		if (id >= table->size()) table->resize(id + 1, field_desc_t{ nullptr, '\0', FD_NONE });
+		(*table)[id] = describe(field);
+	};
+	spec_dataset* fields = spec_data_->dataset("Fields");
+	if (fields) {
+		for (auto& it : fields->data) add(it.first);
+	}
+	for (auto& field : UPPER_CASE_FIELDS) add(field);
+	// Readers on other threads keep the table they have
+	std::atomic_store(&descriptors_, std::shared_ptr<const std::vector<field_desc_t> >(table));
+}
+
+// Set the policy for this thread
+void record::policy(item_policy* policy) {
+	policy_ = policy;
+}
+
+// Get the policy for this thread
+item_policy* record::policy() {
+	return policy_;
+}
+
+// The policy that asks the user
+item_policy* record::ask_user() {
+	static ask_user_policy policy;
+	return &policy;
+}
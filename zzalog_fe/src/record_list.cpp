@@ -0,0 +1,149 @@
+#include "record_list.h"
+
+#include "record.h"
+
+// Constructor - no chunks
+record_list::record_list() :
+	starts_(1, 0)
+{
+}
+
+// Get the record - checking that it exists
+record_list::reference record_list::at(size_t pos) {
+	if (pos >= size()) throw std::out_of_range("record_list::at");
+	return *locate<false>(pos);
+}
+
+// Get the record - checking that it exists
+record_list::const_reference record_list::at(size_t pos) const {
+	if (pos >= size()) throw std::out_of_range("record_list::at");
+	return *locate<true>(pos);
+}
+
+// Insert the record - splitting the chunk if it is full
+record_list::iterator record_list::insert(const_iterator pos, record* qso) {
+	size_t index = pos.index();
+	if (chunks_.empty()) {
+		add_chunk(0, std::vector<record*>(1, qso));
+		starts_.push_back(1);
+		return begin();
+	}
+	// At the end add to the last chunk
+	size_t chunk = pos.chunk_;
+	size_t offset = pos.offset_;
+	if (chunk == chunks_.size()) {
+		chunk--;
+		offset = chunks_[chunk].size();
+	}
+	std::vector<record*>& records = chunks_[chunk];
+	records.insert(records.begin() + offset, qso);
+	id_labels_[qso->id()] = labels_[chunk];
+	move_starts(chunk, 1);
+	if (records.size() > CHUNK_MAX) {
+		// Move the second half into a new chunk
+		size_t half = records.size() / 2;
+		std::vector<record*> upper(records.begin() + half, records.end());
+		records.resize(half);
+		add_chunk(chunk + 1, std::move(upper));
+		starts_.insert(starts_.begin() + chunk + 1, starts_[chunk] + half);
+	}
+	return locate<false>(index);
+}
+
+// Remove the record - and its chunk if that is now empty
+record_list::iterator record_list::erase(const_iterator pos) {
+	size_t index = pos.index();
+	std::vector<record*>& records = chunks_[pos.chunk_];
+	auto it_id = id_labels_.find(records[pos.offset_]->id());
+	if (it_id != id_labels_.end() && it_id->second == labels_[pos.chunk_]) id_labels_.erase(it_id);
+	records.erase(records.begin() + pos.offset_);
+	move_starts(pos.chunk_, -1);
+	if (records.empty()) {
+		remove_chunk(pos.chunk_);
+	}
+	return locate<false>(index);
+}
+
+// Append the record - starting a new chunk if the last is full
+void record_list::push_back(record* qso) {
+	if (chunks_.empty() || chunks_.back().size() >= CHUNK_MAX) {
+		std::vector<record*> records;
+		records.reserve(CHUNK_MAX);
+		records.push_back(qso);
+		add_chunk(chunks_.size(), std::move(records));
+		starts_.push_back(starts_.back() + 1);
+		return;
+	}
+	chunks_.back().push_back(qso);
+	starts_.back()++;
+	id_labels_[qso->id()] = labels_.back();
+}
+
+// Remove all records
+void record_list::clear() {
+	chunks_.clear();
+	starts_.assign(1, 0);
+	labels_.clear();
+	chunk_of_label_.clear();
+	id_labels_.clear();
+}
+
+// Exchange the records with the vector
+void record_list::swap(std::vector<record*>& records) {
+	std::vector<record*> previous(begin(), end());
+	clear();
+	id_labels_.reserve(records.size());
+	// Leave room in each chunk for later inserts
+	for (size_t ix = 0; ix < records.size(); ix += CHUNK_FILL) {
+		size_t last = std::min(ix + CHUNK_FILL, records.size());
+		add_chunk(chunks_.size(), std::vector<record*>(records.begin() + ix, records.begin() + last));
+		starts_.push_back(last);
+	}
+	records.swap(previous);
+}
+
+// Find the record from the chunk that holds it
+size_t record_list::find_id(qso_id_t id) const {
+	auto it = id_labels_.find(id);
+	if (it == id_labels_.end()) return (size_t)-1;
+	size_t chunk = chunk_of_label_[it->second];
+	const std::vector<record*>& records = chunks_[chunk];
+	for (size_t offset = 0; offset < records.size(); offset++) {
+		if (records[offset]->id() == id) return starts_[chunk] + offset;
+	}
+	return (size_t)-1;
+}
+
+// Move the starts of the later chunks
+void record_list::move_starts(size_t chunk, std::ptrdiff_t count) {
+	for (size_t ix = chunk + 1; ix < starts_.size(); ix++) {
+		starts_[ix] += count;
+	}
+}
+
+// Add the chunk - the records are indexed by its new label: the caller adds its start
+void record_list::add_chunk(size_t chunk, std::vector<record*>&& records) {
+	uint32_t label = (uint32_t)chunk_of_label_.size();
+	chunk_of_label_.push_back(chunk);
+	for (auto qso : records) {
+		id_labels_[qso->id()] = label;
+	}
+	chunks_.insert(chunks_.begin() + chunk, std::move(records));
+	labels_.insert(labels_.begin() + chunk, label);
+	renumber(chunk + 1);
+}
+
+// Remove the chunk
+void record_list::remove_chunk(size_t chunk) {
+	chunks_.erase(chunks_.begin() + chunk);
+	starts_.erase(starts_.begin() + chunk);
+	labels_.erase(labels_.begin() + chunk);
+	renumber(chunk);
+}
+
+// The chunks have moved
+void record_list::renumber(size_t chunk) {
+	for (size_t ix = chunk; ix < labels_.size(); ix++) {
+		chunk_of_label_[labels_[ix]] = ix;
+	}
+}
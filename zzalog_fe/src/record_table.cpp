@@ -300,6 +300,7 @@ void record_table::assess_fields() {
 	// now add all the remaining fields from the log record
 	if (log_record_ != NULL) {
 		// For each field in the log record
+		log_record_->expand();
 		for (auto it = log_record_->begin(); it != log_record_->end(); it++) {
 			bool found = false;
 			// Compare against each field alteady selected
@@ -318,6 +319,7 @@ void record_table::assess_fields() {
 	// now add all the remaining fields from the query record
 	if (query_record_ != NULL) {
 		// For each field in the query record
+		query_record_->expand();
 		for (auto it = query_record_->begin(); it != query_record_->end(); it++) {
 			bool found = false;
 			// Compare against each field already selected
@@ -623,10 +623,15 @@ void report_tree::create_map() {
 	else {
 		selector_name = "";
 	}
+	// STATION_CALLSIGN values are pooled - so compare against the pooled copy
+	const std::string* station_value = value_pool::find(station_call_);
 	// For each record in the book
 	for (size_t i = 0; i < get_book()->size(); i++) {
 		record* record = get_book()->get_record(i, false);
-		if (!station_only || record->item("STATION_CALLSIGN") == station_call_) {
+		bool station_match = station_call_.empty() ?
+			!record->item_exists(FI_STATION_CALLSIGN) :
+			record->value_is(FI_STATION_CALLSIGN, station_value);
+		if (!station_only || station_match) {
 			if (filter_ != RF_SELECTED || record->item(field_name, true) == selector_name) {
 				// If it is in the domain of the analysis - add it to the std::map
 				add_record(i, &map_);
@@ -235,6 +235,16 @@ void spec_data::process_fieldnames() {
 			datatype_indicators_[it->first] = ' ';
 		}
 	}
+	// Give all the ADIF fields their identifiers now rather than as records use them
+	field_registry::add(field_names_);
+	// Enumerated fields have few different values - hold one copy of each
+	std::set<std::string> enumerated;
+	for (auto& it : datatype_indicators_) {
+		if (it.second == 'E') enumerated.insert(it.first);
+	}
+	field_registry::pool(enumerated);
+	// Work out how records treat each field
+	record::describe_fields();
 }
 
 // Get the DXCC award mode for a particulat ADIF mode
@@ -481,13 +491,17 @@ bool spec_data::add_userdef(int id, const std::string& name, char indicator, std
 	userdef_names_[id] = name;
 
 	field_names_.insert(userdef_name);
+	record::describe_fields();
 
 	return true;
 }
 
 // Get data type indicator for the field from the lookup table
 char spec_data::datatype_indicator(std::string& field_name) {
-	return datatype_indicators_[field_name];
+	// Do not add missing entries: this is called from the ADI reader worker threads
+	auto it = datatype_indicators_.find(field_name);
+	if (it == datatype_indicators_.end()) return '\0';
+	return it->second;
 }
 
 // Get std::list or range for the field
@@ -2014,11 +2028,8 @@ bool spec_data::auto_correction(valn_error_t error_code, const std::string&  dat
 			time_t new_off = std::chrono::system_clock::to_time_t(time_off + one_hour);
 			if (difftime(new_off, time_on) > 0.0) {
 				// Convert to date YYYYMMDD and time HHMMSS and update record
-				char temp[10];
-				strftime(temp, sizeof(temp), "%Y%m%d", gmtime(&new_off));
-				record_->item("QSO_DATE_OFF", std::string(temp));
-				strftime(temp, sizeof(temp), "%H%M%S", gmtime(&new_off));
-				record_->item("TIME_OFF", std::string(temp));
+				record_->item("QSO_DATE_OFF", adif_date(new_off));
+				record_->item("TIME_OFF", adif_time(new_off));
 				correction_message_ = field + "=" + display_item + "auto-corrected to " +
 					field + "=" + record_->item(field, true) + ".";
 				return true;
@@ -2096,6 +2107,7 @@ bool spec_data::validate(record* record, qso_num_t number)
 	record_ = record;
 	bool error = false;
 	// Validate all fields in record.
+	record_->expand();
 	for (auto it = record_->begin(); it != record_->end() && !abandon_validation_; it++) {
 		std::string field = it->first;
 		std::string data = it->second;
@@ -2290,6 +2302,10 @@ void spec_data::add_my_appdefs() {
 		"APP_ZZA_ECARD",
 		"APP_ZZA_EQSL_MSG",
 		"APP_ZZA_ERROR",
+		"APP_ZZA_JNL_ID",      // Identifies the record in the journal
+		"APP_ZZA_JNL_KEY",     // Journal entry: record as last saved
+		"APP_ZZA_JNL_MARK",    // Journal mark included in the log
+		"APP_ZZA_JNL_OP",      // Journal entry: operation
 		"APP_ZZA_MY_WAB",      // 
 		"APP_ZZA_NUMRECORDS",
 		"APP_ZZA_OP",
@@ -42,18 +42,18 @@ void status::progress(uint64_t max_value, object_t object, const char* descripti
 	// Initialise it
 	// Reset previous value as a new progress
 	// Start a new progress bar process - create the progress item (total expected count, objects being counted, up/down and what view it's for)
-	banner_->start_progress(max_value, object, description, suffix);
+	if (banner_) banner_->start_progress(max_value, object, description, suffix);
 }
 
 // Update progress to the new specified value
 void status::progress(uint64_t value, object_t object) {
 	// Update progress item
-	banner_->add_progress(value);
+	if (banner_) banner_->add_progress(value);
 }
 
 // Update progress with a message - e.g. cancel it and display why cancelled
 void status::progress(const char* message, object_t object) {
-	banner_->cancel_progress(message);
+	if (banner_) banner_->cancel_progress(message);
 }
 
 // Update miscellaneous status - std::set text and colour, log the status
@@ -64,7 +64,8 @@ void status::misc_status(status_t status, const char* label) {
 	// X YYYY/MM/DD HH:MM:SS Message 
 	// X is a single letter indicating the message severity
 	snprintf(f_message, sizeof(f_message), "%c %s %s\n", STATUS_CODES.at(status), timestamp.c_str(), label);
-	banner_->add_message(status, label);
+	if (banner_) banner_->add_message(status, label);
+	else printf("%s", f_message);
 
 	if (!report_file_) {
 		// Append the status to the file
@@ -85,7 +86,7 @@ void status::misc_status(status_t status, const char* label) {
 			delete report_file_;
 			report_file_ = nullptr;
 			file_unusable_ = true;
-			fl_alert("STATUS: Failed to open status report file %s", report_filename_.c_str());
+			if (banner_) fl_alert("STATUS: Failed to open status report file %s", report_filename_.c_str());
 		}
 	}
 	if (report_file_) {
@@ -94,6 +95,11 @@ void status::misc_status(status_t status, const char* label) {
 		report_file_->flush();
 	}
 
+	// Headless - nobody to ask, so stop on a fatal error
+	if (!banner_) {
+		if (status == ST_FATAL) closing_ = true;
+		return;
+	}
 	// Depending on the severity: LOG, NOTE, OK, WARNING, ERROR, SEVERE or FATAL
 	// Beep on the last three.
 	switch(status) {
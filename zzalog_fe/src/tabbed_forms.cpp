@@ -11,6 +11,7 @@
 #include "config.h"
 #include "qso_manager.h"
 #include "dxcc_view.h"
+#include "record.h"
 
 // Constructor
 tabbed_forms::tabbed_forms(int X, int Y, int W, int H, const char* label) :
@@ -18,6 +19,8 @@ tabbed_forms::tabbed_forms(int X, int Y, int W, int H, const char* label) :
 {	
 	handle_overflow(OVERFLOW_PULLDOWN);
 	forms_.clear();
+	last_qso_1_ = 0;
+	last_qso_2_ = 0;
 	// create the views -
 	// Full log view - displays selected items of all records
 	add_view<log_table>("Full log view", FO_MAINLOG, OT_MAIN, "Displays all log records");
@@ -78,6 +81,19 @@ void tabbed_forms::update_views(view* requester, hint_t hint, qso_num_t record_1
 		// Remeber the records to update non-visible views when they become visible
 		last_record_1_ = record_1;
 		last_record_2_ = record_2;
+		// Remember the QSOs by identifier as well - records may be inserted or deleted before
+		// a view not now visible is shown. The record_1 of an import query is in the import data.
+		switch (hint) {
+		case HT_IMPORT_QUERY:
+		case HT_IMPORT_QUERYNEW:
+		case HT_IMPORT_QUERYSWL:
+			last_qso_1_ = 0;
+			break;
+		default:
+			last_qso_1_ = qso_id(record_1);
+			break;
+		}
+		last_qso_2_ = qso_id(record_2);
 		last_hint_ = hint;
 		last_book_ = navigation_book_;
 		// Pass to each view in turn - note update() is a method in view.
@@ -111,6 +127,19 @@ void tabbed_forms::update_views(view* requester, hint_t hint, qso_num_t record_1
 	}
 }
 
+// The identifier of the QSO in the full log
+qso_id_t tabbed_forms::qso_id(qso_num_t record_num) {
+	record* qso = book_ ? book_->get_record(record_num, false) : nullptr;
+	return qso ? qso->id() : 0;
+}
+
+// The index of the remembered QSO in the full log now
+qso_num_t tabbed_forms::last_record(qso_id_t id, qso_num_t record_num) {
+	if (id == 0) return record_num;
+	qso_num_t current = book_->position(id);
+	return current == (qso_num_t)-1 ? record_num : current;
+}
+
 // Activate or deactivate the named object - if selecting another log_view change the navigation_book_
 void tabbed_forms::activate_pane(object_t pane, bool active) {
 	view* v = forms_[pane].v;
@@ -140,7 +169,7 @@ void tabbed_forms::activate_pane(object_t pane, bool active) {
 			break;
 		}
 		// Restore any query
-		v->update(last_hint_, last_record_1_, last_record_2_);
+		v->update(last_hint_, last_record(last_qso_1_, last_record_1_), last_record(last_qso_2_, last_record_2_));
 		g->redraw();
 		w->redraw();
 		Fl::check();
@@ -210,7 +239,8 @@ void tabbed_forms::cb_tab_change(Fl_Widget* w, void* v) {
 		}
 	}
 	view* as_view = dynamic_cast<view*>(((Fl_Group*)that->value())->child(0));
-	as_view->update(that->last_hint_, that->last_record_1_, that->last_record_2_);
+	as_view->update(that->last_hint_, that->last_record(that->last_qso_1_, that->last_record_1_),
+		that->last_record(that->last_qso_2_, that->last_record_2_));
 }
 
 // Minimum width resizing - sets to the largest minimum width of all the panes
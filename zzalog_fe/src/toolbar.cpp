@@ -20,6 +20,8 @@
 #include "drawing.h"
 #include "utils.h"
 
+#include <algorithm>
+
 #include <FL/Fl_Button.H>
 #include <FL/Fl_Help_Dialog.H>
 #include <FL/Fl_JPEG_Image.H>
@@ -419,18 +421,17 @@ void toolbar::cb_bn_search(Fl_Widget* w, void* v) {
 	bool found = false;
 	bool keep_on = true;
 	std::string search_call = to_upper(that->search_text_);
+	// The records with the callsign
+	std::vector<item_num_t> matches = navigation_book_->qsos_with_call(search_call);
 	while (keep_on) {
-		// For each record from the last search result until found
-		for (item_num_t i = that->record_num_; i < navigation_book_->size() && !found; i++) {
-			// Compare the callsign against the search input
-			record* record = navigation_book_->get_record(i, false);
-			if (record->item("CALL") == search_call) {
-				// select the record that was found
-				found = true;
-				navigation_book_->selection(i, HT_SELECTED);
-				// Remember the record found
-				that->record_num_ = i + 1;
-			}
+		// The first one from the last search result
+		auto it = std::lower_bound(matches.begin(), matches.end(), that->record_num_);
+		if (it != matches.end()) {
+			// select the record that was found
+			found = true;
+			navigation_book_->selection(*it, HT_SELECTED);
+			// Remember the record found
+			that->record_num_ = *it + 1;
 		}
 		if (!found) {
 			// Callsign not found
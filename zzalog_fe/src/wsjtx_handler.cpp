@@ -184,14 +184,9 @@ int wsjtx_handler::handle_decode(std::stringstream& ss) {
 	decode.low_confidence = get_bool(ss);
 	decode.off_air = get_bool(ss);
 	// display ID, time and message
-	double seconds = decode.time / 1000.0;
-	unsigned int minutes = (unsigned int)seconds / 60;
-	seconds = seconds - (minutes * 60.0);
-	unsigned int hours = minutes / 60;
-	minutes = minutes - (hours * 60);
-	char t[20];
-	snprintf(t, sizeof(t), "%02d%02d%02.0f", hours, minutes, seconds);
-	record* qso = update_qso(false, std::string(t), (double)decode.d_freq, decode.message);
+	// decode.time is milliseconds since midnight UTC
+	std::string t = adif_time((time_t)(decode.time / 1000));
+	record* qso = update_qso(false, t, (double)decode.d_freq, decode.message);
 	if (qso) qso_manager_->update_modem_qso(false);
 	return 0;
 }
@@ -210,14 +205,9 @@ int wsjtx_handler::handle_reply(std::stringstream& ss) {
 	decode.low_confidence = get_bool(ss);
 //	decode.off_air = get_bool(ss);
 	// display ID, time and message
-	double seconds = decode.time / 1000.0;
-	unsigned int minutes = (unsigned int)seconds / 60;
-	seconds = seconds - (minutes * 60.0);
-	unsigned int hours = minutes / 60;
-	minutes = minutes - (hours * 60);
-	char t[20];
-	snprintf(t, sizeof(t), "%02d%02d%02.0f", hours, minutes, seconds);
-	record* qso = update_qso(false, std::string(t), (double)decode.d_freq, decode.message);
+	// decode.time is milliseconds since midnight UTC
+	std::string t = adif_time((time_t)(decode.time / 1000));
+	record* qso = update_qso(false, t, (double)decode.d_freq, decode.message);
 	if (qso) qso_manager_->update_modem_qso(false);
 	return 0;
 }
@@ -499,7 +489,7 @@ record* wsjtx_handler::update_qso(bool tx, std::string time, double audio_freq,
 	decoded_msg decode = decode_message(message);
 	std::string sender = decode.sender[0] == '<' ? decode.sender.substr(1, decode.sender.length() - 2) : decode.sender;
 	std::string target = decode.target[0] == '<' ? decode.target.substr(1, decode.target.length() - 2) : decode.target;
-	std::string today = now(false, "%Y%m%d");
+	std::string today = adif_date(std::time(nullptr));
 	double df = dial == 0.0 ? dial_frequency_ : dial;
 	std::string m = mode == "" ? mode_ : mode;
 	char msg[100];
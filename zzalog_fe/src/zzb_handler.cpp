@@ -0,0 +1,411 @@
+#include "zzb_handler.h"
+
+#include "adi_reader.h"
+#include "adi_writer.h"
+#include "book.h"
+#include "main.h"
+#include "record.h"
+#include "spec_data.h"
+#include "status.h"
+
+#include "utils.h"
+
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include <FL/fl_utf8.h>
+
+// Identifies the file and its layout
+const char ZZB_MAGIC[4] = { 'Z', 'Z', 'B', '1' };
+// Changed whenever the layout changes
+const uint32_t ZZB_VERSION = 2;
+// Written in the machine's byte order - a snapshot from another machine is not used
+const uint32_t ZZB_BYTE_ORDER = 0x01020304;
+// Marks the end of a complete snapshot
+const uint32_t ZZB_END = 0x454E445A;
+
+// Constructor
+zzb_handler::zzb_handler()
+	: tables_("")
+{
+}
+
+// Destructor
+zzb_handler::~zzb_handler()
+{
+}
+
+// The snapshot is kept next to the log file
+std::string zzb_handler::filename(const std::string& log_filename) {
+	return log_filename + ".zzb";
+}
+
+// Remove the snapshot
+void zzb_handler::remove(const std::string& log_filename) {
+	fl_unlink(filename(log_filename).c_str());
+}
+
+// Index of the field name - add it if it is new
+uint32_t zzb_handler::field_id(const std::string& field) {
+	auto it = field_ids_.find(field);
+	if (it != field_ids_.end()) return it->second;
+	uint32_t id = (uint32_t)fields_.size();
+	fields_.push_back(field);
+	field_ids_[field] = id;
+	return id;
+}
+
+// Index of the value - add it if it is new
+uint32_t zzb_handler::string_id(const std::string& value) {
+	auto it = string_ids_.find(value);
+	if (it != string_ids_.end()) return it->second;
+	uint32_t id = (uint32_t)strings_.size();
+	strings_.push_back(value);
+	string_ids_[value] = id;
+	return id;
+}
+
+// Append a 32-bit integer
+void zzb_handler::put_int(std::string& out, uint32_t value) {
+	out.append((const char*)&value, sizeof(value));
+}
+
+// Append a 64-bit integer
+void zzb_handler::put_int64(std::string& out, int64_t value) {
+	out.append((const char*)&value, sizeof(value));
+}
+
+// Append the length and then the characters of the string
+void zzb_handler::put_string(std::string& out, const std::string& value) {
+	put_int(out, (uint32_t)value.length());
+	out.append(value);
+}
+
+// Read a 32-bit integer
+bool zzb_handler::get_int(const char*& pos, const char* end, uint32_t& value) {
+	if ((size_t)(end - pos) < sizeof(value)) return false;
+	memcpy(&value, pos, sizeof(value));
+	pos += sizeof(value);
+	return true;
+}
+
+// Read a 64-bit integer
+bool zzb_handler::get_int64(const char*& pos, const char* end, int64_t& value) {
+	if ((size_t)(end - pos) < sizeof(value)) return false;
+	memcpy(&value, pos, sizeof(value));
+	pos += sizeof(value);
+	return true;
+}
+
+// Read a counted string
+bool zzb_handler::get_string(const char*& pos, const char* end, std::string& value) {
+	uint32_t length;
+	if (!get_int(pos, end, length)) return false;
+	if ((size_t)(end - pos) < length) return false;
+	value.assign(pos, length);
+	pos += length;
+	return true;
+}
+
+// Size and modification time of the log file
+bool zzb_handler::file_stamp(const std::string& log_filename, int64_t& size, int64_t& time) {
+	std::error_code ec;
+	std::filesystem::path path = std::filesystem::u8path(log_filename);
+	size = (int64_t)std::filesystem::file_size(path, ec);
+	if (ec) return false;
+	time = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+	return !ec;
+}
+
+// The record timestamps are UTC: a snapshot written when they were local times matches only if that time zone was UTC
+int64_t zzb_handler::zone_stamp() {
+	return (int64_t)adif_to_time("20000101", "000000");
+}
+
+// Encode the worked-before tables - the values are added to the pool
+void zzb_handler::add_tables(book* b) {
+	tables_.clear();
+	auto put_set = [&](const auto& values) {
+		put_int(tables_, (uint32_t)values.size());
+		for (auto& value : values) {
+			put_int(tables_, string_id(value));
+		}
+	};
+	put_set(b->used_bands_);
+	put_set(b->used_modes_);
+	put_set(b->used_submodes_);
+	put_set(b->used_rigs_);
+	put_set(b->used_antennas_);
+	put_set(b->used_callsigns_);
+	// Each cell: station callsign, worked_t, entity and then the bands, modes and submodes
+	put_int(tables_, (uint32_t)b->use_cells_.size());
+	for (auto& cell : b->use_cells_) {
+		put_int(tables_, string_id(b->use_keys_[(uint32_t)(cell.first >> 40)]));
+		put_int(tables_, (uint32_t)((cell.first >> 32) & 0xFF));
+		put_int(tables_, string_id(b->use_keys_[(uint32_t)cell.first]));
+		put_set(cell.second.bands);
+		put_set(cell.second.modes);
+		put_set(cell.second.submodes);
+	}
+}
+
+// Write the snapshot to a temporary file and then replace any existing one
+bool zzb_handler::store_book(const std::string& log_filename, record* header, const std::vector<record*>& records) {
+	int64_t log_size;
+	int64_t log_time;
+	if (!file_stamp(log_filename, log_size, log_time)) return false;
+	// Encode the records first as this fills the pools
+	std::string data;
+	data.reserve(records.size() * 64);
+	put_int(data, (uint32_t)records.size());
+	for (auto qso : records) {
+		// A record with fields not yet decoded is copied and decoded after releasing the mutex
+		record copy;
+		record* full = qso;
+		std::unique_lock<std::mutex> lock(record::write_mutex_);
+		if (qso->is_lazy()) {
+			qso->lazy_copy(copy);
+			lock.unlock();
+			copy.expand(false);
+			full = &copy;
+		}
+		put_int64(data, (int64_t)full->timestamp_);
+		put_int(data, (uint32_t)full->size());
+		for (auto it : *full) {
+			put_int(data, field_id(it.first));
+			put_int(data, string_id(it.second));
+		}
+	}
+	std::string prefix;
+	prefix.append(ZZB_MAGIC, sizeof(ZZB_MAGIC));
+	put_int(prefix, ZZB_VERSION);
+	put_int(prefix, ZZB_BYTE_ORDER);
+	put_int64(prefix, log_size);
+	put_int64(prefix, log_time);
+	put_int64(prefix, zone_stamp());
+	// The header is kept as ADIF text so that user-defined fields are declared when it is read
+	std::ostringstream header_text;
+	if (header) adi_writer::to_adif(header, header_text, nullptr, false);
+	put_string(prefix, header_text.str());
+	put_int(prefix, (uint32_t)fields_.size());
+	for (auto& field : fields_) put_string(prefix, field);
+	put_int(prefix, (uint32_t)strings_.size());
+	for (auto& value : strings_) put_string(prefix, value);
+
+	std::string temp_file = filename(log_filename) + ".tmp";
+	std::ofstream out(temp_file.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	out.write(prefix.data(), prefix.length());
+	out.write(data.data(), data.length());
+	out.write(tables_.data(), tables_.length());
+	std::string trailer;
+	put_int(trailer, ZZB_END);
+	out.write(trailer.data(), trailer.length());
+	out.close();
+	if (out.fail()) {
+		fl_unlink(temp_file.c_str());
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(std::filesystem::u8path(temp_file), std::filesystem::u8path(filename(log_filename)), ec);
+	return !ec;
+}
+
+// Load the book from the snapshot if it matches the log file
+bool zzb_handler::load_book(book* b, const std::string& log_filename) {
+	int64_t log_size;
+	int64_t log_time;
+	if (!file_stamp(log_filename, log_size, log_time)) return false;
+	std::string zzb_filename = filename(log_filename);
+	std::ifstream in(zzb_filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if (!in.good()) return false;
+	std::string buffer;
+	buffer.resize((size_t)in.tellg());
+	in.seekg(0);
+	in.read(&buffer[0], buffer.length());
+	if (in.fail()) return false;
+	in.close();
+
+	char msg[256];
+	const char* pos = buffer.data();
+	const char* end = pos + buffer.length();
+	uint32_t version;
+	uint32_t byte_order;
+	int64_t zzb_size;
+	int64_t zzb_time;
+	int64_t zzb_zone;
+	if (buffer.length() < sizeof(ZZB_MAGIC) || memcmp(pos, ZZB_MAGIC, sizeof(ZZB_MAGIC)) != 0) {
+		return false;
+	}
+	pos += sizeof(ZZB_MAGIC);
+	if (!get_int(pos, end, version) || version != ZZB_VERSION ||
+		!get_int(pos, end, byte_order) || byte_order != ZZB_BYTE_ORDER ||
+		!get_int64(pos, end, zzb_size) || !get_int64(pos, end, zzb_time) ||
+		!get_int64(pos, end, zzb_zone)) {
+		return false;
+	}
+	if (zzb_size != log_size || zzb_time != log_time || zzb_zone != zone_stamp()) {
+		snprintf(msg, sizeof(msg), "LOG: %s does not match the log - reading the log", zzb_filename.c_str());
+		status_->misc_status(ST_NOTE, msg);
+		return false;
+	}
+	snprintf(msg, sizeof(msg), "LOG: Started loading snapshot %s", zzb_filename.c_str());
+	status_->misc_status(ST_NOTE, msg);
+
+	bool ok = true;
+	// Header - comment followed by ADIF fields
+	std::string header_text;
+	record* header = nullptr;
+	ok = get_string(pos, end, header_text);
+	if (ok && header_text.length()) {
+		header = new record;
+		size_t lt = header_text.find('<');
+		if (lt == std::string::npos) lt = header_text.length();
+		header->header(header_text.substr(0, lt));
+		const char* h_pos = header_text.data() + lt;
+		const char* h_end = header_text.data() + header_text.length();
+		adi_reader reader;
+		adi_reader::load_result_t result;
+		reader.load_record(header, h_pos, h_end, result);
+		ok = (result == adi_reader::LR_GOOD);
+	}
+	// Pools
+	uint32_t count = 0;
+	ok = ok && get_int(pos, end, count);
+	if (ok) fields_.resize(count);
+	for (uint32_t ix = 0; ok && ix < count; ix++) {
+		ok = get_string(pos, end, fields_[ix]);
+	}
+	// Look each field up once rather than for every record
+	std::vector<field_id_t> field_ids;
+	field_ids.reserve(fields_.size());
+	for (auto& field : fields_) {
+		field_ids.push_back(field_registry::id(field));
+	}
+	ok = ok && get_int(pos, end, count);
+	if (ok) strings_.resize(count);
+	for (uint32_t ix = 0; ok && ix < count; ix++) {
+		ok = get_string(pos, end, strings_[ix]);
+	}
+	// Records
+	std::vector<record*> records;
+	ok = ok && get_int(pos, end, count);
+	if (ok) {
+		records.reserve(count);
+		status_->progress(count, b->book_type(), "Reading snapshot", "records");
+	}
+	for (uint32_t ix = 0; ok && ix < count; ix++) {
+		int64_t timestamp;
+		uint32_t num_items;
+		ok = get_int64(pos, end, timestamp) && get_int(pos, end, num_items);
+		if (!ok) break;
+		record* qso = new record;
+		records.push_back(qso);
+		for (uint32_t item = 0; ok && item < num_items; item++) {
+			uint32_t field;
+			uint32_t value;
+			ok = get_int(pos, end, field) && get_int(pos, end, value) &&
+				field < fields_.size() && value < strings_.size();
+			// The items were written in the record's order
+			if (ok) qso->emplace_hint(qso->end(), field_ids[field], strings_[value]);
+		}
+		qso->timestamp_ = (time_t)timestamp;
+		if (ix % 1000 == 0) status_->progress(ix, b->book_type());
+	}
+	// Worked-before tables
+	auto get_set = [&](auto& values) {
+		uint32_t num_values;
+		if (!get_int(pos, end, num_values)) return false;
+		for (uint32_t ix = 0; ix < num_values; ix++) {
+			uint32_t value;
+			if (!get_int(pos, end, value) || value >= strings_.size()) return false;
+			values.emplace_hint(values.end(), strings_[value]);
+		}
+		return true;
+	};
+	// The string identifiers of a cell - added to the book once the snapshot is known to be complete
+	struct cell_ids_t {
+		uint32_t call;
+		uint32_t category;
+		uint32_t entity;
+		std::vector<uint32_t> values[3];
+	};
+	auto get_ids = [&](std::vector<uint32_t>& values) {
+		uint32_t num_values;
+		if (!get_int(pos, end, num_values)) return false;
+		for (uint32_t ix = 0; ix < num_values; ix++) {
+			uint32_t value;
+			if (!get_int(pos, end, value) || value >= strings_.size()) return false;
+			values.push_back(value);
+		}
+		return true;
+	};
+	auto get_cells = [&](std::vector<cell_ids_t>& cells) {
+		uint32_t num_cells;
+		if (!get_int(pos, end, num_cells)) return false;
+		for (uint32_t ix = 0; ix < num_cells; ix++) {
+			cell_ids_t cell;
+			if (!get_int(pos, end, cell.call) || cell.call >= strings_.size()) return false;
+			if (!get_int(pos, end, cell.category) || cell.category > 0xFF) return false;
+			if (!get_int(pos, end, cell.entity) || cell.entity >= strings_.size()) return false;
+			for (auto& values : cell.values) {
+				if (!get_ids(values)) return false;
+			}
+			cells.push_back(std::move(cell));
+		}
+		return true;
+	};
+	decltype(b->used_bands_) used_bands;
+	decltype(b->used_modes_) used_modes;
+	decltype(b->used_submodes_) used_submodes;
+	decltype(b->used_rigs_) used_rigs;
+	decltype(b->used_antennas_) used_antennas;
+	decltype(b->used_callsigns_) used_callsigns;
+	std::vector<cell_ids_t> cells;
+	ok = ok && get_set(used_bands) && get_set(used_modes) && get_set(used_submodes) &&
+		get_set(used_rigs) && get_set(used_antennas) && get_set(used_callsigns) &&
+		get_cells(cells);
+	uint32_t trailer = 0;
+	ok = ok && get_int(pos, end, trailer) && trailer == ZZB_END && pos == end;
+	if (!ok) {
+		// Nothing has been added to the book yet
+		for (auto qso : records) delete qso;
+		delete header;
+		snprintf(msg, sizeof(msg), "LOG: %s is not complete - reading the log", zzb_filename.c_str());
+		status_->misc_status(ST_WARNING, msg);
+		status_->progress("Load failed", b->book_type());
+		return false;
+	}
+	// Add the data to the book
+	if (header) b->header(header);
+	b->insert(b->end(), records.begin(), records.end());
+	b->used_bands_.swap(used_bands);
+	b->used_modes_.swap(used_modes);
+	b->used_submodes_.swap(used_submodes);
+	b->used_rigs_.swap(used_rigs);
+	b->used_antennas_.swap(used_antennas);
+	b->used_callsigns_.swap(used_callsigns);
+	uint32_t none = b->use_id(b->use_value_ids_, b->use_values_, "");
+	for (auto& cell : cells) {
+		auto& use = b->use_cell((worked_t)cell.category, strings_[cell.entity], strings_[cell.call]);
+		for (auto value : cell.values[0]) b->add_use(use, b->use_id(b->use_value_ids_, b->use_values_, strings_[value]), none, none);
+		for (auto value : cell.values[1]) b->add_use(use, none, b->use_id(b->use_value_ids_, b->use_values_, strings_[value]), none);
+		for (auto value : cell.values[2]) b->add_use(use, none, none, b->use_id(b->use_value_ids_, b->use_values_, strings_[value]));
+	}
+	// Log-defined enumerations
+	for (auto& rig : b->used_rigs_) spec_data_->add_user_enum("MY_RIG", rig);
+	for (auto& antenna : b->used_antennas_) spec_data_->add_user_enum("MY_ANTENNA", antenna);
+	for (auto& callsign : b->used_callsigns_) spec_data_->add_user_enum("STATION_CALLSIGN", callsign);
+	// Station details are still learnt from each QSO as add_use_data does
+	for (auto qso : records) {
+		if (qso->item("SWL") == "" &&
+			(qso->item("QSO_COMPLETE") == "" || qso->item("QSO_COMPLETE") == "Y")) {
+			b->deprecate_macros(qso);
+		}
+	}
+	status_->progress(records.size(), b->book_type());
+	return true;
+}